@@ -148,6 +148,9 @@ function(ROCPROFILER_SYSTEMS_STRIP_TARGET)
                     --keep-symbol="rocprofsys_finalize"
                     --keep-symbol="rocprofsys_push_trace"
                     --keep-symbol="rocprofsys_pop_trace"
+                    --keep-symbol="rocprofsys_push_trace_id"
+                    --keep-symbol="rocprofsys_pop_trace_id"
+                    --keep-symbol="rocprofsys_register_trace_ids"
                     --keep-symbol="rocprofsys_push_region"
                     --keep-symbol="rocprofsys_pop_region"
                     --keep-symbol="rocprofsys_set_env" --keep-symbol="rocprofsys_set_mpi"
@@ -0,0 +1,92 @@
+
+#include <rocprofiler-systems/types.h>
+#include <rocprofiler-systems/user.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// compares the per-call cost of the string-based user regions, which hash the name on
+// every push and pop, against regions pushed/popped via a handle from
+// rocprofsys_user_register_region
+
+using clock_type = std::chrono::steady_clock;
+
+namespace
+{
+const char* region_name        = "user-api-overhead-region";
+const char* static_region_name = "user-api-overhead-static-region";
+
+// registered before main, possibly before rocprof-sys is initialized
+const auto static_handle = rocprofsys_user_register_region(static_region_name);
+
+template <typename PushT, typename PopT>
+double
+run(size_t nitr, PushT&& _push, PopT&& _pop)
+{
+    auto _beg = clock_type::now();
+    for(size_t i = 0; i < nitr; ++i)
+    {
+        _push();
+        _pop();
+    }
+    return std::chrono::duration<double, std::nano>{ clock_type::now() - _beg }.count();
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nitr = 100000;
+    if(argc > 1) nitr = atol(argv[1]);
+
+    auto _handle = rocprofsys_user_register_region(region_name);
+    if(_handle == 0)
+    {
+        fprintf(stderr, "[%s] rocprofsys_user_register_region failed\n", _name.c_str());
+        return EXIT_FAILURE;
+    }
+
+    if(rocprofsys_user_register_region(region_name) != _handle)
+    {
+        fprintf(stderr, "[%s] re-registering '%s' returned a different handle\n",
+                _name.c_str(), region_name);
+        return EXIT_FAILURE;
+    }
+
+    // the handle from the static initializer is bound on the first push
+    if(static_handle == 0 ||
+       rocprofsys_user_register_region(static_region_name) != static_handle ||
+       rocprofsys_user_push_region_h(static_handle) != ROCPROFSYS_USER_SUCCESS ||
+       rocprofsys_user_pop_region_h(static_handle) != ROCPROFSYS_USER_SUCCESS)
+    {
+        fprintf(stderr, "[%s] the region '%s' registered before main is not usable\n",
+                _name.c_str(), static_region_name);
+        return EXIT_FAILURE;
+    }
+
+    // warm-up so that both paths see the same (already allocated) storage
+    run(
+        nitr / 10, [] { rocprofsys_user_push_region(region_name); },
+        [] { rocprofsys_user_pop_region(region_name); });
+
+    auto _str_ns = run(
+        nitr, [] { rocprofsys_user_push_region(region_name); },
+        [] { rocprofsys_user_pop_region(region_name); });
+
+    auto _hdl_ns = run(
+        nitr, [_handle] { rocprofsys_user_push_region_h(_handle); },
+        [_handle] { rocprofsys_user_pop_region_h(_handle); });
+
+    printf("[%s] iterations: %zu\n", _name.c_str(), nitr);
+    printf("[%s] string: %.2f nsec/region\n", _name.c_str(), _str_ns / nitr);
+    printf("[%s] handle: %.2f nsec/region\n", _name.c_str(), _hdl_ns / nitr);
+    printf("[%s] speedup: %.2fx\n", _name.c_str(), _str_ns / _hdl_ns);
+
+    return EXIT_SUCCESS;
+}
@@ -32,6 +32,7 @@
 #include <algorithm>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -79,6 +80,18 @@ get_whole_function_names()
     };
 }
 
+//======================================================================================//
+//
+//  Dyninst does not document the thread-safety of the BPatch API so the queries are
+//  serialized when the functions are analyzed concurrently
+//
+std::mutex&
+get_dyninst_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
 //======================================================================================//
 //
 //  Helper functions because the syntax for getting a function or module name is unwieldy
@@ -86,8 +99,10 @@ get_whole_function_names()
 std::string_view
 get_name(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, std::string>{};
+    static auto _v   = std::unordered_map<procedure_t*, std::string>{};
+    static auto _mtx = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mtx };
     auto itr = _v.find(_func);
     if(itr == _v.end())
     {
@@ -100,8 +115,10 @@ get_name(procedure_t* _func)
 std::string_view
 get_name(module_t* _module)
 {
-    static auto _v = std::unordered_map<module_t*, std::string>{};
+    static auto _v   = std::unordered_map<module_t*, std::string>{};
+    static auto _mtx = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mtx };
     auto itr = _v.find(_module);
     if(itr == _v.end())
     {
@@ -125,8 +142,10 @@ get_name(module_t* _module)
 symtab_func_t*
 get_symtab_function(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _v   = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _mtx = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mtx };
     auto itr = _v.find(_func);
     if(itr == _v.end())
     {
@@ -66,6 +66,7 @@
 #include <istream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <regex>
@@ -122,6 +123,9 @@ using object_t               = BPatch_object;
 using local_var_t            = BPatch_localVar;
 using sequence_t             = BPatch_sequence;
 using const_expr_t           = BPatch_constExpr;
+using arith_expr_t           = BPatch_arithExpr;
+using address_expr_t         = BPatch_addressExpr;
+using variable_expr_t        = BPatch_variableExpr;
 using error_level_t          = BPatchErrorLevel;
 using snippet_handle_t       = BPatchSnippetHandle;
 using patch_pointer_t        = std::shared_ptr<patch_t>;
@@ -211,6 +215,10 @@ extern bool simulate;
 extern bool include_uninstr;
 extern bool include_internal_linked_libs;
 //
+//  variable in the instrumented binary which holds the base of its function ids
+//
+extern variable_expr_t* trace_id_base;
+//
 //  string settings
 //
 extern string_t main_fname;
@@ -366,6 +374,9 @@ error_func_real(error_level_t level, int num, const char* const* params);
 void
 error_func_fake(error_level_t level, int num, const char* const* params);
 
+std::mutex&
+get_dyninst_mutex();
+
 std::string_view
 get_name(procedure_t*);
 
@@ -27,8 +27,12 @@
 #include "log.hpp"
 #include "rocprof-sys-instrument.hpp"
 
+#include "dl/dl.hpp"
+
 #include <timemory/utility/join.hpp>
 
+#include <map>
+#include <mutex>
 #include <stdexcept>
 
 module_function::width_t&
@@ -57,6 +61,11 @@ module_function::update_width(const module_function& rhs)
 }
 
 module_function::module_function(module_t* mod, procedure_t* proc)
+: module_function{ mod, proc, std::unique_lock<std::mutex>{ get_dyninst_mutex() } }
+{}
+
+module_function::module_function(module_t* mod, procedure_t* proc,
+                                 std::unique_lock<std::mutex>&&)
 : module{ mod }
 , function{ proc }
 , symtab_function{ proc->isInstrumentable() ? get_symtab_function(proc) : nullptr }
@@ -99,42 +108,44 @@ module_function::module_function(module_t* mod, procedure_t* proc)
             flow_graph->getAllBasicBlocks(basic_blocks);
             flow_graph->getOuterLoops(loop_blocks);
         }
+    }
 
-        instructions.reserve(basic_blocks.size());
-        size_t _n = 0;
-        for(const auto& itr : basic_blocks)
+    // the thread-safety of the instruction decoding of Dyninst is not documented so it
+    // is also performed while the lock is held
+    instructions.reserve(basic_blocks.size());
+    size_t _n = 0;
+    for(const auto& itr : basic_blocks)
+    {
+        std::vector<std::pair<instruction_t, address_t>> _instructions{};
+        try
         {
-            std::vector<std::pair<instruction_t, address_t>> _instructions{};
-            try
+            if(itr->getInstructions(_instructions))
             {
-                if(itr->getInstructions(_instructions))
+                auto _num_instr = _instructions.size();
+                num_instructions += _num_instr;
+                for(auto&& iitr : _instructions)
                 {
-                    auto _num_instr = _instructions.size();
-                    num_instructions += _num_instr;
-                    for(auto&& iitr : _instructions)
-                    {
-                        instruction_types[iitr.first.getCategory()] += 1;
-                    }
-                    // num_instructions += _instructions.size();
-                    if(debug_print || verbose_level > 3 || instr_print)
-                        instructions.emplace_back(std::move(_instructions));
+                    instruction_types[iitr.first.getCategory()] += 1;
                 }
-                else
-                {
-                    // on average, the number of instructions is address range / 4
-                    auto _num_instr = (itr->getEndAddress() - itr->getStartAddress()) / 4;
-                    verbprintf(2,
-                               "No instructions found for basic block %zu in %s. "
-                               "Approximating with %lu...\n",
-                               _n, function_name.c_str(), _num_instr);
-                    num_instructions += _num_instr;
-                }
-            } catch(std::runtime_error& _e)
+                // num_instructions += _instructions.size();
+                if(debug_print || verbose_level > 3 || instr_print)
+                    instructions.emplace_back(std::move(_instructions));
+            }
+            else
             {
-                errprintf(1, "Dyninst error: %s\n", _e.what());
+                // on average, the number of instructions is address range / 4
+                auto _num_instr = (itr->getEndAddress() - itr->getStartAddress()) / 4;
+                verbprintf(2,
+                           "No instructions found for basic block %zu in %s. "
+                           "Approximating with %lu...\n",
+                           _n, function_name.c_str(), _num_instr);
+                num_instructions += _num_instr;
             }
-            ++_n;
+        } catch(std::runtime_error& _e)
+        {
+            errprintf(1, "Dyninst error: %s\n", _e.what());
         }
+        ++_n;
     }
 }
 
@@ -257,6 +268,7 @@ module_function::should_instrument(bool coverage) const
 bool
 module_function::is_instrumentable() const
 {
+    auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
     if(!function->isInstrumentable())
     {
         messages.emplace_back(2, "Skipping", "module", "not-instrumentable", module_name);
@@ -276,6 +288,27 @@ check_regex_restrictions(const std::string& _name, const regexvec_t& _regexes)
         if(std::regex_search(_name, itr)) return true;
     return false;
 }
+
+struct trace_id_data
+{
+    std::map<std::string, uint32_t> ids    = {};
+    std::vector<std::string>        labels = {};
+};
+
+trace_id_data&
+get_trace_id_data()
+{
+    static auto _v = trace_id_data{};
+    return _v;
+}
+
+// the id base of the binary is stored by the runtime when the labels are registered
+snippet_pointer_t
+get_trace_id_expr(uint32_t _idx)
+{
+    return std::make_shared<arith_expr_t>(BPatch_plus, *trace_id_base,
+                                          const_expr_t{ _idx });
+}
 }  // namespace
 
 bool
@@ -389,6 +422,7 @@ module_function::is_user_excluded() const
 bool
 module_function::is_overlapping() const
 {
+    auto            _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
     procedure_vec_t _overlapping{};
     return function->findOverlapping(_overlapping);
 }
@@ -445,22 +479,29 @@ module_function::is_internal_constrained() const
     auto _module_base = _basename(module_name);
     auto _module_real = _realpath(module_name);
 
-    if(std::regex_search(module_name,
-                         std::regex{ "lib(rocprof-sys|rocprofsys|timemory|perfetto)" }))
+    // compiled once: this is evaluated for every function in the binary
+    static const auto lib_regex =
+        std::regex{ "lib(rocprof-sys|rocprofsys|timemory|perfetto)" };
+    static const auto source_regex =
+        std::regex{ ".*/source/lib/"
+                    "(core|common|binary|"
+                    "rocprofsys|rocprofsys-dl|"
+                    "rocprofsys-user)/.*/.*\\.(h|c|cpp|hpp)$" };
+    static const auto rocprofsys_regex =
+        std::regex{ "10rocprofsys|rocprofsys|rocprofsys(::|_)" };
+    static const auto timemory_regex = std::regex{ "3tim|tim::|timemory(::|_)" };
+    static const auto perfetto_regex = std::regex{ "9perfetto|perfetto(::|_)" };
+
+    if(std::regex_search(module_name, lib_regex))
         return _report("Excluding", "module", "rocprofsys", 3);
-    else if(std::regex_match(module_name,
-                             std::regex{ ".*/source/lib/"
-                                         "(core|common|binary|"
-                                         "rocprofsys|rocprofsys-dl|"
-                                         "rocprofsys-user)/.*/.*\\.(h|c|cpp|hpp)$" }))
+    else if(std::regex_match(module_name, source_regex))
         return _report("Excluding", "module", "rocprofsys", 3);
 
-    if(std::regex_search(function_name,
-                         std::regex{ "10rocprofsys|rocprofsys|rocprofsys(::|_)" }))
+    if(std::regex_search(function_name, rocprofsys_regex))
         return _report("Excluding", "function", "rocprofsys", 3);
-    else if(std::regex_search(function_name, std::regex{ "3tim|tim::|timemory(::|_)" }))
+    else if(std::regex_search(function_name, timemory_regex))
         return _report("Excluding", "function", "timemory", 3);
-    else if(std::regex_search(function_name, std::regex{ "9perfetto|perfetto(::|_)" }))
+    else if(std::regex_search(function_name, perfetto_regex))
         return _report("Excluding", "function", "perfetto", 3);
 
     if(_gnu_libs.find(module_name) != _gnu_libs.end() ||
@@ -499,7 +540,12 @@ module_function::is_module_constrained() const
         return true;
     };
 
-    if(module->isSystemLib()) return _report("Excluding", "system library", 3);
+    auto _is_system_lib = [this]() {
+        auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        return module->isSystemLib();
+    };
+
+    if(_is_system_lib()) return _report("Excluding", "system library", 3);
 
     // always instrument these modules
     if(module_name == "DEFAULT_MODULE" || module_name == "LIBRARY_MODULE")
@@ -646,6 +692,7 @@ module_function::is_overlapping_constrained() const
 bool
 module_function::contains_dynamic_callsites() const
 {
+    auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
     if(flow_graph) return flow_graph->containsDynamicCallsites();
 
     return false;
@@ -656,12 +703,19 @@ module_function::contains_user_callsite() const
 {
     if(caller_include.empty()) return false;
 
-    std::vector<BPatch_point*> call_points;
-    function->getCallPoints(call_points);
-    for(const auto& call_point : call_points)
+    auto _called = std::vector<std::string>{};
+    {
+        auto _lk         = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        auto call_points = std::vector<BPatch_point*>{};
+        function->getCallPoints(call_points);
+        _called.reserve(call_points.size());
+        for(const auto& call_point : call_points)
+            _called.emplace_back(get_name(call_point->getCalledFunction()));
+    }
+
+    for(const auto& itr : _called)
     {
-        if(check_regex_restrictions(
-               std::string(get_name(call_point->getCalledFunction())), caller_include))
+        if(check_regex_restrictions(itr, caller_include))
         {
             messages.emplace_back(2, "Forcing", "function", "caller-include-regex",
                                   function_name);
@@ -793,7 +847,10 @@ module_function::can_instrument_entry() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    }
 
     if(_num_points == 0)
     {
@@ -811,7 +868,10 @@ module_function::can_instrument_exit() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    }
 
     if(_num_points == 0)
     {
@@ -831,7 +891,10 @@ module_function::is_entry_trap_constrained() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    }
 
     if(!instr_traps && (_num_points - _num_traps) == 0)
     {
@@ -851,7 +914,10 @@ module_function::is_exit_trap_constrained() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_dyninst_mutex() };
+        std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    }
 
     if((_num_points - _num_traps) == 0)
     {
@@ -865,17 +931,30 @@ module_function::is_exit_trap_constrained() const
 
 std::pair<size_t, size_t>
 module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_trace,
-                            procedure_t* _exit_trace) const
+                            procedure_t* _exit_trace, procedure_t* _entr_trace_id,
+                            procedure_t* _exit_trace_id) const
 {
     std::pair<size_t, size_t> _count = { 0, 0 };
 
     if(!function || !module) return _count;
 
+    const bool _use_ids = (_entr_trace_id && _exit_trace_id && trace_id_base);
+
+    // passes the id of the label when one is available and the label otherwise
+    auto _get_call_expr = [_use_ids](const std::string& _label, procedure_t* _func,
+                                     procedure_t* _func_id) {
+        auto _id = (_use_ids) ? get_trace_id(_label) : std::optional<uint32_t>{};
+        if(_id)
+            return std::make_pair(rocprofsys_call_expr(get_trace_id_expr(*_id)),
+                                  _func_id);
+        return std::make_pair(rocprofsys_call_expr(_label.c_str()), _func);
+    };
+
     auto _name       = signature.get();
-    auto _trace_entr = rocprofsys_call_expr(_name.c_str());
-    auto _trace_exit = rocprofsys_call_expr(_name.c_str());
-    auto _entr       = _trace_entr.get(_entr_trace);
-    auto _exit       = _trace_exit.get(_exit_trace);
+    auto _trace_entr = _get_call_expr(_name, _entr_trace, _entr_trace_id);
+    auto _trace_exit = _get_call_expr(_name, _exit_trace, _exit_trace_id);
+    auto _entr       = _trace_entr.first.get(_trace_entr.second);
+    auto _exit       = _trace_exit.first.get(_trace_exit.second);
 
     if(insert_instr(_addr_space, function, _entr, BPatch_entry) &&
        insert_instr(_addr_space, function, _exit, BPatch_exit))
@@ -923,10 +1002,10 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
                            "loop-exit-point-trap-instrumentation", _lname))
             continue;
 
-        auto _ltrace_entr = rocprofsys_call_expr(_lname.c_str());
-        auto _ltrace_exit = rocprofsys_call_expr(_lname.c_str());
-        auto _lentr       = _ltrace_entr.get(_entr_trace);
-        auto _lexit       = _ltrace_exit.get(_exit_trace);
+        auto _ltrace_entr = _get_call_expr(_lname, _entr_trace, _entr_trace_id);
+        auto _ltrace_exit = _get_call_expr(_lname, _exit_trace, _exit_trace_id);
+        auto _lentr       = _ltrace_entr.first.get(_ltrace_entr.second);
+        auto _lexit       = _ltrace_exit.first.get(_ltrace_exit.second);
 
         if(insert_instr(_addr_space, function, _lentr, BPatch_entry, flow_graph, itr,
                         instr_loop_traps) &&
@@ -942,6 +1021,56 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     return _count;
 }
 
+size_t
+module_function::get_coverage_id(address_t _addr) const
+{
+    static auto _ids = std::map<std::pair<module_t*, address_t>, size_t>{};
+    auto        _key = std::make_pair(module, _addr);
+    auto        itr  = _ids.find(_key);
+    if(itr != _ids.end()) return itr->second;
+    return _ids.emplace(_key, _ids.size()).first->second;
+}
+
+void
+module_function::assign_trace_ids() const
+{
+    if(!function || !module) return;
+
+    auto& _data      = get_trace_id_data();
+    auto  _assign_id = [&_data](const std::string& _name) {
+        if(_data.labels.size() >= rocprofsys::dl::trace_id_index_max) return;
+        if(_data.ids.emplace(_name, _data.labels.size()).second)
+            _data.labels.emplace_back(_name);
+    };
+
+    _assign_id(signature.get());
+
+    if(!loop_level_instr || !flow_graph) return;
+
+    for(size_t i = 0; i < loop_blocks.size(); ++i)
+    {
+        auto* itr = loop_blocks.at(i);
+        auto  lname =
+            get_loop_file_line_info(module, function, flow_graph, itr).set_loop_number(i);
+        _assign_id(lname.get());
+    }
+}
+
+std::optional<uint32_t>
+module_function::get_trace_id(const std::string& _name)
+{
+    const auto& _data = get_trace_id_data();
+    auto        itr   = _data.ids.find(_name);
+    if(itr == _data.ids.end()) return std::nullopt;
+    return itr->second;
+}
+
+const std::vector<std::string>&
+module_function::get_trace_id_labels()
+{
+    return get_trace_id_data().labels;
+}
+
 void
 module_function::register_source(address_space_t* _addr_space, procedure_t* _entr_trace,
                                  const std::vector<point_t*>& _entr_points) const
@@ -950,10 +1079,10 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
     {
         case CODECOV_FUNCTION:
         {
-            auto _name = signature.get_coverage(false);
-            auto _trace_entr =
-                rocprofsys_call_expr(signature.m_file, signature.m_name,
-                                     signature.m_row.first, start_address, _name);
+            auto _name       = signature.get_coverage(false);
+            auto _trace_entr = rocprofsys_call_expr(
+                get_coverage_id(start_address), signature.m_file, signature.m_name,
+                signature.m_row.first, start_address, _name);
             auto _entr = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
@@ -970,9 +1099,9 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
                 auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
                 auto  _name       = _signature.get_coverage(true);
-                auto  _trace_entr =
-                    rocprofsys_call_expr(_signature.m_file, _signature.m_name,
-                                         _signature.m_row.first, _start_addr, _name);
+                auto  _trace_entr = rocprofsys_call_expr(
+                    get_coverage_id(_start_addr), _signature.m_file, _signature.m_name,
+                    _signature.m_row.first, _start_addr, _name);
                 auto _entr = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
@@ -997,7 +1126,7 @@ module_function::register_coverage(address_space_t* _addr_space,
         case CODECOV_FUNCTION:
         {
             auto _trace_entr =
-                rocprofsys_call_expr(signature.m_file, signature.m_name, start_address);
+                rocprofsys_call_expr(get_coverage_id(start_address), start_address);
             auto _entr = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, function, _entr, BPatch_entry))
@@ -1014,8 +1143,8 @@ module_function::register_coverage(address_space_t* _addr_space,
             {
                 auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
-                auto  _trace_entr = rocprofsys_call_expr(_signature.m_file,
-                                                        _signature.m_name, _start_addr);
+                auto  _trace_entr =
+                    rocprofsys_call_expr(get_coverage_id(_start_addr), _start_addr);
                 auto  _entr       = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr, BPatch_entry, itr.first))
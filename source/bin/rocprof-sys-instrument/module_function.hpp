@@ -28,9 +28,13 @@
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/tpls/cereal/cereal/cereal.hpp>
 
+#include <cstdint>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <vector>
 
 struct module_function
 {
@@ -56,10 +60,28 @@ struct module_function
     std::pair<size_t, size_t> register_coverage(address_space_t* _addr_space,
                                                 procedure_t*     _entr_trace) const;
 
-    // instrumentation
+    // dense id of a coverage entry (function or basic block) which is passed to both
+    // the register source and register coverage calls
+    size_t get_coverage_id(address_t _addr) const;
+
+    // assigns the dense ids of the function and loop labels before the instrumentation
+    // so that the labels can be registered by the initialization of the binary
+    void assign_trace_ids() const;
+
+    // dense id of an instrumented function or loop label which is added to the id base
+    // of the binary and passed to the rocprofsys_push_trace_id/rocprofsys_pop_trace_id
+    // calls. No value is returned when the label was not assigned an id
+    static std::optional<uint32_t> get_trace_id(const std::string& _name);
+
+    // the labels in the order of their ids
+    static const std::vector<std::string>& get_trace_id_labels();
+
+    // instrumentation. The entry/exit functions taking an id are used when provided
     std::pair<size_t, size_t> operator()(address_space_t* _addr_space,
                                          procedure_t*     _entr_trace,
-                                         procedure_t*     _exit_trace) const;
+                                         procedure_t*     _exit_trace,
+                                         procedure_t*     _entr_trace_id = nullptr,
+                                         procedure_t*     _exit_trace_id = nullptr) const;
 
     // applies logic for all "is_*" and "can_*" checks below
     bool should_instrument() const;
@@ -116,6 +138,9 @@ struct module_function
     bool is_overlapping() const;  // checks if func overlaps
 
 private:
+    // performs the Dyninst queries and the instruction decoding while the lock is held
+    module_function(module_t* mod, procedure_t* proc, std::unique_lock<std::mutex>&&);
+
     symbol_linkage_t    get_linkage() const;
     symbol_visibility_t get_visibility() const;
     bool is_loop_num_instructions_constrained() const;  // checks loop instr constraint
@@ -27,8 +27,10 @@
 #include "fwd.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
+#include "sample_profile.hpp"
 
 #include <timemory/backends/process.hpp>
+#include <timemory/components/timing/wall_clock.hpp>
 #include <timemory/config.hpp>
 #include <timemory/environment/types.hpp>
 #include <timemory/hash.hpp>
@@ -111,6 +113,7 @@ bool   instr_print                  = false;
 bool   simulate                     = false;
 bool   include_uninstr              = false;
 bool   include_internal_linked_libs = false;
+variable_expr_t* trace_id_base      = nullptr;
 int    verbose_level   = tim::get_env<int>("ROCPROFSYS_VERBOSE_INSTRUMENT", 0);
 int    num_log_entries = tim::get_env<int>(
     "ROCPROFSYS_LOG_COUNT", tim::get_env<bool>("ROCPROFSYS_CI", false) ? 20 : 50);
@@ -164,7 +167,9 @@ bool                                       is_attached          = false;
 bool                                       use_mpi              = false;
 bool                                       is_static_exe        = false;
 bool                                       force_config         = false;
+bool                                       use_trace_ids        = true;
 size_t                                     batch_size           = 50;
+size_t analysis_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
 strset_t                                   extra_libs           = {};
 std::vector<std::pair<uint64_t, string_t>> hash_ids             = {};
 std::map<string_t, bool>                   use_stubs            = {};
@@ -186,6 +191,8 @@ string_t                                   print_available      = {};
 string_t                                   print_overlapping    = {};
 strset_t                                   print_formats        = { "txt", "json" };
 std::string                                modfunc_dump_dir     = {};
+std::string                                profile_file         = {};
+sample_profile::cost_model                 profile_cost         = {};
 auto regex_opts = std::regex_constants::egrep | std::regex_constants::optimize;
 
 std::string
@@ -956,6 +963,49 @@ main(int argc, char** argv)
         .action([](parser_t& p) {
             min_loop_address_range = p.get<size_t>("min-address-range-loop");
         });
+    parser
+        .add_argument({ "--profile" },
+                      "Profile from a previous run (e.g. the *.folded output of "
+                      "rocprof-sys-sample with ROCPROFSYS_SAMPLING_OUTPUT=folded or a "
+                      "table of '<calls> <self-nsec> <function>' lines) used to exclude "
+                      "the functions with the highest estimated instrumentation overhead "
+                      "until the projected overhead is within --profile-overhead")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) { profile_file = p.get<std::string>("profile"); });
+    parser
+        .add_argument({ "--profile-overhead" },
+                      "Instrumentation overhead budget for --profile as a percent of the "
+                      "runtime of the profile")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_cost.budget)
+        .action([](parser_t& p) {
+            profile_cost.budget = p.get<double>("profile-overhead");
+        });
+    parser
+        .add_argument({ "--profile-call-cost" },
+                      "Estimated cost (in nanoseconds) of the instrumentation of one "
+                      "call of a function (entry and exit) for --profile")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_cost.call_cost)
+        .action([](parser_t& p) {
+            profile_cost.call_cost = p.get<double>("profile-call-cost");
+        });
+    parser
+        .add_argument({ "--profile-instruction-cost" },
+                      "Estimated cost (in nanoseconds) of one instruction for --profile. "
+                      "When the profile only provides time, the number of calls of a "
+                      "function without loops is estimated from its self time and its "
+                      "number of instructions")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_cost.instruction_cost)
+        .action([](parser_t& p) {
+            profile_cost.instruction_cost =
+                p.get<double>("profile-instruction-cost");
+        });
     parser
         .add_argument(
             { "--coverage" },
@@ -1005,6 +1055,17 @@ main(int argc, char** argv)
         .dtype("boolean")
         .set_default(instr_loop_traps)
         .action([](parser_t& p) { instr_loop_traps = p.get<bool>("loop-traps"); });
+    parser
+        .add_argument({ "--trace-ids" },
+                      "Pass a dense id of each instrumented function (or loop) to the "
+                      "instrumentation calls instead of its name. The names are "
+                      "registered with a single call by the initialization of the "
+                      "binary and the instrumentation falls back to the names when "
+                      "attaching to a running process")
+        .max_count(1)
+        .dtype("boolean")
+        .set_default(use_trace_ids)
+        .action([](parser_t& p) { use_trace_ids = p.get<bool>("trace-ids"); });
     parser
         .add_argument(
             { "--allow-overlapping" },
@@ -1041,6 +1102,18 @@ main(int argc, char** argv)
         .count(1)
         .dtype("int")
         .action([](parser_t& p) { batch_size = p.get<size_t>("batch-size"); });
+    parser
+        .add_argument({ "-j", "--analysis-threads" },
+                      "Number of threads used to analyze and filter the functions in the "
+                      "instrumentation target. Queries to Dyninst, including the "
+                      "instruction decoding, are serialized but the constraint checks run "
+                      "concurrently. Use 1 for serial analysis")
+        .count(1)
+        .dtype("int")
+        .set_default(analysis_threads)
+        .action([](parser_t& p) {
+            analysis_threads = std::max<size_t>(p.get<size_t>("analysis-threads"), 1);
+        });
     parser.add_argument({ "--dyninst-rt" }, "Path(s) to the dyninstAPI_RT library")
         .dtype("filepath")
         .min_count(1)
@@ -1496,6 +1569,11 @@ main(int argc, char** argv)
         }
     };
 
+    // the candidates are collected serially and analyzed concurrently afterwards
+    auto _candidates = std::set<std::pair<module_t*, procedure_t*>>{};
+    auto _analyze_wc = tim::component::wall_clock{};
+    _analyze_wc.start();
+
     if(app_functions && !app_functions->empty())
     {
         for(auto* itr : *app_functions)
@@ -1511,13 +1589,7 @@ main(int argc, char** argv)
         for(auto* itr : functions)
         {
             if(itr->isInstrumentable() || (simulate && include_uninstr))
-            {
-                module_t* mod    = itr->getModule();
-                auto      _modfn = module_function{ mod, itr };
-                module_names.insert(_modfn.module_name);
-                _insert_module_function(available_module_functions, _modfn);
-                _add_overlapping(mod, itr);
-            }
+                _candidates.emplace(itr->getModule(), itr);
         }
     }
     else
@@ -1547,10 +1619,7 @@ main(int argc, char** argv)
                     if(!pitr->isInstrumentable() && !simulate && !include_uninstr)
                         continue;
                     functions.emplace(pitr);
-                    auto _modfn = module_function{ itr, pitr };
-                    module_names.insert(_modfn.module_name);
-                    _insert_module_function(available_module_functions, _modfn);
-                    _add_overlapping(itr, pitr);
+                    _candidates.emplace(itr, pitr);
                 }
             }
         }
@@ -1560,6 +1629,29 @@ main(int argc, char** argv)
         verbprintf(0, "Warning! No modules in application...\n");
     }
 
+    {
+        using candidate_t = std::pair<module_t*, procedure_t*>;
+
+        auto _pairs  = std::vector<candidate_t>{ _candidates.begin(), _candidates.end() };
+        auto _modfns = std::vector<std::optional<module_function>>(_pairs.size());
+        parallel_for(_pairs.size(), analysis_threads, [&_pairs, &_modfns](size_t i) {
+            _modfns.at(i).emplace(_pairs.at(i).first, _pairs.at(i).second);
+        });
+
+        for(size_t i = 0; i < _pairs.size(); ++i)
+        {
+            module_names.insert(_modfns.at(i)->module_name);
+            _insert_module_function(available_module_functions, *_modfns.at(i));
+            _add_overlapping(_pairs.at(i).first, _pairs.at(i).second);
+        }
+    }
+
+    _analyze_wc.stop();
+    verbprintf(0,
+               "[analysis] analyzing %zu functions required %.3f %s using %zu threads\n",
+               _candidates.size(), _analyze_wc.get(), _analyze_wc.display_unit().c_str(),
+               analysis_threads);
+
     verbprintf(1, "\n");
     verbprintf(1, "Found %zu functions in %zu modules in instrumentation target\n",
                functions.size(), modules.size());
@@ -1726,8 +1818,11 @@ main(int argc, char** argv)
     auto* mpi_func       = find_function(app_image, "rocprofsys_set_mpi");
     auto* entr_trace     = find_function(app_image, "rocprofsys_push_trace");
     auto* exit_trace     = find_function(app_image, "rocprofsys_pop_trace");
-    auto* reg_src_func   = find_function(app_image, "rocprofsys_register_source");
-    auto* reg_cov_func   = find_function(app_image, "rocprofsys_register_coverage");
+    auto* entr_trace_id  = find_function(app_image, "rocprofsys_push_trace_id");
+    auto* exit_trace_id  = find_function(app_image, "rocprofsys_pop_trace_id");
+    auto* reg_trace_id   = find_function(app_image, "rocprofsys_register_trace_ids");
+    auto* reg_src_func   = find_function(app_image, "rocprofsys_register_source_id");
+    auto* reg_cov_func   = find_function(app_image, "rocprofsys_register_coverage_id");
     auto* set_instr_func = find_function(app_image, "rocprofsys_set_instrumented");
 
     if(!main_func && main_fname == "main") main_func = find_function(app_image, "_main");
@@ -1851,8 +1946,8 @@ main(int argc, char** argv)
                             pair_t{ fini_func, "rocprofsys_finalize" },
                             pair_t{ env_func, "rocprofsys_set_env" },
                             pair_t{ set_instr_func, "rocprofsys_set_instrumented" },
-                            pair_t{ reg_src_func, "rocprofsys_register_source" },
-                            pair_t{ reg_cov_func, "rocprofsys_register_coverage" } })
+                            pair_t{ reg_src_func, "rocprofsys_register_source_id" },
+                            pair_t{ reg_cov_func, "rocprofsys_register_coverage_id" } })
     {
         if(!itr.first)
         {
@@ -1879,6 +1974,45 @@ main(int argc, char** argv)
         verbprintf(2, "Done\n");
     }
 
+    // the function ids are registered by the initialization sequence so they can only
+    // be used when the binary has not started yet
+    if(use_trace_ids &&
+       (!entr_trace_id || !exit_trace_id || !reg_trace_id || is_attached ||
+        (!binary_rewrite && (!main_entr_points || main_entr_points->empty()))))
+    {
+        verbprintf(1, "Function ids are not available. Passing the function names to "
+                      "the instrumentation...\n");
+        use_trace_ids = false;
+    }
+
+    // the runtime assigns the upper bits of the ids of each binary when the names are
+    // registered and stores them in this variable so the ids of different binaries do
+    // not collide. The ids of calls before the registration have no upper bits and
+    // are ignored by the runtime
+    if(use_trace_ids)
+    {
+        auto* _type = app_image->findType("unsigned int");
+        if(!_type) _type = app_image->findType("int");
+        if(_type) trace_id_base = addr_space->malloc(*_type, "rocprofsys_trace_id_base");
+        if(trace_id_base)
+        {
+            uint32_t _zero = 0;
+            trace_id_base->writeValue(&_zero);
+        }
+        else
+        {
+            verbprintf(1, "Function id base could not be allocated. Passing the function "
+                          "names to the instrumentation...\n");
+            use_trace_ids = false;
+        }
+    }
+
+    if(!use_trace_ids)
+    {
+        entr_trace_id = nullptr;
+        exit_trace_id = nullptr;
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Create the call arguments for the initialization and finalization routines
@@ -2015,9 +2149,37 @@ main(int argc, char** argv)
 
     if(instr_mode != "sampling")
     {
+        // the constraints of each function are evaluated concurrently (each function only
+        // modifies its own messages) and the results are sorted serially
+        struct filter_result
+        {
+            bool instrument  = false;
+            bool coverage    = false;
+            bool overlapping = false;
+        };
+
+        auto _filter_wc = tim::component::wall_clock{};
+        _filter_wc.start();
+
+        auto _modfns = std::vector<const module_function*>{};
+        _modfns.reserve(available_module_functions.size());
         for(const auto& itr : available_module_functions)
+            _modfns.emplace_back(&itr);
+
+        auto _results = std::vector<filter_result>(_modfns.size());
+        parallel_for(_modfns.size(), analysis_threads, [&_modfns, &_results](size_t i) {
+            const auto* itr = _modfns.at(i);
+            auto&       _v  = _results.at(i);
+            _v.instrument   = itr->should_instrument();
+            _v.coverage =
+                (coverage_mode != CODECOV_NONE) && itr->should_coverage_instrument();
+            _v.overlapping = itr->is_overlapping();
+        });
+
+        for(size_t i = 0; i < _modfns.size(); ++i)
         {
-            if(itr.should_instrument())
+            const auto& itr = *_modfns.at(i);
+            if(_results.at(i).instrument)
             {
                 _insert_module_function(instrumented_module_functions, itr);
             }
@@ -2025,13 +2187,34 @@ main(int argc, char** argv)
             {
                 _insert_module_function(excluded_module_functions, itr);
             }
-            if(coverage_mode != CODECOV_NONE)
+            if(_results.at(i).coverage)
+                _insert_module_function(coverage_module_functions, itr);
+            if(_results.at(i).overlapping)
+                _insert_module_function(overlapping_module_functions, itr);
+        }
+
+        _filter_wc.stop();
+        verbprintf(0,
+                   "[analysis] filtering %zu functions required %.3f %s using %zu "
+                   "threads\n",
+                   _modfns.size(), _filter_wc.get(), _filter_wc.display_unit().c_str(),
+                   analysis_threads);
+
+        if(!profile_file.empty())
+        {
+            if(fixed_module_functions.at(&instrumented_module_functions) ||
+               fixed_module_functions.at(&excluded_module_functions))
             {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
+                verbprintf(0, "[profile] Ignoring '%s' because the instrumented and/or "
+                              "excluded functions were loaded via --load-instr...\n",
+                           profile_file.c_str());
+            }
+            else
+            {
+                sample_profile::read(profile_file)
+                    .apply(profile_cost, instrumented_module_functions,
+                           excluded_module_functions);
             }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
         }
     }
     else
@@ -2061,6 +2244,35 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
+    // the function ids are assigned before the instrumentation so that the names are
+    // registered with a single call at the start of the initialization sequence
+    auto _trace_id_names = std::string{};
+    auto _reg_trace_ids  = call_expr_pointer_t{};
+    if(use_trace_ids && instr_mode != "coverage")
+    {
+        for(const auto& itr : instrumented_module_functions)
+        {
+            if(itr.function != main_func) itr.assign_trace_ids();
+        }
+
+        const auto& _labels = module_function::get_trace_id_labels();
+        for(const auto& itr : _labels)
+            _trace_id_names.append(itr).append("\n");
+
+        auto _count = static_cast<uint32_t>(_labels.size());
+        auto _args  = rocprofsys_call_expr(
+            snippet_pointer_t{ std::make_shared<address_expr_t>(*trace_id_base) }, _count,
+            _trace_id_names.c_str());
+        if(_count > 0) _reg_trace_ids = _args.get(reg_trace_id);
+        if(_reg_trace_ids)
+        {
+            auto _pos = init_names.begin() + ((binary_rewrite) ? 1 : 0);
+            init_names.emplace(_pos, _reg_trace_ids.get());
+            verbprintf(1, "Registering %u function ids in the initialization...\n",
+                       _count);
+        }
+    }
+
     auto _objs = std::vector<object_t*>{};
     addr_space->getImage()->getObjects(_objs);
     auto _init_sequence = sequence_t{ init_names };
@@ -2144,6 +2356,10 @@ main(int argc, char** argv)
     //  Actually insert the instrumentation into the procedures
     //
     //----------------------------------------------------------------------------------//
+    // inserting the snippets modifies the address space so this phase remains serial
+    auto _instr_wc = tim::component::wall_clock{};
+    _instr_wc.start();
+
     if(app_thread)
     {
         verbprintf(2, "Beginning insertion set...\n");
@@ -2173,7 +2389,8 @@ main(int argc, char** argv)
         for(const auto& itr : instrumented_module_functions)
         {
             if(itr.function == main_func) continue;
-            auto _count = itr(addr_space, entr_trace, exit_trace);
+            auto _count =
+                itr(addr_space, entr_trace, exit_trace, entr_trace_id, exit_trace_id);
             _pass_info[itr.module_name].first += _count.first;
             _pass_info[itr.module_name].second += _count.second;
 
@@ -2256,22 +2473,25 @@ main(int argc, char** argv)
             verbprintf(
                 1,
                 "Using insertion set failed. Restarting with individual insertion...\n");
-            auto _execute_batch = [&addr_space, &entr_trace, &exit_trace](size_t _beg,
-                                                                          size_t _end) {
+            auto _execute_batch = [&addr_space, &entr_trace, &exit_trace,
+                                   &entr_trace_id, &exit_trace_id](size_t _beg,
+                                                                   size_t _end) {
                 verbprintf(1, "Instrumenting batch of functions [%lu, %lu)\n",
                            (unsigned long) _beg, (unsigned long) _end);
                 addr_space->beginInsertionSet();
                 auto itr = instrumented_module_functions.begin();
                 std::advance(itr, _beg);
                 for(size_t i = _beg; i < _end; ++i, ++itr)
-                    (*itr)(addr_space, entr_trace, exit_trace);
+                    (*itr)(addr_space, entr_trace, exit_trace, entr_trace_id,
+                           exit_trace_id);
                 bool _modified = true;
                 bool _success  = addr_space->finalizeInsertionSet(true, &_modified);
                 return _success;
             };
 
             auto execute_batch = [&_execute_batch, &addr_space, &entr_trace,
-                                  &exit_trace](size_t _beg) {
+                                  &exit_trace, &entr_trace_id,
+                                  &exit_trace_id](size_t _beg) {
                 if(!_execute_batch(_beg, _beg + batch_size))
                 {
                     verbprintf(1,
@@ -2283,7 +2503,8 @@ main(int argc, char** argv)
                     std::advance(itr, _beg);
                     for(size_t i = _beg; i < _beg + batch_size && itr != _end; ++i, ++itr)
                     {
-                        (*itr)(addr_space, entr_trace, exit_trace);
+                        (*itr)(addr_space, entr_trace, exit_trace, entr_trace_id,
+                               exit_trace_id);
                     }
                 }
                 return _beg + batch_size;
@@ -2297,6 +2518,10 @@ main(int argc, char** argv)
         }
     }
 
+    _instr_wc.stop();
+    verbprintf(0, "[instrument] inserting the instrumentation required %.3f %s\n",
+               _instr_wc.get(), _instr_wc.display_unit().c_str());
+
     //----------------------------------------------------------------------------------//
     //
     //  Dump the available instrumented modules/functions (re-dump available)
@@ -31,11 +31,17 @@
 #include <timemory/utility/filepath.hpp>
 #include <timemory/utility/join.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <dlfcn.h>
+#include <exception>
 #include <ios>
+#include <mutex>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 //======================================================================================//
 
@@ -72,6 +78,14 @@ get_snippet(const Tp& arg)
 //
 //======================================================================================//
 //
+inline snippet_pointer_t
+get_snippet(snippet_pointer_t arg)
+{
+    return arg;
+}
+//
+//======================================================================================//
+//
 template <typename... Args>
 snippet_pointer_vec_t
 get_snippets(Args&&... args)
@@ -82,6 +96,53 @@ get_snippets(Args&&... args)
 }
 //
 //======================================================================================//
+// parallel_for -- invokes func(i) for i in [0, n) on up to nthreads threads. The
+// first exception thrown stops the remaining work and is rethrown to the caller
+//
+template <typename FuncT>
+void
+parallel_for(size_t n, size_t nthreads, FuncT&& func)
+{
+    nthreads = std::max<size_t>(std::min<size_t>(nthreads, n), 1);
+
+    if(nthreads == 1)
+    {
+        for(size_t i = 0; i < n; ++i)
+            func(i);
+        return;
+    }
+
+    auto _idx     = std::atomic<size_t>{ 0 };
+    auto _mtx     = std::mutex{};
+    auto _except  = std::exception_ptr{};
+    auto _threads = std::vector<std::thread>{};
+    auto _worker  = [&]() {
+        for(size_t i = _idx++; i < n; i = _idx++)
+        {
+            try
+            {
+                func(i);
+            } catch(...)
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _mtx };
+                if(!_except) _except = std::current_exception();
+                _idx = n;
+            }
+        }
+    };
+
+    _threads.reserve(nthreads - 1);
+    for(size_t i = 1; i < nthreads; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(_except) std::rethrow_exception(_except);
+}
+//
+//======================================================================================//
 //
 struct rocprofsys_call_expr
 {
@@ -0,0 +1,262 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sample_profile.hpp"
+#include "fwd.hpp"
+#include "log.hpp"
+#include "module_function.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::string_view
+trim(std::string_view _v)
+{
+    constexpr auto _ws = " \t\r\n";
+    auto           _beg = _v.find_first_not_of(_ws);
+    if(_beg == std::string_view::npos) return std::string_view{};
+    return _v.substr(_beg, _v.find_last_not_of(_ws) - _beg + 1);
+}
+
+// the unwinder and dyninst do not agree on whether the demangled name contains the
+// parameters so the lookup falls back to the name up to the parameter list
+std::string_view
+get_basename(std::string_view _v)
+{
+    constexpr auto _call_op = std::string_view{ "operator()" };
+
+    auto _off = _v.find(_call_op);
+    _off      = (_off == std::string_view::npos) ? 0 : _off + _call_op.size();
+    auto _pos = _v.find('(', _off);
+    return (_pos == std::string_view::npos) ? _v : trim(_v.substr(0, _pos));
+}
+
+bool
+parse_uint(std::string_view _v, uint64_t& _value)
+{
+    auto _str = std::string{ trim(_v) };
+    if(_str.empty() || _str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    errno  = 0;
+    _value = std::strtoull(_str.c_str(), nullptr, 10);
+    return errno == 0;
+}
+
+// for functions without loops a call executes approximately as many instructions as
+// the function contains so the self time bounds the number of calls. Functions with
+// loops do an unknown amount of work per call and are only estimated when the
+// profile provides the number of calls
+double
+estimate_calls(const module_function& _func, const sample_profile::entry& _entry,
+               const sample_profile::cost_model& _model)
+{
+    if(_entry.calls > 0) return _entry.calls;
+    if(!_func.loop_blocks.empty() || _model.instruction_cost <= 0.0) return 0.0;
+
+    auto _ninstr = std::max<uint64_t>(_func.num_instructions, 1);
+    return _entry.nsec / (_ninstr * _model.instruction_cost);
+}
+}  // namespace
+
+sample_profile
+sample_profile::read(const std::string& _fname)
+{
+    auto _ifs = std::ifstream{ _fname };
+    if(!_ifs)
+    {
+        errprintf(-1, "profile '%s' could not be opened\n", _fname.c_str());
+    }
+
+    constexpr auto _folded_ext = std::string_view{ ".folded" };
+
+    auto _data      = sample_profile{};
+    auto _folded    = (_fname.length() >= _folded_ext.length() &&
+                    _fname.compare(_fname.length() - _folded_ext.length(),
+                                   _folded_ext.length(), _folded_ext) == 0);
+    auto _line      = std::string{};
+    auto _lineno    = size_t{ 0 };
+    auto _malformed = size_t{ 0 };
+
+    auto _add = [&_data](std::string_view _name, uint64_t _calls, uint64_t _nsec) {
+        for(auto& itr : { std::make_pair(&_data.entries, _name),
+                          std::make_pair(&_data.basenames, get_basename(_name)) })
+        {
+            auto& _entry = (*itr.first)[std::string{ itr.second }];
+            _entry.calls += _calls;
+            _entry.nsec += _nsec;
+        }
+        _data.total_nsec += _nsec;
+    };
+
+    while(std::getline(_ifs, _line))
+    {
+        ++_lineno;
+        auto _v = trim(_line);
+        if(_v.empty() || _v.front() == '#') continue;
+
+        auto _calls = uint64_t{ 0 };
+        auto _nsec  = uint64_t{ 0 };
+        if(_folded)
+        {
+            // "outer;...;leaf <nsec>": the time of the line is the self time of the leaf
+            auto _pos = _v.find_last_of(' ');
+            if(_pos != std::string_view::npos && parse_uint(_v.substr(_pos + 1), _nsec))
+            {
+                auto _stack = trim(_v.substr(0, _pos));
+                auto _leaf  = _stack.find_last_of(';');
+                _add((_leaf == std::string_view::npos) ? _stack
+                                                       : _stack.substr(_leaf + 1),
+                     0, _nsec);
+                continue;
+            }
+        }
+        else
+        {
+            // "<calls> <nsec> <name>"
+            auto _first  = _v.find_first_of(" \t");
+            auto _second = _v.find_first_not_of(" \t", _first);
+            if(_second != std::string_view::npos)
+                _second = _v.find_first_of(" \t", _second);
+            if(_second != std::string_view::npos &&
+               parse_uint(_v.substr(0, _first), _calls) &&
+               parse_uint(_v.substr(_first, _second - _first), _nsec))
+            {
+                _add(trim(_v.substr(_second)), _calls, _nsec);
+                continue;
+            }
+        }
+
+        ++_malformed;
+        verbprintf(2, "[profile] %s:%zu :: skipping malformed line\n", _fname.c_str(),
+                   _lineno);
+    }
+
+    if(_data.entries.empty() || _data.total_nsec == 0)
+    {
+        errprintf(-1, "profile '%s' does not contain any entries\n", _fname.c_str());
+    }
+
+    if(_malformed > 0)
+    {
+        errprintf(0, "profile '%s' contained %zu malformed lines\n", _fname.c_str(),
+                  _malformed);
+    }
+
+    verbprintf(1, "[profile] Read %zu symbols (%.3f sec) from '%s'...\n",
+               _data.entries.size(), _data.total_nsec / 1.0e9, _fname.c_str());
+
+    _data.filename = _fname;
+    return _data;
+}
+
+const sample_profile::entry*
+sample_profile::find(std::string_view _name) const
+{
+    if(auto itr = entries.find(std::string{ _name }); itr != entries.end())
+        return &itr->second;
+    if(auto itr = basenames.find(std::string{ get_basename(_name) });
+       itr != basenames.end())
+        return &itr->second;
+    return nullptr;
+}
+
+double
+sample_profile::apply(const cost_model& _model, fmodset_t& _instrumented,
+                      fmodset_t& _excluded) const
+{
+    struct candidate
+    {
+        const module_function* function = nullptr;
+        double                 calls    = 0.0;
+        double                 overhead = 0.0;
+    };
+
+    auto _candidates = std::vector<candidate>{};
+    auto _total      = 0.0;
+    for(const auto& itr : _instrumented)
+    {
+        const auto* _entry = find(itr.function_name);
+        if(!_entry) continue;
+
+        auto _calls    = estimate_calls(itr, *_entry, _model);
+        auto _overhead = _calls * _model.call_cost;
+        if(_overhead <= 0.0) continue;
+
+        _total += _overhead;
+        // functions the user explicitly asked for are kept regardless of the cost
+        if(itr.is_user_included()) continue;
+        _candidates.emplace_back(candidate{ &itr, _calls, _overhead });
+    }
+
+    std::sort(_candidates.begin(), _candidates.end(),
+              [](const candidate& _lhs, const candidate& _rhs) {
+                  return _lhs.overhead > _rhs.overhead;
+              });
+
+    auto _runtime = static_cast<double>(total_nsec);
+    auto _budget  = (_model.budget / 100.0) * _runtime;
+    auto _initial = _total;
+    auto _ninstr  = _instrumented.size();
+    auto _pruned  = std::vector<module_function>{};
+
+    for(const auto& itr : _candidates)
+    {
+        if(_total <= _budget) break;
+        _total -= itr.overhead;
+        verbprintf(2, "[profile] excluding '%s' :: ~%.0f calls, ~%.3f sec overhead\n",
+                   itr.function->function_name.c_str(), itr.calls, itr.overhead / 1.0e9);
+        itr.function->messages.emplace_back(1, "Skipping", "function",
+                                            "profile-overhead",
+                                            itr.function->function_name);
+        _pruned.emplace_back(*itr.function);
+    }
+
+    for(auto& itr : _pruned)
+    {
+        _instrumented.erase(itr);
+        _excluded.emplace(std::move(itr));
+    }
+
+    auto _projected = (_total / _runtime) * 100.0;
+    verbprintf(0,
+               "[profile] Projected instrumentation overhead: %.2f%% (%.2f%% before "
+               "excluding %zu of %zu functions, budget: %.2f%%)\n",
+               _projected, (_initial / _runtime) * 100.0, _pruned.size(), _ninstr,
+               _model.budget);
+
+    if(_total > _budget)
+    {
+        errprintf(0,
+                  "projected instrumentation overhead (%.2f%%) exceeds the budget "
+                  "(%.2f%%) due to explicitly included functions\n",
+                  _projected, _model.budget);
+    }
+
+    return _projected;
+}
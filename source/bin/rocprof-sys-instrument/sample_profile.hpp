@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// per-symbol data of a profile from a previous run (e.g. the folded stacks written by
+// rocprof-sys-sample) which is used to estimate the overhead of instrumenting each
+// function
+struct sample_profile
+{
+    struct entry
+    {
+        uint64_t calls = 0;  // zero when the profile only provides time
+        uint64_t nsec  = 0;  // self time
+    };
+
+    // the settings of the overhead estimate
+    struct cost_model
+    {
+        double budget           = 5.0;    // max overhead as percent of the runtime
+        double call_cost        = 250.0;  // nsec per instrumented call (entry + exit)
+        double instruction_cost = 0.5;    // nsec per executed instruction
+    };
+
+    // reads a folded stack profile (*.folded) or a table of "<calls> <nsec> <name>"
+    // lines. Throws when the file cannot be read or contains no entries
+    static sample_profile read(const std::string& _fname);
+
+    // matches the demangled name and falls back to the name without the parameters
+    const entry* find(std::string_view _name) const;
+
+    // moves the functions from the instrumented set into the excluded set, starting
+    // with the highest estimated overhead, until the projected overhead is within
+    // the budget. Returns the projected overhead as percent of the runtime
+    double apply(const cost_model& _model, fmodset_t& _instrumented,
+                 fmodset_t& _excluded) const;
+
+    bool empty() const { return entries.empty(); }
+
+    std::string                            filename   = {};
+    uint64_t                               total_nsec = 0;
+    std::unordered_map<std::string, entry> entries    = {};
+    std::unordered_map<std::string, entry> basenames  = {};
+};
@@ -24,8 +24,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace rocprofsys
 {
@@ -57,6 +59,7 @@ address_multirange::operator+=(uintptr_t _v)
     //    if(itr.contains(_v)) return *this;
 
     m_fine_ranges.emplace(address_range{ _v });
+    m_frozen = false;
     return *this;
 }
 
@@ -69,6 +72,47 @@ address_multirange::operator+=(address_range _v)
     //    if(itr.contains(_v)) return *this;
 
     m_fine_ranges.emplace(_v);
+    m_frozen = false;
+    return *this;
+}
+
+address_multirange&
+address_multirange::freeze()
+{
+    // convert to half-open [low, high) intervals, single addresses become [low, low+1)
+    auto _ranges = std::vector<std::pair<uintptr_t, uintptr_t>>{};
+    _ranges.reserve(m_fine_ranges.size());
+    for(auto itr : m_fine_ranges)
+    {
+        if(itr.high < itr.low || itr.low == std::numeric_limits<uintptr_t>::max())
+            continue;
+        _ranges.emplace_back(itr.low, (itr.is_range()) ? itr.high : (itr.low + 1));
+    }
+
+    std::sort(_ranges.begin(), _ranges.end());
+
+    m_lows.clear();
+    m_highs.clear();
+    m_lows.reserve(_ranges.size());
+    m_highs.reserve(_ranges.size());
+
+    // coalesce overlapping and adjacent intervals
+    for(auto itr : _ranges)
+    {
+        if(!m_lows.empty() && itr.first <= m_highs.back())
+        {
+            m_highs.back() = std::max(m_highs.back(), itr.second);
+        }
+        else
+        {
+            m_lows.emplace_back(itr.first);
+            m_highs.emplace_back(itr.second);
+        }
+    }
+
+    m_lows.shrink_to_fit();
+    m_highs.shrink_to_fit();
+    m_frozen = true;
     return *this;
 }
 }  // namespace binary
@@ -27,8 +27,12 @@
 
 #include <timemory/utility/macros.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <set>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace rocprofsys
 {
@@ -49,17 +53,48 @@ struct address_multirange
     template <typename Tp>
     bool contains(Tp&& _v) const;
 
+    // builds sorted, coalesced arrays of the fine ranges which are binary searched
+    // by contains(...). Must be called before any concurrent lookups and adding
+    // a range afterwards reverts to the (slower) set-based lookup
+    address_multirange& freeze();
+
     auto size() const { return m_fine_ranges.size(); }
     auto empty() const { return m_fine_ranges.empty(); }
     auto range_size() const { return m_coarse_range.size(); }
     auto get_coarse_range() const { return m_coarse_range; }
     auto get_ranges() const { return m_fine_ranges; }
+    auto is_frozen() const { return m_frozen; }
 
 private:
+    bool contains_frozen(uintptr_t _low, uintptr_t _high) const;
+
+    bool                    m_frozen       = false;
     address_range           m_coarse_range = {};
     std::set<address_range> m_fine_ranges  = {};
+    std::vector<uintptr_t>  m_lows         = {};
+    std::vector<uintptr_t>  m_highs        = {};
 };
 
+// [_low, _high) is contained if it is within the coalesced range with the
+// greatest low <= _low. The search is branchless so that the signal handlers
+// in causal mode do not suffer from branch mispredictions
+ROCPROFSYS_INLINE bool
+address_multirange::contains_frozen(uintptr_t _low, uintptr_t _high) const
+{
+    const auto* _base = m_lows.data();
+    auto        _n    = m_lows.size();
+    if(_n == 0 || _low < _base[0]) return false;
+
+    while(_n > 1)
+    {
+        auto _half = _n / 2;
+        _base      = (_base[_half] <= _low) ? (_base + _half) : _base;
+        _n -= _half;
+    }
+
+    return (_high <= m_highs[_base - m_lows.data()]);
+}
+
 template <typename Tp>
 ROCPROFSYS_INLINE bool
 address_multirange::contains(Tp&& _v) const
@@ -70,6 +105,15 @@ address_multirange::contains(Tp&& _v) const
                   "Error! operator+= supports only integrals or address_ranges");
 
     if(!m_coarse_range.contains(_v)) return false;
+
+    if(m_frozen)
+    {
+        if constexpr(std::is_integral<type>::value)
+            return contains_frozen(_v, _v + 1);
+        else
+            return contains_frozen(_v.low, (_v.is_range()) ? _v.high : (_v.low + 1));
+    }
+
     return std::any_of(m_fine_ranges.begin(), m_fine_ranges.end(),
                        [_v](auto&& itr) { return itr.contains(_v); });
 }
@@ -31,6 +31,7 @@
 #include <bfd.h>
 
 #include "analysis.hpp"
+#include "binary_cache.hpp"
 #include "binary_info.hpp"
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
@@ -53,6 +54,8 @@
 #include <timemory/utility/join.hpp>
 #include <timemory/utility/procfs/maps.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <dlfcn.h>
@@ -71,9 +74,11 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
                 bool _include_all)
 {
     auto _info = binary_info{};
+    auto _beg  = std::chrono::steady_clock::now();
 
     auto& _bfd = _info.bfd;
     _bfd       = std::make_shared<bfd_file>(_name);
+    _info.name = _name;
 
     ROCPROFSYS_BASIC_VERBOSE(0, "[binary] Reading line info for '%s'...\n",
                              _name.c_str());
@@ -116,6 +121,19 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
                 dwarf_entry::process_dwarf(_bfd->fd);
         }
 
+        // sort the DWARF line rows and breakpoints by address once so that each symbol
+        // can binary search for its slice instead of scanning every entry
+        auto _dwarf_cmp = [](const dwarf_entry& _lhs, const dwarf_entry& _rhs) {
+            return _lhs.address.low < _rhs.address.low;
+        };
+
+        if(!std::is_sorted(_info.debug_info.begin(), _info.debug_info.end(), _dwarf_cmp))
+            std::stable_sort(_info.debug_info.begin(), _info.debug_info.end(),
+                             _dwarf_cmp);
+
+        if(!std::is_sorted(_info.breakpoints.begin(), _info.breakpoints.end()))
+            std::sort(_info.breakpoints.begin(), _info.breakpoints.end());
+
         for(auto& itr : _info.symbols)
         {
             itr.read_dwarf_entries(_info.debug_info);
@@ -125,8 +143,10 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
         _info.sort();
     }
 
-    ROCPROFSYS_BASIC_VERBOSE(1, "[binary] Reading line info for '%s'... %zu entries\n",
-                             _bfd->name.c_str(), _info.symbols.size());
+    ROCPROFSYS_BASIC_VERBOSE(
+        1, "[binary] Reading line info for '%s'... %zu entries (%.3f sec)\n",
+        _bfd->name.c_str(), _info.symbols.size(),
+        std::chrono::duration<double>{ std::chrono::steady_clock::now() - _beg }.count());
 
     return _info;
 }
@@ -170,8 +190,20 @@ get_binary_info(const std::vector<std::string>&  _files,
             if(filepath::exists(_filename) && _satisfies_binary_filter(_filename) &&
                _exists.find(_filename) == _exists.end())
             {
-                _data.emplace_back(parse_line_info(_filename, _process_dwarf,
-                                                   _process_bfd, _include_all));
+                auto _cached = load_binary_cache(_filename, _process_dwarf,
+                                                 _process_bfd, _include_all);
+                if(_cached)
+                {
+                    _data.emplace_back(std::move(*_cached));
+                }
+                else
+                {
+                    auto& _info = _data.emplace_back(parse_line_info(
+                        _filename, _process_dwarf, _process_bfd, _include_all));
+                    if(_info.bfd && _info.bfd->is_good())
+                        save_binary_cache(_info, _process_dwarf, _process_bfd,
+                                          _include_all);
+                }
                 _exists.emplace(_filename);
             }
         }
@@ -183,7 +215,7 @@ get_binary_info(const std::vector<std::string>&  _files,
     for(auto& itr : _data)
     {
         for(const auto& mitr : _maps)
-            if(itr.bfd->name == mitr.pathname) itr.mappings.emplace_back(mitr);
+            if(itr.filename() == mitr.pathname) itr.mappings.emplace_back(mitr);
     }
 
     for(auto& itr : _data)
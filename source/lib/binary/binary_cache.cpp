@@ -0,0 +1,623 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "binary_cache.hpp"
+#include "binary_info.hpp"
+#include "core/binary/address_range.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/utility.hpp"
+#include "dwarf_entry.hpp"
+#include "symbol.hpp"
+
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace binary
+{
+namespace
+{
+// "RPSBINC1" in little-endian
+constexpr uint64_t cache_magic   = 0x31434e4942535052;
+constexpr uint32_t cache_version = 1;
+
+enum cache_flags : uint32_t
+{
+    CACHE_PROCESS_DWARF = (1 << 0),
+    CACHE_PROCESS_BFD   = (1 << 1),
+    CACHE_INCLUDE_ALL   = (1 << 2),
+};
+
+// offset (in bytes from the start of the file) and number of records of a segment
+struct cache_segment
+{
+    uint64_t offset = 0;
+    uint64_t count  = 0;
+};
+
+struct cache_header
+{
+    uint64_t      magic              = cache_magic;
+    uint32_t      version            = cache_version;
+    uint32_t      flags              = 0;
+    int64_t       mtime_sec          = 0;
+    int64_t       mtime_nsec         = 0;
+    uint64_t      file_size          = 0;
+    char          build_id[128]      = {};
+    cache_segment strings            = {};
+    cache_segment symbols            = {};
+    cache_segment inlines            = {};
+    cache_segment debug_info         = {};
+    cache_segment symbol_dwarf_info  = {};
+    cache_segment ranges             = {};
+    cache_segment breakpoints        = {};
+    cache_segment symbol_breakpoints = {};
+};
+
+struct cache_range
+{
+    uint64_t low  = 0;
+    uint64_t high = 0;
+};
+
+struct cache_symbol
+{
+    uint64_t      bfd_address  = 0;
+    uint64_t      bfd_symsize  = 0;
+    int64_t       binding      = 0;
+    int64_t       visibility   = 0;
+    uint64_t      name         = 0;
+    uint64_t      func         = 0;
+    uint64_t      file         = 0;
+    uint64_t      load_address = 0;
+    cache_range   address      = {};
+    uint32_t      line         = 0;
+    uint32_t      padding      = 0;
+    cache_segment inlines      = {};
+    cache_segment dwarf_info   = {};
+    cache_segment breakpoints  = {};
+};
+
+struct cache_inlined_symbol
+{
+    uint64_t file    = 0;
+    uint64_t func    = 0;
+    uint32_t line    = 0;
+    uint32_t padding = 0;
+};
+
+struct cache_dwarf_entry
+{
+    cache_range address       = {};
+    uint64_t    file          = 0;
+    uint32_t    line          = 0;
+    int32_t     col           = 0;
+    uint32_t    vliw_op_index = 0;
+    uint32_t    isa           = 0;
+    uint32_t    discriminator = 0;
+    uint32_t    flags         = 0;
+};
+
+static_assert(std::is_trivially_copyable<cache_header>::value, "not POD");
+static_assert(std::is_trivially_copyable<cache_symbol>::value, "not POD");
+static_assert(std::is_trivially_copyable<cache_inlined_symbol>::value, "not POD");
+static_assert(std::is_trivially_copyable<cache_dwarf_entry>::value, "not POD");
+
+struct file_status
+{
+    int64_t  mtime_sec  = 0;
+    int64_t  mtime_nsec = 0;
+    uint64_t size       = 0;
+};
+
+std::optional<file_status>
+get_file_status(const std::string& _filename)
+{
+    struct stat _st = {};
+    if(stat(_filename.c_str(), &_st) != 0) return std::nullopt;
+    return file_status{ static_cast<int64_t>(_st.st_mtim.tv_sec),
+                        static_cast<int64_t>(_st.st_mtim.tv_nsec),
+                        static_cast<uint64_t>(_st.st_size) };
+}
+
+uint32_t
+get_cache_flags(bool _process_dwarf, bool _process_bfd, bool _include_all)
+{
+    return ((_process_dwarf) ? CACHE_PROCESS_DWARF : 0) |
+           ((_process_bfd) ? CACHE_PROCESS_BFD : 0) |
+           ((_include_all) ? CACHE_INCLUDE_ALL : 0);
+}
+
+bool
+use_binary_cache()
+{
+    return config::settings_are_configured() && config::get_use_binary_cache();
+}
+
+// the cache files are never unmapped because the names of the symbols reference the
+// string table in the mapped memory
+auto&
+get_cache_mappings()
+{
+    static auto _v = std::deque<std::pair<void*, size_t>>{};
+    return _v;
+}
+
+std::mutex&
+get_cache_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+// builds a string table of unique, null-terminated strings
+struct string_table
+{
+    uint64_t operator()(const std::string& _v)
+    {
+        auto itr = offsets.find(_v);
+        if(itr != offsets.end()) return itr->second;
+        auto _offset = static_cast<uint64_t>(data.size());
+        data.append(_v);
+        data.push_back('\0');
+        offsets.emplace(_v, _offset);
+        return _offset;
+    }
+
+    std::string                               data    = std::string{ 1, '\0' };
+    std::unordered_map<std::string, uint64_t> offsets = {};
+};
+
+cache_range
+make_cache_range(address_range _v)
+{
+    return cache_range{ _v.low, _v.high };
+}
+
+address_range
+make_address_range(cache_range _v)
+{
+    // avoid the validity check in the address_range constructor since default
+    // constructed (invalid) ranges are cached as-is
+    auto _range = address_range{};
+    _range.low  = _v.low;
+    _range.high = _v.high;
+    return _range;
+}
+
+cache_dwarf_entry
+make_cache_dwarf_entry(const dwarf_entry& _v, string_table& _strings)
+{
+    auto _entry          = cache_dwarf_entry{};
+    _entry.address       = make_cache_range(_v.address);
+    _entry.file          = _strings(_v.file);
+    _entry.line          = _v.line;
+    _entry.col           = _v.col;
+    _entry.vliw_op_index = _v.vliw_op_index;
+    _entry.isa           = _v.isa;
+    _entry.discriminator = _v.discriminator;
+    _entry.flags         = ((_v.begin_statement) ? (1 << 0) : 0) |
+                   ((_v.end_sequence) ? (1 << 1) : 0) | ((_v.line_block) ? (1 << 2) : 0) |
+                   ((_v.prologue_end) ? (1 << 3) : 0) |
+                   ((_v.epilogue_begin) ? (1 << 4) : 0);
+    return _entry;
+}
+
+template <typename Tp>
+void
+write_segment(std::ostream& _os, cache_segment& _segment, const std::vector<Tp>& _data)
+{
+    // align each segment to 8 bytes
+    auto _pos = static_cast<uint64_t>(_os.tellp());
+    while(_pos % 8 != 0)
+    {
+        _os.put('\0');
+        ++_pos;
+    }
+    _segment.offset = _pos;
+    _segment.count  = _data.size();
+    if(!_data.empty())
+        _os.write(reinterpret_cast<const char*>(_data.data()), _data.size() * sizeof(Tp));
+}
+}  // namespace
+
+std::string
+get_build_id(const std::string& _filename)
+{
+    auto _ifs = std::ifstream{ _filename, std::ios::binary | std::ios::in };
+    if(!_ifs) return std::string{};
+
+    auto _ehdr = Elf64_Ehdr{};
+    if(!_ifs.read(reinterpret_cast<char*>(&_ehdr), sizeof(_ehdr))) return std::string{};
+
+    if(memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+       _ehdr.e_ident[EI_CLASS] != ELFCLASS64 || _ehdr.e_shentsize != sizeof(Elf64_Shdr))
+        return std::string{};
+
+    auto _shdrs = std::vector<Elf64_Shdr>(_ehdr.e_shnum);
+    _ifs.seekg(_ehdr.e_shoff);
+    if(!_ifs.read(reinterpret_cast<char*>(_shdrs.data()),
+                  _shdrs.size() * sizeof(Elf64_Shdr)))
+        return std::string{};
+
+    auto _align4 = [](size_t _v) { return (_v + 3) & ~static_cast<size_t>(3); };
+
+    for(const auto& itr : _shdrs)
+    {
+        if(itr.sh_type != SHT_NOTE || itr.sh_size == 0) continue;
+
+        auto _note = std::vector<char>(itr.sh_size);
+        _ifs.seekg(itr.sh_offset);
+        if(!_ifs.read(_note.data(), _note.size())) continue;
+
+        size_t _off = 0;
+        while(_off + sizeof(Elf64_Nhdr) <= _note.size())
+        {
+            auto _nhdr = Elf64_Nhdr{};
+            memcpy(&_nhdr, _note.data() + _off, sizeof(_nhdr));
+            auto _name_off = _off + sizeof(Elf64_Nhdr);
+            auto _desc_off = _name_off + _align4(_nhdr.n_namesz);
+            auto _next_off = _desc_off + _align4(_nhdr.n_descsz);
+            if(_desc_off + _nhdr.n_descsz > _note.size()) break;
+
+            if(_nhdr.n_type == NT_GNU_BUILD_ID && _nhdr.n_namesz == 4 &&
+               memcmp(_note.data() + _name_off, "GNU", 4) == 0)
+            {
+                static const char* _hex = "0123456789abcdef";
+                auto               _ret = std::string{};
+                for(size_t i = 0; i < _nhdr.n_descsz; ++i)
+                {
+                    auto _byte = static_cast<uint8_t>(_note.at(_desc_off + i));
+                    _ret += _hex[(_byte >> 4) & 0xf];
+                    _ret += _hex[_byte & 0xf];
+                }
+                return _ret;
+            }
+            _off = _next_off;
+        }
+    }
+
+    return std::string{};
+}
+
+std::string
+get_binary_cache_filename(const std::string& _filename)
+{
+    auto _build_id = get_build_id(_filename);
+    auto _key      = (_build_id.empty())
+                         ? std::to_string(std::hash<std::string>{}(
+                               filepath::realpath(_filename, nullptr, false)))
+                         : _build_id;
+    return JOIN('/', config::get_binary_cache_dir(),
+                JOIN('-', filepath::basename(_filename), _key) + ".rpsbin");
+}
+
+std::optional<binary_info>
+load_binary_cache(const std::string& _filename, bool _process_dwarf, bool _process_bfd,
+                  bool _include_all)
+{
+    if(!use_binary_cache()) return std::nullopt;
+
+    auto _status = get_file_status(_filename);
+    if(!_status) return std::nullopt;
+
+    auto _build_id   = get_build_id(_filename);
+    auto _cache_name = get_binary_cache_filename(_filename);
+
+    auto _fd = ::open(_cache_name.c_str(), O_RDONLY);
+    if(_fd < 0) return std::nullopt;
+
+    struct stat _st = {};
+    if(fstat(_fd, &_st) != 0 || static_cast<size_t>(_st.st_size) < sizeof(cache_header))
+    {
+        ::close(_fd);
+        return std::nullopt;
+    }
+
+    auto  _size = static_cast<size_t>(_st.st_size);
+    void* _addr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    ::close(_fd);
+
+    if(_addr == MAP_FAILED) return std::nullopt;
+
+    const auto* _data   = static_cast<const char*>(_addr);
+    auto        _header = cache_header{};
+    memcpy(&_header, _data, sizeof(_header));
+
+    auto _invalid = [&](const char* _reason) {
+        ROCPROFSYS_BASIC_VERBOSE(2, "[binary] Ignoring cache '%s' for '%s': %s\n",
+                                 _cache_name.c_str(), _filename.c_str(), _reason);
+        munmap(_addr, _size);
+        return std::nullopt;
+    };
+
+    if(_header.magic != cache_magic || _header.version != cache_version)
+        return _invalid("incompatible format");
+
+    if(_header.flags != get_cache_flags(_process_dwarf, _process_bfd, _include_all))
+        return _invalid("different parsing options");
+
+    _header.build_id[sizeof(_header.build_id) - 1] = '\0';
+    if(_header.mtime_sec != _status->mtime_sec ||
+       _header.mtime_nsec != _status->mtime_nsec || _header.file_size != _status->size ||
+       _build_id != std::string{ _header.build_id })
+        return _invalid("stale");
+
+    auto _in_bounds = [_size](const cache_segment& _seg, size_t _record_size) {
+        return (_seg.offset <= _size &&
+                _seg.count <= (_size - _seg.offset) / _record_size);
+    };
+
+    if(!_in_bounds(_header.strings, sizeof(char)) || _header.strings.count == 0 ||
+       _data[_header.strings.offset + _header.strings.count - 1] != '\0' ||
+       !_in_bounds(_header.symbols, sizeof(cache_symbol)) ||
+       !_in_bounds(_header.inlines, sizeof(cache_inlined_symbol)) ||
+       !_in_bounds(_header.debug_info, sizeof(cache_dwarf_entry)) ||
+       !_in_bounds(_header.symbol_dwarf_info, sizeof(cache_dwarf_entry)) ||
+       !_in_bounds(_header.ranges, sizeof(cache_range)) ||
+       !_in_bounds(_header.breakpoints, sizeof(uint64_t)) ||
+       !_in_bounds(_header.symbol_breakpoints, sizeof(uint64_t)))
+        return _invalid("corrupted");
+
+    auto _get_string = [&](uint64_t _offset) -> const char* {
+        return (_offset < _header.strings.count)
+                   ? (_data + _header.strings.offset + _offset)
+                   : "";
+    };
+
+    auto _get_records = [_data](const cache_segment& _seg, auto _type) {
+        using type = decltype(_type);
+        auto _v    = std::vector<type>(_seg.count);
+        if(_seg.count > 0)
+            memcpy(_v.data(), _data + _seg.offset, _seg.count * sizeof(type));
+        return _v;
+    };
+
+    auto _get_dwarf_entry = [&_get_string](const cache_dwarf_entry& _v) {
+        auto _entry            = dwarf_entry{};
+        _entry.address         = make_address_range(_v.address);
+        _entry.file            = _get_string(_v.file);
+        _entry.line            = _v.line;
+        _entry.col             = _v.col;
+        _entry.vliw_op_index   = _v.vliw_op_index;
+        _entry.isa             = _v.isa;
+        _entry.discriminator   = _v.discriminator;
+        _entry.begin_statement = (_v.flags & (1 << 0)) != 0;
+        _entry.end_sequence    = (_v.flags & (1 << 1)) != 0;
+        _entry.line_block      = (_v.flags & (1 << 2)) != 0;
+        _entry.prologue_end    = (_v.flags & (1 << 3)) != 0;
+        _entry.epilogue_begin  = (_v.flags & (1 << 4)) != 0;
+        return _entry;
+    };
+
+    auto _symbols     = _get_records(_header.symbols, cache_symbol{});
+    auto _inlines     = _get_records(_header.inlines, cache_inlined_symbol{});
+    auto _debug_info  = _get_records(_header.debug_info, cache_dwarf_entry{});
+    auto _sym_dwarf   = _get_records(_header.symbol_dwarf_info, cache_dwarf_entry{});
+    auto _ranges      = _get_records(_header.ranges, cache_range{});
+    auto _breakpoints = _get_records(_header.breakpoints, uint64_t{});
+    auto _sym_bkpts   = _get_records(_header.symbol_breakpoints, uint64_t{});
+
+    auto _within = [](const cache_segment& _seg, size_t _n) {
+        return (_seg.offset <= _n && _seg.count <= (_n - _seg.offset));
+    };
+
+    auto _info = binary_info{};
+    _info.name = _filename;
+
+    for(const auto& itr : _symbols)
+    {
+        if(!_within(itr.inlines, _inlines.size()) ||
+           !_within(itr.dwarf_info, _sym_dwarf.size()) ||
+           !_within(itr.breakpoints, _sym_bkpts.size()))
+            return _invalid("corrupted symbol");
+
+        auto _base       = symbol::base_type{};
+        _base.address    = itr.bfd_address;
+        _base.symsize    = itr.bfd_symsize;
+        _base.binding    = static_cast<decltype(_base.binding)>(itr.binding);
+        _base.visibility = static_cast<decltype(_base.visibility)>(itr.visibility);
+        _base.name       = decltype(_base.name){ _get_string(itr.name) };
+
+        auto& _sym        = _info.symbols.emplace_back(symbol{ _base });
+        _sym.address      = make_address_range(itr.address);
+        _sym.load_address = itr.load_address;
+        _sym.line         = itr.line;
+        _sym.func         = _get_string(itr.func);
+        _sym.file         = _get_string(itr.file);
+
+        _sym.inlines.reserve(itr.inlines.count);
+        for(size_t i = 0; i < itr.inlines.count; ++i)
+        {
+            const auto& _v = _inlines.at(itr.inlines.offset + i);
+            _sym.inlines.emplace_back(
+                inlined_symbol{ _v.line, _get_string(_v.file), _get_string(_v.func) });
+        }
+
+        _sym.dwarf_info.reserve(itr.dwarf_info.count);
+        for(size_t i = 0; i < itr.dwarf_info.count; ++i)
+            _sym.dwarf_info.emplace_back(
+                _get_dwarf_entry(_sym_dwarf.at(itr.dwarf_info.offset + i)));
+
+        _sym.breakpoints.reserve(itr.breakpoints.count);
+        for(size_t i = 0; i < itr.breakpoints.count; ++i)
+            _sym.breakpoints.emplace_back(_sym_bkpts.at(itr.breakpoints.offset + i));
+    }
+
+    for(const auto& itr : _debug_info)
+        _info.debug_info.emplace_back(_get_dwarf_entry(itr));
+
+    _info.ranges.reserve(_ranges.size());
+    for(const auto& itr : _ranges)
+        _info.ranges.emplace_back(make_address_range(itr));
+
+    _info.breakpoints.reserve(_breakpoints.size());
+    for(const auto& itr : _breakpoints)
+        _info.breakpoints.emplace_back(itr);
+
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_cache_mutex() };
+        get_cache_mappings().emplace_back(_addr, _size);
+    }
+
+    ROCPROFSYS_BASIC_VERBOSE(1, "[binary] Loaded %zu symbols for '%s' from cache '%s'\n",
+                             _info.symbols.size(), _filename.c_str(),
+                             _cache_name.c_str());
+
+    return _info;
+}
+
+bool
+save_binary_cache(const binary_info& _info, bool _process_dwarf, bool _process_bfd,
+                  bool _include_all)
+{
+    if(!use_binary_cache()) return false;
+
+    auto _filename = _info.filename();
+    auto _status   = get_file_status(_filename);
+    if(_filename.empty() || !_status) return false;
+
+    auto _build_id = get_build_id(_filename);
+    auto _header   = cache_header{};
+
+    _header.flags      = get_cache_flags(_process_dwarf, _process_bfd, _include_all);
+    _header.mtime_sec  = _status->mtime_sec;
+    _header.mtime_nsec = _status->mtime_nsec;
+    _header.file_size  = _status->size;
+    strncpy(_header.build_id, _build_id.c_str(), sizeof(_header.build_id) - 1);
+
+    auto _strings     = string_table{};
+    auto _symbols     = std::vector<cache_symbol>{};
+    auto _inlines     = std::vector<cache_inlined_symbol>{};
+    auto _debug_info  = std::vector<cache_dwarf_entry>{};
+    auto _sym_dwarf   = std::vector<cache_dwarf_entry>{};
+    auto _ranges      = std::vector<cache_range>{};
+    auto _breakpoints = std::vector<uint64_t>{};
+    auto _sym_bkpts   = std::vector<uint64_t>{};
+
+    _symbols.reserve(_info.symbols.size());
+    for(const auto& itr : _info.symbols)
+    {
+        const auto& _base = itr.base();
+        auto        _sym  = cache_symbol{};
+
+        _sym.bfd_address  = _base.address;
+        _sym.bfd_symsize  = _base.symsize;
+        _sym.binding      = static_cast<int64_t>(_base.binding);
+        _sym.visibility   = static_cast<int64_t>(_base.visibility);
+        _sym.name         = _strings(std::string{ _base.name });
+        _sym.func         = _strings(itr.func);
+        _sym.file         = _strings(itr.file);
+        _sym.load_address = itr.load_address;
+        _sym.address      = make_cache_range(itr.address);
+        _sym.line         = itr.line;
+
+        _sym.inlines = cache_segment{ _inlines.size(), itr.inlines.size() };
+        for(const auto& iitr : itr.inlines)
+            _inlines.emplace_back(cache_inlined_symbol{
+                _strings(iitr.file), _strings(iitr.func), iitr.line });
+
+        _sym.dwarf_info = cache_segment{ _sym_dwarf.size(), itr.dwarf_info.size() };
+        for(const auto& ditr : itr.dwarf_info)
+            _sym_dwarf.emplace_back(make_cache_dwarf_entry(ditr, _strings));
+
+        _sym.breakpoints = cache_segment{ _sym_bkpts.size(), itr.breakpoints.size() };
+        for(const auto& bitr : itr.breakpoints)
+            _sym_bkpts.emplace_back(bitr);
+
+        _symbols.emplace_back(_sym);
+    }
+
+    _debug_info.reserve(_info.debug_info.size());
+    for(const auto& itr : _info.debug_info)
+        _debug_info.emplace_back(make_cache_dwarf_entry(itr, _strings));
+
+    _ranges.reserve(_info.ranges.size());
+    for(const auto& itr : _info.ranges)
+        _ranges.emplace_back(make_cache_range(itr));
+
+    _breakpoints.reserve(_info.breakpoints.size());
+    for(const auto& itr : _info.breakpoints)
+        _breakpoints.emplace_back(itr);
+
+    // write to a process-specific temporary file and rename it so that concurrent
+    // processes (e.g. multiple ranks on a node) never observe a partial cache file
+    auto _cache_name = get_binary_cache_filename(_filename);
+    auto _tmp_name   = JOIN('.', _cache_name, getpid(), "tmp");
+    auto _ofs        = std::ofstream{};
+
+    if(!filepath::open(_ofs, _tmp_name, std::ios::binary | std::ios::out))
+    {
+        ROCPROFSYS_BASIC_VERBOSE(1, "[binary] Failed to open cache file '%s'\n",
+                                 _tmp_name.c_str());
+        return false;
+    }
+
+    // write a placeholder header, then the segments, then the final header
+    _ofs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    write_segment(_ofs, _header.strings,
+                  std::vector<char>{ _strings.data.begin(), _strings.data.end() });
+    write_segment(_ofs, _header.symbols, _symbols);
+    write_segment(_ofs, _header.inlines, _inlines);
+    write_segment(_ofs, _header.debug_info, _debug_info);
+    write_segment(_ofs, _header.symbol_dwarf_info, _sym_dwarf);
+    write_segment(_ofs, _header.ranges, _ranges);
+    write_segment(_ofs, _header.breakpoints, _breakpoints);
+    write_segment(_ofs, _header.symbol_breakpoints, _sym_bkpts);
+    _ofs.seekp(0);
+    _ofs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _ofs.close();
+
+    if(!_ofs || std::rename(_tmp_name.c_str(), _cache_name.c_str()) != 0)
+    {
+        ROCPROFSYS_BASIC_VERBOSE(1, "[binary] Failed to write cache file '%s'\n",
+                                 _cache_name.c_str());
+        std::remove(_tmp_name.c_str());
+        return false;
+    }
+
+    ROCPROFSYS_BASIC_VERBOSE(1, "[binary] Wrote %zu symbols for '%s' to cache '%s'\n",
+                             _info.symbols.size(), _filename.c_str(),
+                             _cache_name.c_str());
+
+    return true;
+}
+}  // namespace binary
+}  // namespace rocprofsys
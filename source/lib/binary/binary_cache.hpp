@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/binary/fwd.hpp"
+
+#include <optional>
+#include <string>
+
+namespace rocprofsys
+{
+namespace binary
+{
+// returns the hex-encoded GNU build-id of the ELF file (empty if not available)
+std::string
+get_build_id(const std::string& _filename);
+
+// the cache file is keyed by the build-id (or the path when there is no build-id) and
+// is only considered valid when the mtime and size of the ELF file, the build-id and
+// the parsing options match the values recorded in the header of the cache file
+std::string
+get_binary_cache_filename(const std::string& _filename);
+
+// returns the parsed (pre-mapping) binary info from the memory-mapped cache file for
+// the ELF file or std::nullopt if caching is disabled or the cache is missing/stale
+std::optional<binary_info>
+load_binary_cache(const std::string& _filename, bool _process_dwarf, bool _process_bfd,
+                  bool _include_all);
+
+// writes the parsed (pre-mapping) binary info to the cache file for the ELF file
+bool
+save_binary_cache(const binary_info&, bool _process_dwarf, bool _process_bfd,
+                  bool _include_all);
+}  // namespace binary
+}  // namespace rocprofsys
@@ -42,6 +42,7 @@ namespace binary
 {
 struct binary_info
 {
+    std::string                              name        = {};
     std::shared_ptr<bfd_file>                bfd         = {};
     std::vector<procfs::maps>                mappings    = {};
     std::deque<symbol>                       symbols     = {};
@@ -81,6 +82,7 @@ binary_info::find_section(uintptr_t _addr) const
 inline std::string
 binary_info::filename() const
 {
+    if(!name.empty()) return name;
     return (bfd) ? std::string{ bfd->name } : std::string{};
 }
 }  // namespace binary
@@ -49,6 +49,8 @@
 
 #include <timemory/mpl/concepts.hpp>
 
+#include <algorithm>
+
 namespace rocprofsys
 {
 namespace binary
@@ -152,9 +154,17 @@ symbol::operator bool() const
 size_t
 symbol::read_dwarf_entries(const std::deque<dwarf_entry>& _info)
 {
-    for(const auto& itr : _info)
+    // NOTE: _info must be sorted by the low address of the entries so only the slice
+    // of entries which start within the address range of this symbol is visited
+    auto _end_addr = std::max(address.high, address.low + 1);
+    auto _beg_itr  = std::lower_bound(_info.begin(), _info.end(), address.low,
+                                     [](const dwarf_entry& _lhs, uintptr_t _addr) {
+                                         return _lhs.address.low < _addr;
+                                     });
+
+    for(auto itr = _beg_itr; itr != _info.end() && itr->address.low < _end_addr; ++itr)
     {
-        if(address.contains(itr.address)) dwarf_info.emplace_back(itr);
+        if(address.contains(itr->address)) dwarf_info.emplace_back(*itr);
     }
 
     // make sure the dwarf info is sorted by address (low to high)
@@ -204,9 +214,13 @@ symbol::read_dwarf_entries(const std::deque<dwarf_entry>& _info)
 size_t
 symbol::read_dwarf_breakpoints(const std::vector<uintptr_t>& _bkpts)
 {
-    for(const auto& itr : _bkpts)
+    // NOTE: _bkpts must be sorted (low to high)
+    auto _end_addr = std::max(address.high, address.low + 1);
+    auto _beg_itr  = std::lower_bound(_bkpts.begin(), _bkpts.end(), address.low);
+
+    for(auto itr = _beg_itr; itr != _bkpts.end() && *itr < _end_addr; ++itr)
     {
-        if(address.contains(itr)) breakpoints.emplace_back(itr);
+        if(address.contains(*itr)) breakpoints.emplace_back(*itr);
     }
 
     // make sure the breakpoints are sorted low to high
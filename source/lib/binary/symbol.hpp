@@ -70,6 +70,7 @@ struct symbol : private tim::unwind::bfd_file::symbol
     size_t        read_dwarf_entries(const std::deque<dwarf_entry>&);
     size_t        read_dwarf_breakpoints(const std::vector<uintptr_t>&);
     address_range ipaddr() const { return address + load_address; }
+    const auto&   base() const { return static_cast<const base_type&>(*this); }
     symbol        clone() const;
 
     template <typename Tp = std::deque<symbol>>
@@ -433,6 +433,23 @@ configure_settings(bool _init)
         "Defaults to ROCPROFSYS_SAMPLING_FREQ when <= 0.0",
         -1.0, "sampling", "advanced");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        double, "ROCPROFSYS_SAMPLING_OVERHEAD_TARGET",
+        "Maximum percentage of the time of each thread spent in the sampling signal "
+        "handler, e.g. 2 for 2%. When exceeded, only a fraction of the interrupts of "
+        "the CPU-time and real-time timers are sampled. Each sample records its "
+        "effective period. Disabled when <= 0.0",
+        0.0, "sampling", "performance", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_SAMPLING_METRICS_BACKEND",
+        "Source of the thread metrics recorded with each timer-based sample (CPU time, "
+        "page faults, context switches, and the ROCPROFSYS_PAPI_EVENTS with a generic "
+        "perf equivalent). 'rusage' queries getrusage and PAPI in the signal handler. "
+        "'perf' reads a per-thread perf_event group with a single read() or rdpmc",
+        "rusage", "sampling", "performance", "advanced")
+        ->set_choices({ "rusage", "perf" });
+
     ROCPROFSYS_CONFIG_SETTING(double, "ROCPROFSYS_SAMPLING_OVERFLOW_FREQ",
                               "Number of events in between each sample. "
                               "Defaults to ROCPROFSYS_SAMPLING_FREQ when <= 0.0",
@@ -466,6 +483,13 @@ configure_settings(bool _init)
         "set to zero, uses ROCPROFSYS_SAMPLING_FREQ value",
         0.0, "process_sampling");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        size_t, "ROCPROFSYS_PROCESS_SAMPLING_BUFFER_SIZE",
+        "Number of background process samples (CPU frequency, memory usage, etc.) held "
+        "in memory before they are written to the perfetto trace. If set to zero, all "
+        "the samples are held in memory until finalization",
+        size_t{ 1024 }, "process_sampling", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(double, "ROCPROFSYS_PROCESS_SAMPLING_DURATION",
                               "If > 0.0, time (in seconds) to sample before stopping. If "
                               "less than zero, uses ROCPROFSYS_SAMPLING_DURATION",
@@ -569,6 +593,37 @@ configure_settings(bool _init)
                               "Create entries for inlined functions when available",
                               false, "sampling", "data", "advanced");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_SAMPLING_PARALLEL_POST_PROCESS",
+        "Post-process the call-stack samples of each thread concurrently in the "
+        "background thread-pool (see ROCPROFSYS_THREAD_POOL_SIZE) during finalization. "
+        "The perfetto and timemory output is still generated serially in thread order "
+        "so the output is identical to the serial post-processing",
+        false, "sampling", "parallelism", "performance", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_SAMPLING_OUTPUT",
+        "Outputs generated from the call-stack samples. 'timemory' and 'perfetto' also "
+        "require ROCPROFSYS_USE_TIMEMORY and ROCPROFSYS_USE_PERFETTO, respectively. "
+        "'folded' (flame graph stacks) and 'pprof' aggregate the samples per unique "
+        "call-stack and are written directly, i.e. without the timemory call-graph",
+        "timemory perfetto", "sampling", "io", "advanced")
+        ->set_choices({ "timemory", "perfetto", "folded", "pprof" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_SAMPLING_UNWINDER",
+        "Unwinder used for the timer-based call-stack samples. 'frame-pointer' walks the "
+        "frame-pointer chain (requires code compiled with -fno-omit-frame-pointer) and "
+        "falls back to 'libunwind' for a sample when the chain is broken",
+        "libunwind", "sampling", "performance", "advanced")
+        ->set_choices({ "libunwind", "frame-pointer" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_SAMPLING_UNWIND_STATS",
+        "Measure the time spent in the unwinder for every timer-based call-stack sample "
+        "and report the average latency at finalization",
+        false, "sampling", "debugging", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(
         size_t, "ROCPROFSYS_SAMPLING_ALLOCATOR_SIZE",
         "The number of sampled threads handled by an allocator running in a background "
@@ -624,6 +679,25 @@ configure_settings(bool _init)
                               "sampling", "hardware_counters")
         ->set_choices(perf::get_config_choices());
 
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_SAMPLING_OVERFLOW_MODE",
+        "How the perf ring buffers of overflow sampling are drained. 'signal' interrupts "
+        "the sampled thread with ROCPROFSYS_SAMPLING_OVERFLOW_SIGNAL. 'collector' drains "
+        "the ring buffers of all threads from a single background thread (via epoll) so "
+        "the sampled threads are never interrupted and the call-stacks are provided by "
+        "the kernel",
+        "signal", "sampling", "performance", "advanced")
+        ->set_choices({ "signal", "collector" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        size_t, "ROCPROFSYS_SAMPLING_OVERFLOW_STACK_SIZE",
+        "Number of bytes of the user stack copied by the kernel for each overflow sample "
+        "when ROCPROFSYS_SAMPLING_OVERFLOW_MODE=collector. The copies are unwound with "
+        "the DWARF unwind tables after sampling stops, which recovers the frames of code "
+        "built without frame-pointers. Zero disables the stack copies and the "
+        "call-stacks are provided by the kernel",
+        0, "sampling", "performance", "advanced");
+
     rocprofiler_sdk::config_settings(_config);
 
     ROCPROFSYS_CONFIG_SETTING(
@@ -640,6 +714,12 @@ configure_settings(bool _init)
                               "Size of perfetto buffer (in KB)", size_t{ 1024000 },
                               "perfetto", "data");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        size_t, "ROCPROFSYS_PERFETTO_OUTPUT_CHUNK_SIZE_KB",
+        "Maximum amount of trace data (in KB) held in memory at once when writing the "
+        "perfetto output file and when combining the traces of MPI ranks",
+        size_t{ 16384 }, "perfetto", "data", "io", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(bool, "ROCPROFSYS_PERFETTO_COMBINE_TRACES",
                               "Combine Perfetto traces. If not explicitly set, it will "
                               "default to the value of ROCPROFSYS_COLLAPSE_PROCESSES",
@@ -665,6 +745,31 @@ configure_settings(bool _init)
         "profile", "perfetto", "timemory", "data", "category", "advanced")
         ->set_choices(get_available_categories<std::vector<std::string>>());
 
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_TIMESTAMP_CLOCK",
+        "Clock of the timestamps of the trace events and samples. 'tsc' reads the "
+        "invariant cycle counter (rdtsc, cntvct_el0) calibrated against CLOCK_REALTIME "
+        "at startup with periodic drift correction and falls back to 'realtime' "
+        "(clock_gettime) when the counter is not invariant",
+        "realtime", "perfetto", "timemory", "performance", "advanced")
+        ->set_choices({ "realtime", "tsc" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_EVENT_LOG",
+        "Record the entry and exit of instrumented functions as compact 16-byte records "
+        "in per-thread memory-mapped logs instead of updating perfetto and timemory "
+        "on every call. The logs are converted to perfetto slices and the timemory "
+        "call-graph when the application finishes",
+        false, "perfetto", "timemory", "trace", "performance", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_THROTTLE",
+        "Stop recording an instrumented function once it was called more than "
+        "ROCPROFSYS_THROTTLE_COUNT times with an average duration below "
+        "ROCPROFSYS_THROTTLE_VALUE nanoseconds. The throttled functions are reported "
+        "in the metadata",
+        false, "perfetto", "timemory", "throttle", "performance", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(
         bool, "ROCPROFSYS_PERFETTO_ANNOTATIONS",
         "Include debug annotations in perfetto trace. When enabled, "
@@ -704,6 +809,19 @@ configure_settings(bool _init)
         std::string, "ROCPROFSYS_TMPDIR", "Base directory for temporary files",
         get_env<std::string>("TMPDIR", "/tmp"), "io", "data", "advanced");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_BINARY_CACHE",
+        "Cache the parsed symbols and line info of binaries on disk (keyed by the "
+        "build-id) and memory-map the cache instead of re-parsing the DWARF/BFD info "
+        "of unchanged binaries in subsequent runs",
+        false, "io", "data", "causal", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_BINARY_CACHE_DIR",
+        "Directory for the binary info cache files. If empty, defaults to "
+        "'<ROCPROFSYS_TMPDIR>/rocprofsys-binary-cache'",
+        std::string{}, "io", "data", "causal", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(
         std::string, "ROCPROFSYS_CAUSAL_BACKEND",
         "Backend for call-stack sampling. See "
@@ -1371,7 +1489,17 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
     _config->find("ROCPROFSYS_COLLAPSE_PROCESSES")->second->set_hidden(true);
 #endif
 
-    _config->disable_category("throttle");
+    // timemory's throttling is not used: only the thresholds are shared with the
+    // throttling of the instrumented functions
+    for(const auto& itr : _config->disable_category("throttle"))
+    {
+        auto& _setting = _config->find(itr)->second;
+        if(std::regex_match(_setting->get_env_name(),
+                            std::regex{ "^ROCPROFSYS_THROTTLE(_COUNT|_VALUE)?$" }))
+            _setting->set_enabled(true);
+        else
+            _setting->set_hidden(true);
+    }
 
     // user bundle components
     _config->disable("components");
@@ -1399,9 +1527,9 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
     std::string _hidden_exact_re =
         "^ROCPROFSYS_(BANNER|DESTRUCTOR_REPORT|COMPONENTS|(GLOBAL|MPIP|NCCLP|OMPT|"
         "PROFILER|TRACE|KOKKOS)_COMPONENTS|PYTHON_EXE|PAPI_ATTACH|PLOT_OUTPUT|SEPARATOR_"
-        "FREQ|STACK_CLEARING|TARGET_PID|THROTTLE_(COUNT|VALUE)|(AUTO|FLAMEGRAPH)_OUTPUT|"
-        "(ENABLE|DISABLE)_ALL_SIGNALS|ALLOW_SIGNAL_HANDLER|CTEST_NOTES|INSTRUCTION_"
-        "ROOFLINE|ADD_SECONDARY|MAX_THREAD_BOOKMARKS)$";
+        "FREQ|STACK_CLEARING|TARGET_PID|(AUTO|FLAMEGRAPH)_OUTPUT|(ENABLE|DISABLE)_ALL_"
+        "SIGNALS|ALLOW_SIGNAL_HANDLER|CTEST_NOTES|INSTRUCTION_ROOFLINE|ADD_SECONDARY|"
+        "MAX_THREAD_BOOKMARKS)$";
 
     //  leading matches, e.g. ROCPROFSYS_MPI_[A-Z_]+
     std::string _hidden_begin_re =
@@ -1946,6 +2074,13 @@ get_perfetto_buffer_size()
     return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
+size_t
+get_perfetto_output_chunk_size()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_OUTPUT_CHUNK_SIZE_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 bool
 get_perfetto_combined_traces()
 {
@@ -2042,6 +2177,41 @@ get_perfetto_annotations()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_timestamp_tsc_clock()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_TIMESTAMP_CLOCK");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get() == "tsc";
+}
+
+bool
+get_use_event_log()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_EVENT_LOG");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_throttle()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_THROTTLE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_throttle_count()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_THROTTLE_COUNT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_throttle_value()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_THROTTLE_VALUE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 uint64_t
 get_thread_pool_size()
 {
@@ -2111,6 +2281,14 @@ get_sampling_realtime_freq()
     return _val;
 }
 
+double
+get_sampling_overhead_target()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_OVERHEAD_TARGET");
+    return std::max(static_cast<tim::tsettings<double>&>(*_v->second).get(), 0.0) /
+           100.0;
+}
+
 double
 get_sampling_overflow_freq()
 {
@@ -2198,6 +2376,60 @@ get_sampling_include_inlines()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_sampling_parallel_post_process()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_PARALLEL_POST_PROCESS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::set<std::string>
+get_sampling_output()
+{
+    static auto _v   = get_config()->find("ROCPROFSYS_SAMPLING_OUTPUT");
+    auto        _ret = std::set<std::string>{};
+    for(auto itr : tim::delimit(
+            static_cast<tim::tsettings<std::string>&>(*_v->second).get(), " ,;:\t\n"))
+        _ret.emplace(std::move(itr));
+    return _ret;
+}
+
+bool
+get_sampling_frame_pointer_unwind()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_UNWINDER");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get() ==
+           "frame-pointer";
+}
+
+bool
+get_sampling_unwind_stats()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_UNWIND_STATS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_perf_metrics()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_METRICS_BACKEND");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get() == "perf";
+}
+
+bool
+get_sampling_overflow_collector()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_OVERFLOW_MODE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get() == "collector";
+}
+
+size_t
+get_sampling_overflow_stack_size()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_OVERFLOW_STACK_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 size_t
 get_sampling_allocator_size()
 {
@@ -2222,6 +2454,13 @@ get_process_sampling_duration()
     return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
+size_t
+get_process_sampling_buffer_size()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PROCESS_SAMPLING_BUFFER_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 std::string
 get_sampling_gpus()
 {
@@ -2302,6 +2541,21 @@ get_tmpdir()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+bool
+get_use_binary_cache()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_BINARY_CACHE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_binary_cache_dir()
+{
+    static auto _v   = get_config()->find("ROCPROFSYS_BINARY_CACHE_DIR");
+    auto        _dir = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    return (_dir.empty()) ? JOIN('/', get_tmpdir(), "rocprofsys-binary-cache") : _dir;
+}
+
 tmp_file::tmp_file(std::string _v)
 : filename{ std::move(_v) }
 {}
@@ -243,6 +243,9 @@ get_perfetto_shmem_size_hint();
 size_t
 get_perfetto_buffer_size();
 
+size_t
+get_perfetto_output_chunk_size();
+
 bool
 get_perfetto_combined_traces();
 
@@ -258,6 +261,21 @@ get_disabled_categories();
 bool
 get_perfetto_annotations() ROCPROFSYS_HOT;
 
+bool
+get_timestamp_tsc_clock();
+
+bool
+get_use_event_log();
+
+bool
+get_use_throttle();
+
+size_t
+get_throttle_count();
+
+size_t
+get_throttle_value();
+
 uint64_t
 get_thread_pool_size();
 
@@ -283,6 +301,10 @@ get_sampling_cputime_freq();
 double
 get_sampling_realtime_freq();
 
+// fraction, i.e. ROCPROFSYS_SAMPLING_OVERHEAD_TARGET / 100
+double
+get_sampling_overhead_target();
+
 double
 get_sampling_overflow_freq();
 
@@ -313,6 +335,27 @@ get_sampling_overflow_tids();
 bool
 get_sampling_include_inlines();
 
+bool
+get_sampling_parallel_post_process();
+
+std::set<std::string>
+get_sampling_output();
+
+bool
+get_sampling_frame_pointer_unwind();
+
+bool
+get_sampling_unwind_stats();
+
+bool
+get_sampling_perf_metrics();
+
+bool
+get_sampling_overflow_collector();
+
+size_t
+get_sampling_overflow_stack_size();
+
 size_t
 get_num_threads_hint();
 
@@ -325,6 +368,9 @@ get_process_sampling_freq();
 double
 get_process_sampling_duration();
 
+size_t
+get_process_sampling_buffer_size();
+
 std::string
 get_sampling_gpus();
 
@@ -349,6 +395,12 @@ get_use_tmp_files();
 std::string
 get_tmpdir();
 
+bool
+get_use_binary_cache();
+
+std::string
+get_binary_cache_dir();
+
 struct tmp_file
 {
     tmp_file(std::string);
@@ -0,0 +1,223 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+
+namespace rocprofsys
+{
+namespace container
+{
+// append-only prefix tree (call-stack tree) which interns call-stacks so that a sample
+// only needs to store the id of the leaf node. Insertion is intended to be performed by
+// a single writer (the sampled thread, from within the signal handler) and therefore
+// neither locks nor allocates via malloc: the nodes are stored in fixed-size chunks
+// which are mapped on demand. The parent links are never modified once a node is
+// published so that an id returned by insert can be expanded from any thread.
+template <typename Tp, size_t ChunkSize = 8192, size_t MaxChunks = 4096>
+struct stack_trie
+{
+    using value_type = Tp;
+    using id_type    = uint32_t;
+
+    // id of the root node, i.e. the empty call-stack
+    static constexpr id_type npos = 0;
+
+    static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0,
+                  "ChunkSize must be a power of 2");
+    static_assert(static_cast<uint64_t>(ChunkSize) * MaxChunks <= UINT32_MAX,
+                  "number of nodes exceeds the range of the id type");
+
+    struct node
+    {
+        value_type value        = {};
+        id_type    parent       = npos;
+        id_type    first_child  = npos;
+        id_type    next_sibling = npos;
+        uint32_t   depth        = 0;
+    };
+
+    stack_trie()  = default;
+    ~stack_trie();
+
+    stack_trie(const stack_trie&) = delete;
+    stack_trie(stack_trie&&)      = delete;
+    stack_trie& operator=(const stack_trie&) = delete;
+    stack_trie& operator=(stack_trie&&) = delete;
+
+    // inserts the call-stack with the innermost frame first (i.e. the order produced
+    // by unwinding) and returns the id of its leaf node. Returns npos if the stack is
+    // empty, the trie is full, or the insertion re-entered (nested signal)
+    template <typename ContainerT>
+    id_type insert(const ContainerT& _stack);
+
+    // writes the call-stack of the given id into the container with the innermost
+    // frame first and returns the number of frames
+    template <typename ContainerT>
+    size_t expand(id_type _id, ContainerT& _stack) const;
+
+    size_t depth(id_type _id) const { return (_id == npos) ? 0 : get(_id).depth; }
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+    size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    size_t memory() const;
+
+private:
+    node* allocate();
+
+    node& get(id_type _id)
+    {
+        return m_chunks[_id / ChunkSize].load(std::memory_order_relaxed)[_id % ChunkSize];
+    }
+
+    const node& get(id_type _id) const
+    {
+        return m_chunks[_id / ChunkSize].load(std::memory_order_acquire)[_id % ChunkSize];
+    }
+
+private:
+    std::atomic<bool>                         m_busy    = { false };
+    std::atomic<size_t>                       m_size    = { 0 };
+    std::atomic<size_t>                       m_dropped = { 0 };
+    id_type                                   m_root    = npos;  // first child of root
+    std::array<std::atomic<node*>, MaxChunks> m_chunks  = {};
+};
+
+template <typename Tp, size_t ChunkSize, size_t MaxChunks>
+stack_trie<Tp, ChunkSize, MaxChunks>::~stack_trie()
+{
+    for(auto& itr : m_chunks)
+    {
+        auto* _chunk = itr.exchange(nullptr);
+        if(_chunk) munmap(_chunk, ChunkSize * sizeof(node));
+    }
+}
+
+template <typename Tp, size_t ChunkSize, size_t MaxChunks>
+typename stack_trie<Tp, ChunkSize, MaxChunks>::node*
+stack_trie<Tp, ChunkSize, MaxChunks>::allocate()
+{
+    // node zero is the (implicit) root so the first chunk has one less usable node
+    auto _id    = static_cast<size_t>(m_size.load(std::memory_order_relaxed)) + 1;
+    auto _chunk = _id / ChunkSize;
+    if(_chunk >= MaxChunks) return nullptr;
+
+    if(!m_chunks[_chunk].load(std::memory_order_relaxed))
+    {
+        // mmap is async-signal-safe whereas malloc is not
+        void* _addr = mmap(nullptr, ChunkSize * sizeof(node), PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(_addr == MAP_FAILED) return nullptr;
+        m_chunks[_chunk].store(static_cast<node*>(_addr), std::memory_order_release);
+    }
+
+    return &m_chunks[_chunk].load(std::memory_order_relaxed)[_id % ChunkSize];
+}
+
+template <typename Tp, size_t ChunkSize, size_t MaxChunks>
+template <typename ContainerT>
+typename stack_trie<Tp, ChunkSize, MaxChunks>::id_type
+stack_trie<Tp, ChunkSize, MaxChunks>::insert(const ContainerT& _stack)
+{
+    if(_stack.empty()) return npos;
+    if(m_busy.exchange(true, std::memory_order_acquire))
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return npos;
+    }
+
+    id_type _parent = npos;
+    for(size_t i = _stack.size(); i > 0; --i)
+    {
+        const auto& _value = _stack[i - 1];
+        id_type&    _head  = (_parent == npos) ? m_root : get(_parent).first_child;
+
+        // linear scan of the siblings. The match is moved to the front of the list
+        // since consecutive samples tend to take the same path through the tree
+        id_type _prev = npos;
+        id_type _curr = _head;
+        while(_curr != npos && !(get(_curr).value == _value))
+        {
+            _prev = _curr;
+            _curr = get(_curr).next_sibling;
+        }
+
+        if(_curr != npos && _prev != npos)
+        {
+            get(_prev).next_sibling = get(_curr).next_sibling;
+            get(_curr).next_sibling = _head;
+            _head                   = _curr;
+        }
+        else if(_curr == npos)
+        {
+            auto* _node = allocate();
+            if(!_node)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                m_busy.store(false, std::memory_order_release);
+                return npos;
+            }
+
+            _curr  = static_cast<id_type>(m_size.load(std::memory_order_relaxed) + 1);
+            *_node = node{ _value, _parent, npos, _head,
+                           static_cast<uint32_t>(_stack.size() - i + 1) };
+            _head  = _curr;
+            m_size.fetch_add(1, std::memory_order_release);
+        }
+
+        _parent = _curr;
+    }
+
+    m_busy.store(false, std::memory_order_release);
+    return _parent;
+}
+
+template <typename Tp, size_t ChunkSize, size_t MaxChunks>
+template <typename ContainerT>
+size_t
+stack_trie<Tp, ChunkSize, MaxChunks>::expand(id_type _id, ContainerT& _stack) const
+{
+    _stack.clear();
+    // walking the parent links from the leaf yields the innermost frame first
+    for(; _id != npos && _stack.size() < _stack.capacity(); _id = get(_id).parent)
+        _stack.emplace_back(get(_id).value);
+    return _stack.size();
+}
+
+template <typename Tp, size_t ChunkSize, size_t MaxChunks>
+size_t
+stack_trie<Tp, ChunkSize, MaxChunks>::memory() const
+{
+    size_t _n = 0;
+    for(const auto& itr : m_chunks)
+        _n += (itr.load(std::memory_order_relaxed)) ? ChunkSize * sizeof(node) : 0;
+    return _n;
+}
+}  // namespace container
+}  // namespace rocprofsys
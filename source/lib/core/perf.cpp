@@ -25,6 +25,12 @@
 
 #include <timemory/units.hpp>
 
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string>
+#include <string_view>
+
 namespace rocprofsys
 {
 namespace perf
@@ -240,5 +246,52 @@ config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
         _pe.sample_period = static_cast<uint64_t>(_freq);
     }
 }
+
+bool
+config_counting(struct perf_event_attr& _pe, std::string_view _event)
+{
+    static const auto _papi_presets = std::map<std::string_view, hw_config>{
+        { "PAPI_TOT_CYC", hw_config::cpu_cycles },
+        { "PAPI_TOT_INS", hw_config::instructions },
+        { "PAPI_BR_INS", hw_config::branch_instructions },
+        { "PAPI_BR_MSP", hw_config::branch_misses },
+        { "PAPI_REF_CYC", hw_config::reference_cpu_cycles },
+    };
+
+    memset(&_pe, 0, sizeof(_pe));
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+
+    if(auto itr = _papi_presets.find(_event); itr != _papi_presets.end())
+    {
+        _pe.type   = PERF_TYPE_HARDWARE;
+        _pe.config = static_cast<int>(itr->second);
+        return true;
+    }
+
+    if(_event.find("PERF_COUNT_") == std::string_view::npos) return false;
+
+    // the config lookups throw for names without a generic equivalent, e.g. events with
+    // qualifiers
+    auto _name = std::string{ _event };
+    try
+    {
+        switch(get_event_type(_name))
+        {
+            case event_type::hardware:
+                _pe.type   = PERF_TYPE_HARDWARE;
+                _pe.config = static_cast<int>(get_hw_config(_name));
+                return true;
+            case event_type::software:
+                _pe.type   = PERF_TYPE_SOFTWARE;
+                _pe.config = static_cast<int>(get_sw_config(_name));
+                return true;
+            default: break;
+        }
+    } catch(std::exception&)
+    {}
+
+    return false;
+}
 }  // namespace perf
 }  // namespace rocprofsys
@@ -287,5 +287,11 @@ int        get_hw_cache_config(std::string_view);
 
 void
 config_overflow_sampling(struct perf_event_attr&, std::string_view, double);
+
+/// configures a counting (non-sampling) event for a perf::PERF_COUNT_HW_* or
+/// perf::PERF_COUNT_SW_* event or a PAPI preset with a generic perf equivalent.
+/// Returns false when the event has no equivalent
+bool
+config_counting(struct perf_event_attr&, std::string_view);
 }  // namespace perf
 }  // namespace rocprofsys
@@ -25,9 +25,23 @@
 #include "debug.hpp"
 #include "library/runtime.hpp"
 #include "perfetto_fwd.hpp"
+#include "perfetto_merge.hpp"
 #include "utility.hpp"
 
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+#    include <timemory/mpi.hpp>
+#endif
+
+#include <cerrno>
 #include <chrono>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <vector>
+
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace rocprofsys
 {
@@ -66,6 +80,143 @@ get_session(pid_t _pid = process::get_id())
         _v.emplace(_pid, std::unique_ptr<::perfetto::TracingSession>{});
     return _v.at(_pid);
 }
+
+size_t
+get_fd_size(int _fd)
+{
+    struct stat _stat = {};
+    if(_fd < 0 || ::fstat(_fd, &_stat) != 0) return 0;
+    return static_cast<size_t>(_stat.st_size);
+}
+
+bool
+write_fd(int _fd, const char* _data, size_t _nbytes)
+{
+    while(_nbytes > 0)
+    {
+        auto _n = ::write(_fd, _data, _nbytes);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0) return false;
+        _data += _n;
+        _nbytes -= _n;
+    }
+    return true;
+}
+
+bool
+pread_fd(int _fd, char* _data, size_t _nbytes, off_t _offset)
+{
+    while(_nbytes > 0)
+    {
+        auto _n = ::pread(_fd, _data, _nbytes, _offset);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0) return false;
+        _data += _n;
+        _nbytes -= _n;
+        _offset += _n;
+    }
+    return true;
+}
+
+// copies the first _nbytes of _src_fd to the current position of _dst_fd. sendfile keeps
+// the data in the kernel; if it is not supported for these files (e.g. some network
+// filesystems), fall back to a buffer of at most _chunk_size bytes
+bool
+copy_fd(int _src_fd, int _dst_fd, size_t _nbytes, size_t _chunk_size)
+{
+    off_t _offset = 0;
+    while(static_cast<size_t>(_offset) < _nbytes)
+    {
+        auto _n = ::sendfile(_dst_fd, _src_fd, &_offset,
+                             std::min<size_t>(_chunk_size, _nbytes - _offset));
+        if(_n > 0 || (_n < 0 && errno == EINTR)) continue;
+        if(_n == 0) return false;
+        break;
+    }
+
+    auto _buffer = std::vector<char>(std::min<size_t>(_chunk_size, _nbytes - _offset));
+    while(static_cast<size_t>(_offset) < _nbytes)
+    {
+        auto _n = std::min<size_t>(_buffer.size(), _nbytes - _offset);
+        if(!pread_fd(_src_fd, _buffer.data(), _n, _offset)) return false;
+        if(!write_fd(_dst_fd, _buffer.data(), _n)) return false;
+        _offset += _n;
+    }
+    return true;
+}
+
+// streams the in-process trace buffer into _fd. Unlike ReadTraceBlocking, the trace is
+// delivered in pieces so the full trace is never copied into a single buffer
+size_t
+read_trace_to_fd(::perfetto::TracingSession& _session, int _fd, bool& _ok)
+{
+    auto   _done   = std::promise<void>{};
+    size_t _nbytes = 0;
+    _session.ReadTrace([&](::perfetto::TracingSession::ReadTraceCallbackArgs _args) {
+        if(_args.size > 0)
+        {
+            if(_ok) _ok = write_fd(_fd, _args.data, _args.size);
+            _nbytes += _args.size;
+        }
+        if(!_args.has_more) _done.set_value();
+    });
+    _done.get_future().wait();
+    return _nbytes;
+}
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+// gathers the trace of every rank into _dst_fd on rank zero in rank order, at most
+// _chunk_size bytes per message. A perfetto trace is a sequence of TracePacket records
+// so the concatenation of the traces is itself a valid trace.
+size_t
+combine_fd_chunked(int _src_fd, int _dst_fd, size_t _chunk_size, bool& _ok)
+{
+    constexpr int tag = 0x7066;
+
+    auto _comm  = tim::mpi::comm_world_v;
+    auto _rank  = tim::mpi::rank(_comm);
+    auto _size  = tim::mpi::size(_comm);
+    auto _bytes = static_cast<uint64_t>(get_fd_size(_src_fd));
+    auto _sizes = std::vector<uint64_t>(_size, 0);
+
+    _chunk_size = std::min<size_t>(_chunk_size, std::numeric_limits<int>::max());
+    MPI_Gather(&_bytes, 1, MPI_UINT64_T, _sizes.data(), 1, MPI_UINT64_T, 0, _comm);
+
+    auto _buffer = std::vector<char>{};
+    if(_rank != 0)
+    {
+        _buffer.resize(std::min<uint64_t>(_chunk_size, _bytes));
+        for(uint64_t _offset = 0; _offset < _bytes;)
+        {
+            auto _n = std::min<uint64_t>(_chunk_size, _bytes - _offset);
+            // the root expects exactly _bytes so send the chunk even when it was not read
+            if(!pread_fd(_src_fd, _buffer.data(), _n, _offset)) _ok = false;
+            MPI_Send(_buffer.data(), static_cast<int>(_n), MPI_CHAR, 0, tag, _comm);
+            _offset += _n;
+        }
+        return _bytes;
+    }
+
+    if(_ok) _ok = copy_fd(_src_fd, _dst_fd, _bytes, _chunk_size);
+
+    size_t _total = _bytes;
+    for(int i = 1; i < _size; ++i)
+    {
+        _buffer.resize(std::min<uint64_t>(_chunk_size, _sizes.at(i)));
+        for(uint64_t _remain = _sizes.at(i); _remain > 0;)
+        {
+            auto _n = std::min<uint64_t>(_chunk_size, _remain);
+            MPI_Recv(_buffer.data(), static_cast<int>(_n), MPI_CHAR, i, tag, _comm,
+                     MPI_STATUS_IGNORE);
+            // keep receiving after a failure so that the other ranks do not block
+            if(_ok) _ok = write_fd(_dst_fd, _buffer.data(), _n);
+            _remain -= _n;
+        }
+        _total += _sizes.at(i);
+    }
+    return _total;
+}
+#endif
 }  // namespace
 
 void
@@ -164,133 +315,147 @@ stop()
 void
 post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
 {
-    using char_vec_t = std::vector<char>;
-
     stop();
 
     auto& tracing_session = get_perfetto_session();
     if(!tracing_session) return;
 
-    auto _get_session_data = [&tracing_session]() {
-        auto _data     = char_vec_t{};
-        auto _tmp_file = get_perfetto_tmp_file();
-        if(_tmp_file && *_tmp_file)
-        {
-            _tmp_file->close();
-            FILE* _fdata = ::fopen(_tmp_file->filename.c_str(), "rb");
+    auto& _tmp_file   = get_perfetto_tmp_file();
+    auto  _filename   = config::get_perfetto_output_filename();
+    auto  _chunk_size =
+        std::max<size_t>(config::get_perfetto_output_chunk_size(), 1) * units::KB;
 
-            if(!_fdata)
-            {
-                ROCPROFSYS_VERBOSE(
-                    -1, "Error! perfetto temp trace file '%s' could not be read",
-                    _tmp_file->filename.c_str());
-                return char_vec_t{ tracing_session->ReadTraceBlocking() };
-            }
+    // the trace is copied from the temporary file (or streamed from the in-process
+    // buffer) into the output file in chunks so that the full trace is never held in
+    // memory
+    int _src_fd = -1;
+    if(_tmp_file && *_tmp_file)
+    {
+        _tmp_file->close();
+        if(!_tmp_file->open(O_RDONLY, 0))
+        {
+            ROCPROFSYS_VERBOSE(-1,
+                               "Error! perfetto temp trace file '%s' could not be read\n",
+                               _tmp_file->filename.c_str());
+        }
+        _src_fd = _tmp_file->fd;
+    }
 
-            ::fseek(_fdata, 0, SEEK_END);
-            size_t _fnum_elem = ::ftell(_fdata);
-            ::fseek(_fdata, 0, SEEK_SET);  // same as rewind(f);
+    bool _combine = false;
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    _combine = get_perfetto_combined_traces() && tim::mpi::is_initialized() &&
+               !tim::mpi::is_finalized() && tim::mpi::size() > 1;
 
-            _data.resize(_fnum_elem, '\0');
-            auto _fnum_read = ::fread(_data.data(), sizeof(char), _fnum_elem, _fdata);
-            ::fclose(_fdata);
+    // every rank needs a file to read its chunks from when combining so spill the
+    // in-process buffer into a file next to the output. config::get_tmp_file() cannot
+    // be used here because this path is only taken when temporary files are disabled
+    if(_combine && _src_fd < 0)
+    {
+        _tmp_file = std::make_shared<tmp_file>(
+            JOIN('.', _filename, process::get_id(), "spill"));
+        _tmp_file->open(O_RDWR | O_CREAT | O_TRUNC, 0600);
+        bool _ok  = (_tmp_file->fd >= 0);
+        if(_ok) read_trace_to_fd(*tracing_session, _tmp_file->fd, _ok);
+        ROCPROFSYS_CI_THROW(!_ok, "Error! failed to write perfetto trace to '%s'\n",
+                            _tmp_file->filename.c_str());
+        _src_fd = _tmp_file->fd;
+    }
+#endif
 
-            ROCPROFSYS_CI_THROW(
-                _fnum_read != _fnum_elem,
-                "Error! read %zu elements from perfetto trace file '%s'. Expected %zu\n",
-                _fnum_read, _tmp_file->filename.c_str(), _fnum_elem);
-        }
-        else
-        {
-            _data = char_vec_t{ tracing_session->ReadTraceBlocking() };
-        }
+    auto _src_bytes = get_fd_size(_src_fd);
+    auto _is_root   = (!_combine || dmp::rank() == 0);
 
-        return _data;
-    };
+    FILE* _ofs    = nullptr;
+    int   _dst_fd = -1;
+    if(_is_root && (_combine || _src_fd < 0 || _src_bytes > 0))
+    {
+        _ofs = filepath::fopen(_filename, "wb");
+        if(_ofs) _dst_fd = ::fileno(_ofs);
+    }
 
-    auto trace_data = char_vec_t{};
+    bool   _ok       = (!_is_root || _dst_fd >= 0);
+    size_t _nbytes   = 0;
+    auto   _write_ts = std::chrono::steady_clock::now();
+    if(_combine)
+    {
 #if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
-    if(get_perfetto_combined_traces())
+        // all ranks must participate, even if rank zero could not open the output file
+        _nbytes = combine_fd_chunked(_src_fd, _dst_fd, _chunk_size, _ok);
+#endif
+    }
+    else if(_src_fd >= 0)
     {
-        using perfetto_mpi_get_t = tim::operation::finalize::mpi_get<char_vec_t, true>;
-
-        auto _trace_data = _get_session_data();
-        auto _rank_data  = std::vector<char_vec_t>{};
-        auto _combine    = [](char_vec_t& _dst, const char_vec_t& _src) -> char_vec_t& {
-            _dst.reserve(_dst.size() + _src.size());
-            for(auto&& itr : _src)
-                _dst.emplace_back(itr);
-            return _dst;
-        };
-
-        perfetto_mpi_get_t{ get_perfetto_combined_traces(),
-                            settings::node_count() }(_rank_data, _trace_data, _combine);
-        for(auto& itr : _rank_data)
-            trace_data =
-                (trace_data.empty()) ? std::move(itr) : _combine(trace_data, itr);
+        if(_ok) _ok = copy_fd(_src_fd, _dst_fd, _src_bytes, _chunk_size);
+        _nbytes = _src_bytes;
     }
-    else
+    else if(_ok)
     {
-        trace_data = _get_session_data();
+        _nbytes = read_trace_to_fd(*tracing_session, _dst_fd, _ok);
     }
-#else
-    trace_data = _get_session_data();
-#endif
+    auto _write_sec =
+        std::chrono::duration<double>{ std::chrono::steady_clock::now() - _write_ts }
+            .count();
+
+    if(_ofs) ::fclose(_ofs);
 
-    auto _filename = config::get_perfetto_output_filename();
-    if(!trace_data.empty())
+    if(_is_root && _nbytes > 0)
     {
         operation::file_output_message<tim::project::rocprofsys> _fom{};
         // Write the trace into a file.
         if(config::get_verbose() >= 0)
             _fom(_filename, std::string{ "perfetto" },
                  " (%.2f KB / %.2f MB / %.2f GB)... ",
-                 static_cast<double>(trace_data.size()) / units::KB,
-                 static_cast<double>(trace_data.size()) / units::MB,
-                 static_cast<double>(trace_data.size()) / units::GB);
-        std::ofstream ofs{};
-        if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+                 static_cast<double>(_nbytes) / units::KB,
+                 static_cast<double>(_nbytes) / units::MB,
+                 static_cast<double>(_nbytes) / units::GB);
+
+        if(!_ok)
         {
-            _fom.append("Error opening '%s'...", _filename.c_str());
+            _fom.append("Error writing '%s'...", _filename.c_str());
             _perfetto_output_error = true;
         }
         else
         {
-            // Write the trace into a file.
-            ofs.write(trace_data.data(), trace_data.size());
-            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+            if(config::get_verbose() >= 0)
+                _fom.append("Done (%.3f sec)", _write_sec);  // NOLINT
             if(_timemory_manager)
                 _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
         }
-        ofs.close();
 
-        if(dmp::rank() == 0)
+        // merge the traces of multiple processes written to the same directory
+        if(dmp::rank() == 0 && _ok)
         {
-            const char* file_path   = _filename.c_str();
-            auto        folder_path = [](std::string_view _v) {
-                return tim::filepath::dirname(std::string(_v));
-            };
-            // Execute the merge script
-            std::string command =
-                "merge-multiprocess-output.sh '" + folder_path(file_path) + "'";
-            int result = system(command.c_str());
-            if(result != 0)
+            auto _merged = merge_directory(filepath::dirname(_filename));
+            if(!_merged.success)
             {
-                ROCPROFSYS_VERBOSE(0,
-                                   "Failed to execute merge-multiprocess-output.sh with "
-                                   "folder path: %s\n",
-                                   folder_path(file_path).c_str());
+                ROCPROFSYS_VERBOSE(0, "Failed to merge the perfetto traces in '%s'\n",
+                                   filepath::dirname(_filename).c_str());
+            }
+            else if(!_merged.output.empty())
+            {
+                ROCPROFSYS_VERBOSE(1,
+                                   "Merged %zu perfetto traces into '%s' (%.2f MB in "
+                                   "%.3f sec)\n",
+                                   _merged.inputs.size(), _merged.output.c_str(),
+                                   static_cast<double>(_merged.bytes) / units::MB,
+                                   _merged.seconds);
             }
         }
     }
+    else if(_is_root && _dst_fd < 0 && (_combine || _src_fd < 0 || _src_bytes > 0))
+    {
+        ROCPROFSYS_VERBOSE(-1, "Error opening '%s'...\n", _filename.c_str());
+        _perfetto_output_error = true;
+    }
     else if(dmp::rank() == 0)
     {
+        // nothing was written so do not leave an empty file behind
+        if(_dst_fd >= 0) ::unlink(_filename.c_str());
         ROCPROFSYS_VERBOSE(
             0, "perfetto trace data is empty. File '%s' will not be written...\n",
             _filename.c_str());
     }
 
-    auto& _tmp_file = get_perfetto_tmp_file();
     if(_tmp_file)
     {
         _tmp_file->close();
@@ -0,0 +1,234 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "perfetto_merge.hpp"
+#include "common.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace rocprofsys
+{
+namespace perfetto
+{
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr size_t fallback_chunk_size = 4 * 1024 * 1024;
+
+ssize_t
+get_file_size(const std::string& _fname)
+{
+    struct stat _stat = {};
+    if(::stat(_fname.c_str(), &_stat) != 0) return -1;
+    return _stat.st_size;
+}
+
+bool
+ends_with(const std::string& _v, std::string_view _suffix)
+{
+    return _v.length() >= _suffix.length() &&
+           _v.compare(_v.length() - _suffix.length(), _suffix.length(), _suffix) == 0;
+}
+
+// copies _nbytes from the start of _in_fd to _offset in _out_fd without changing the
+// file position of _out_fd so that multiple threads can write to the same output
+bool
+copy_range(int _in_fd, int _out_fd, size_t _nbytes, off_t _offset)
+{
+    off_t _in_off = 0;
+#if defined(SYS_copy_file_range)
+    while(static_cast<size_t>(_in_off) < _nbytes)
+    {
+        auto _n = ::syscall(SYS_copy_file_range, _in_fd, &_in_off, _out_fd, &_offset,
+                            _nbytes - _in_off, 0U);
+        if(_n > 0 || (_n < 0 && errno == EINTR)) continue;
+        if(_n == 0) return false;
+        // e.g. ENOSYS, EXDEV, or EINVAL: fall back to the copy through user-space
+        break;
+    }
+#endif
+
+    auto _buffer = std::vector<char>{};
+    while(static_cast<size_t>(_in_off) < _nbytes)
+    {
+        if(_buffer.empty())
+            _buffer.resize(std::min<size_t>(fallback_chunk_size, _nbytes - _in_off));
+        auto _n = ::pread(_in_fd, _buffer.data(),
+                          std::min<size_t>(_buffer.size(), _nbytes - _in_off), _in_off);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0) return false;
+        for(ssize_t _w = 0; _w < _n;)
+        {
+            auto _nw = ::pwrite(_out_fd, _buffer.data() + _w, _n - _w, _offset + _w);
+            if(_nw < 0 && errno == EINTR) continue;
+            if(_nw <= 0) return false;
+            _w += _nw;
+        }
+        _in_off += _n;
+        _offset += _n;
+    }
+    return true;
+}
+}  // namespace
+
+std::vector<std::string>
+get_merge_inputs(const std::string& _dir)
+{
+    auto _inputs = std::vector<std::string>{};
+    auto* _dp    = ::opendir(_dir.c_str());
+    if(!_dp) return _inputs;
+
+    while(auto* _entry = ::readdir(_dp))
+    {
+        auto _name = std::string{ _entry->d_name };
+        if(_name == merged_trace_name || !ends_with(_name, ".proto")) continue;
+        auto _path = JOIN('/', _dir, _name);
+        struct stat _stat = {};
+        if(::stat(_path.c_str(), &_stat) == 0 && S_ISREG(_stat.st_mode))
+            _inputs.emplace_back(std::move(_path));
+    }
+    ::closedir(_dp);
+
+    std::sort(_inputs.begin(), _inputs.end());
+    return _inputs;
+}
+
+merge_result
+merge_traces(const std::vector<std::string>& _inputs, const std::string& _output,
+             size_t _nthreads)
+{
+    auto _beg    = clock_type::now();
+    auto _result = merge_result{ false, _output, _inputs, 0, 0.0 };
+
+    // the offset of each input in the output, the last entry is the total size
+    auto _offsets = std::vector<off_t>{};
+    _offsets.reserve(_inputs.size() + 1);
+    for(const auto& itr : _inputs)
+    {
+        auto _size = get_file_size(itr);
+        if(_size < 0)
+        {
+            ROCPROFSYS_VERBOSE(0, "[perfetto] cannot merge '%s' :: %s\n", itr.c_str(),
+                               strerror(errno));
+            return _result;
+        }
+        _offsets.emplace_back(_result.bytes);
+        _result.bytes += _size;
+    }
+    _offsets.emplace_back(_result.bytes);
+
+    auto _tmp_output = JOIN("", _output, ".part");
+    int  _out_fd     = ::open(_tmp_output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(_out_fd < 0)
+    {
+        ROCPROFSYS_VERBOSE(0, "[perfetto] cannot open '%s' :: %s\n", _tmp_output.c_str(),
+                           strerror(errno));
+        return _result;
+    }
+
+    if(_nthreads == 0)
+        _nthreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    _nthreads = std::min<size_t>(std::min<size_t>(_nthreads, 16), _inputs.size());
+
+    auto _ok    = std::atomic<bool>{ ::ftruncate(_out_fd, _result.bytes) == 0 };
+    auto _next  = std::atomic<size_t>{ 0 };
+    auto _merge = [&]() {
+        for(size_t i = _next++; i < _inputs.size() && _ok; i = _next++)
+        {
+            int  _in_fd  = ::open(_inputs.at(i).c_str(), O_RDONLY);
+            auto _nbytes = _offsets.at(i + 1) - _offsets.at(i);
+            if(_in_fd < 0 || !copy_range(_in_fd, _out_fd, _nbytes, _offsets.at(i)))
+            {
+                ROCPROFSYS_VERBOSE(0, "[perfetto] failed to merge '%s' :: %s\n",
+                                   _inputs.at(i).c_str(), strerror(errno));
+                _ok = false;
+            }
+            if(_in_fd >= 0) ::close(_in_fd);
+        }
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 1; i < _nthreads; ++i)
+        _threads.emplace_back(_merge);
+    _merge();
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(::close(_out_fd) != 0) _ok = false;
+
+    if(_ok && ::rename(_tmp_output.c_str(), _output.c_str()) == 0)
+        _result.success = true;
+    else
+        ::unlink(_tmp_output.c_str());
+
+    _result.seconds = std::chrono::duration<double>{ clock_type::now() - _beg }.count();
+    return _result;
+}
+
+merge_result
+merge_directory(const std::string& _dir, size_t _nthreads)
+{
+    auto _inputs = get_merge_inputs(_dir);
+    if(_inputs.size() <= 1) return merge_result{ true, std::string{}, _inputs, 0, 0.0 };
+
+    // other processes may still be writing their traces so wait (up to a minute) until
+    // the sizes of the traces stop changing
+    auto _get_sizes = [&_inputs]() {
+        auto _v = std::vector<ssize_t>{};
+        _v.reserve(_inputs.size());
+        for(const auto& itr : _inputs)
+            _v.emplace_back(get_file_size(itr));
+        return _v;
+    };
+
+    auto _timeout = clock_type::now() + std::chrono::seconds{ 60 };
+    auto _sizes   = _get_sizes();
+    while(clock_type::now() < _timeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+        auto _current = _get_sizes();
+        if(_current == _sizes) break;
+        _sizes = std::move(_current);
+    }
+
+    return merge_traces(_inputs, JOIN('/', _dir, merged_trace_name), _nthreads);
+}
+}  // namespace perfetto
+}  // namespace rocprofsys
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace perfetto
+{
+struct merge_result
+{
+    bool                     success = false;
+    std::string              output  = {};
+    std::vector<std::string> inputs  = {};
+    size_t                   bytes   = 0;
+    double                   seconds = 0.0;
+};
+
+// name of the file written by merge_directory
+inline constexpr const char* merged_trace_name = "merged.proto";
+
+// the perfetto traces (*.proto) in a directory in lexicographical order, excluding the
+// output of a previous merge
+std::vector<std::string>
+get_merge_inputs(const std::string& _dir);
+
+// concatenates the traces into _output. A perfetto trace is a sequence of TracePacket
+// records so the concatenation is a valid trace. Each input is copied to its final
+// offset in the output by up to _nthreads threads (zero selects a default) via
+// copy_file_range, falling back to pread/pwrite. The output is written to a temporary
+// file and renamed so a partially merged trace is never visible.
+merge_result
+merge_traces(const std::vector<std::string>& _inputs, const std::string& _output,
+             size_t _nthreads = 0);
+
+// when the directory contains more than one trace, waits for the traces to stop
+// growing and merges them into <dir>/merged.proto
+merge_result
+merge_directory(const std::string& _dir, size_t _nthreads = 0);
+}  // namespace perfetto
+}  // namespace rocprofsys
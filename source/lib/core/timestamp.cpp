@@ -0,0 +1,235 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core/timestamp.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#endif
+
+namespace rocprofsys
+{
+namespace timestamp
+{
+tsc_state tsc_clock = {};
+
+namespace
+{
+// interval between the drift corrections
+constexpr uint64_t resync_interval_nsec = 1000000000UL;
+// errors larger than this, e.g. when CLOCK_REALTIME is stepped, are not slewed
+constexpr int64_t max_slew_nsec = 1000000L;
+// time over which the counter frequency is measured at startup
+constexpr long calibration_nsec = 20000000L;
+
+struct reference_point
+{
+    uint64_t counter = 0;
+    uint64_t nsec    = 0;
+};
+
+// the rate is measured over the time since this point. Only modified by the thread
+// holding tsc_clock.updating or before the clock is enabled
+reference_point initial_point     = {};
+uint64_t        counter_frequency = 0;
+clock_source    selected_clock    = clock_source::realtime;
+
+// pairs a counter value with CLOCK_REALTIME using the tightest of several
+// realtime-counter-realtime brackets
+reference_point
+get_reference_point()
+{
+    auto _best  = reference_point{};
+    auto _width = std::numeric_limits<uint64_t>::max();
+    for(int i = 0; i < 16; ++i)
+    {
+        auto _beg     = realtime_now();
+        auto _counter = read_counter();
+        auto _end     = realtime_now();
+        if(_end >= _beg && _end - _beg < _width)
+        {
+            _width = _end - _beg;
+            _best  = { _counter, _beg + (_width / 2) };
+        }
+    }
+    return _best;
+}
+
+uint64_t
+compute_mult(uint64_t _nsec, uint64_t _ticks)
+{
+    auto _v = (static_cast<unsigned __int128>(_nsec) << tsc_state::shift) / _ticks;
+    return static_cast<uint64_t>(_v);
+}
+
+void
+publish(const tsc_params& _params)
+{
+    auto _gen = tsc_clock.generation.load(std::memory_order_relaxed);
+    tsc_clock.params[(_gen + 1) & 1] = _params;
+    tsc_clock.generation.store(_gen + 1, std::memory_order_release);
+}
+
+bool
+calibrate()
+{
+    auto _beg = get_reference_point();
+    auto _req = timespec{ 0, calibration_nsec };
+    while(nanosleep(&_req, &_req) != 0 && errno == EINTR)
+    {}
+    auto _end = get_reference_point();
+
+    if(_end.counter <= _beg.counter || _end.nsec <= _beg.nsec) return false;
+
+    auto _ticks = _end.counter - _beg.counter;
+    auto _nsec  = _end.nsec - _beg.nsec;
+
+    counter_frequency = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(_ticks) * 1000000000UL) / _nsec);
+    initial_point = _beg;
+
+    auto _params    = tsc_params{};
+    _params.counter = _end.counter;
+    _params.nsec    = _end.nsec;
+    _params.mult    = compute_mult(_nsec, _ticks);
+    _params.resync  = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(counter_frequency) * resync_interval_nsec) /
+        1000000000UL);
+    publish(_params);
+
+    return (_params.mult > 0 && _params.resync > 0);
+}
+}  // namespace
+
+bool
+is_counter_invariant()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int _eax = 0;
+    unsigned int _ebx = 0;
+    unsigned int _ecx = 0;
+    unsigned int _edx = 0;
+    // CPUID.80000007H:EDX[8] is the invariant TSC flag
+    if(__get_cpuid(0x80000007, &_eax, &_ebx, &_ecx, &_edx) == 0) return false;
+    if((_edx & (1U << 8)) == 0) return false;
+
+    // the kernel switches to another clocksource when it finds the TSC is unstable or
+    // not synchronized between the sockets
+    constexpr auto _path =
+        "/sys/devices/system/clocksource/clocksource0/current_clocksource";
+    auto _ifs    = std::ifstream{ _path };
+    auto _source = std::string{};
+    if(_ifs && (_ifs >> _source)) return (_source == "tsc");
+    return true;
+#elif defined(__aarch64__)
+    // the generic timer has a fixed frequency and is synchronized across cores
+    return true;
+#else
+    return false;
+#endif
+}
+
+clock_source
+set_clock_source(clock_source _clock)
+{
+    if(_clock == clock_source::tsc && !tsc_clock.enabled.load(std::memory_order_acquire))
+    {
+        if(!is_counter_invariant() || !calibrate()) _clock = clock_source::realtime;
+    }
+
+    selected_clock = _clock;
+    tsc_clock.enabled.store(_clock == clock_source::tsc, std::memory_order_release);
+    return _clock;
+}
+
+clock_source
+get_clock_source()
+{
+    return selected_clock;
+}
+
+std::string_view
+get_clock_source_name(clock_source _clock)
+{
+    switch(_clock)
+    {
+        case clock_source::realtime: return "realtime";
+        case clock_source::tsc: return "tsc";
+    }
+    return "unknown";
+}
+
+uint64_t
+get_counter_frequency()
+{
+    return counter_frequency;
+}
+
+void
+correct_drift(uint64_t _counter)
+{
+    if(tsc_clock.updating.test_and_set(std::memory_order_acquire)) return;
+
+    auto _gen    = tsc_clock.generation.load(std::memory_order_acquire);
+    auto _params = tsc_clock.params[_gen & 1];
+
+    // already corrected by another thread
+    if(_counter <= _params.counter || _counter - _params.counter <= _params.resync)
+    {
+        tsc_clock.updating.clear(std::memory_order_release);
+        return;
+    }
+
+    // the new conversion starts where the current one ends so the clock is continuous
+    auto _ref      = get_reference_point();
+    auto _expected = convert(_params, _ref.counter);
+    auto _error    = static_cast<int64_t>(_ref.nsec - _expected);
+    auto _next     = tsc_params{ _ref.counter, _expected, _params.mult, _params.resync };
+
+    if(std::abs(_error) > max_slew_nsec || _ref.nsec <= initial_point.nsec ||
+       _ref.counter <= initial_point.counter)
+    {
+        // step to CLOCK_REALTIME and restart the measurement of the rate
+        _next.nsec    = _ref.nsec;
+        initial_point = _ref;
+    }
+    else
+    {
+        // long-term rate plus the slew which absorbs the error over the next interval
+        auto _mult = compute_mult(_ref.nsec - initial_point.nsec,
+                                  _ref.counter - initial_point.counter);
+        auto _slew = compute_mult(std::abs(_error), _params.resync);
+        _next.mult = (_error > 0) ? (_mult + _slew) : (_mult - _slew);
+    }
+
+    publish(_next);
+    tsc_clock.updating.clear(std::memory_order_release);
+}
+}  // namespace timestamp
+}  // namespace rocprofsys
@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+namespace rocprofsys
+{
+namespace timestamp
+{
+enum class clock_source : int
+{
+    realtime = 0,  // clock_gettime(CLOCK_REALTIME)
+    tsc,           // invariant cycle counter calibrated against CLOCK_REALTIME
+};
+
+// conversion of the cycle counter to CLOCK_REALTIME nanoseconds:
+//   nsec + (((counter_now - counter) * mult) >> shift)
+struct tsc_params
+{
+    uint64_t counter = 0;
+    uint64_t nsec    = 0;
+    uint64_t mult    = 0;
+    uint64_t resync  = 0;  // number of ticks after which the drift is corrected
+};
+
+// double-buffered so that readers, including signal handlers, never block: the writer
+// fills the inactive entry and then publishes it by incrementing the generation
+struct tsc_state
+{
+    static constexpr uint32_t shift = 32;
+
+    std::atomic<bool>     enabled{ false };
+    std::atomic<uint32_t> generation{ 0 };
+    std::atomic_flag      updating = ATOMIC_FLAG_INIT;
+    tsc_params            params[2] = {};
+};
+
+extern ROCPROFSYS_HIDDEN_API tsc_state tsc_clock;
+
+// the raw cycle counter: rdtsc on x86, cntvct_el0 on aarch64
+ROCPROFSYS_INLINE uint64_t
+read_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t _v = 0;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(_v)::"memory");
+    return _v;
+#else
+    return 0;
+#endif
+}
+
+// true when the cycle counter ticks at a constant rate, is synchronized across cores,
+// and has not been flagged as unstable by the kernel
+bool
+is_counter_invariant();
+
+// calibrates the cycle counter against CLOCK_REALTIME when the TSC clock is selected.
+// Falls back to CLOCK_REALTIME when the counter is not invariant. Returns the clock
+// which is used
+clock_source
+set_clock_source(clock_source);
+
+clock_source
+get_clock_source();
+
+std::string_view
+get_clock_source_name(clock_source);
+
+// frequency of the cycle counter measured during calibration (zero when not calibrated)
+uint64_t
+get_counter_frequency();
+
+// re-anchors the conversion to CLOCK_REALTIME and slews the rate so that the drift
+// accumulated since the previous correction is absorbed over the next interval. Only
+// one thread performs the correction, the others continue with the current conversion
+void
+correct_drift(uint64_t _counter);
+
+ROCPROFSYS_INLINE uint64_t
+realtime_now()
+{
+    struct timespec _ts;
+    clock_gettime(CLOCK_REALTIME, &_ts);
+    return (static_cast<uint64_t>(_ts.tv_sec) * 1000000000UL) +
+           static_cast<uint64_t>(_ts.tv_nsec);
+}
+
+ROCPROFSYS_INLINE uint64_t
+convert(const tsc_params& _params, uint64_t _counter)
+{
+    // the counter may be slightly behind the anchor when read on another core
+    if(ROCPROFSYS_UNLIKELY(_counter < _params.counter)) return _params.nsec;
+    auto _delta = static_cast<unsigned __int128>(_counter - _params.counter);
+    return _params.nsec +
+           static_cast<uint64_t>((_delta * _params.mult) >> tsc_state::shift);
+}
+
+ROCPROFSYS_INLINE uint64_t
+tsc_now()
+{
+    auto _counter = read_counter();
+    auto _gen     = tsc_clock.generation.load(std::memory_order_acquire);
+    if(ROCPROFSYS_UNLIKELY(_counter - tsc_clock.params[_gen & 1].counter >
+                           tsc_clock.params[_gen & 1].resync))
+    {
+        correct_drift(_counter);
+        _gen = tsc_clock.generation.load(std::memory_order_acquire);
+    }
+
+    // retry when a correction was published while converting
+    uint64_t _nsec = 0;
+    uint32_t _prev = 0;
+    do
+    {
+        _prev = _gen;
+        _nsec = convert(tsc_clock.params[_gen & 1], _counter);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        _gen = tsc_clock.generation.load(std::memory_order_acquire);
+    } while(ROCPROFSYS_UNLIKELY(_gen != _prev));
+    return _nsec;
+}
+
+// timestamp in nanoseconds since the epoch from the selected clock
+ROCPROFSYS_INLINE uint64_t
+now()
+{
+    if(tsc_clock.enabled.load(std::memory_order_relaxed)) return tsc_now();
+    return realtime_now();
+}
+}  // namespace timestamp
+}  // namespace rocprofsys
@@ -307,9 +307,21 @@ struct ROCPROFSYS_INTERNAL_API indirect
         ROCPROFSYS_DLSYM(rocprofsys_set_mpi_f, m_omnihandle, "rocprofsys_set_mpi");
         ROCPROFSYS_DLSYM(rocprofsys_push_trace_f, m_omnihandle, "rocprofsys_push_trace");
         ROCPROFSYS_DLSYM(rocprofsys_pop_trace_f, m_omnihandle, "rocprofsys_pop_trace");
+        ROCPROFSYS_DLSYM(rocprofsys_register_trace_ids_f, m_omnihandle,
+                         "rocprofsys_register_trace_ids");
+        ROCPROFSYS_DLSYM(rocprofsys_push_trace_id_f, m_omnihandle,
+                         "rocprofsys_push_trace_id");
+        ROCPROFSYS_DLSYM(rocprofsys_pop_trace_id_f, m_omnihandle,
+                         "rocprofsys_pop_trace_id");
         ROCPROFSYS_DLSYM(rocprofsys_push_region_f, m_omnihandle,
                          "rocprofsys_push_region");
         ROCPROFSYS_DLSYM(rocprofsys_pop_region_f, m_omnihandle, "rocprofsys_pop_region");
+        ROCPROFSYS_DLSYM(rocprofsys_register_region_f, m_omnihandle,
+                         "rocprofsys_register_region");
+        ROCPROFSYS_DLSYM(rocprofsys_push_region_h_f, m_omnihandle,
+                         "rocprofsys_push_region_h");
+        ROCPROFSYS_DLSYM(rocprofsys_pop_region_h_f, m_omnihandle,
+                         "rocprofsys_pop_region_h");
         ROCPROFSYS_DLSYM(rocprofsys_push_category_region_f, m_omnihandle,
                          "rocprofsys_push_category_region");
         ROCPROFSYS_DLSYM(rocprofsys_pop_category_region_f, m_omnihandle,
@@ -318,6 +330,10 @@ struct ROCPROFSYS_INTERNAL_API indirect
                          "rocprofsys_register_source");
         ROCPROFSYS_DLSYM(rocprofsys_register_coverage_f, m_omnihandle,
                          "rocprofsys_register_coverage");
+        ROCPROFSYS_DLSYM(rocprofsys_register_source_id_f, m_omnihandle,
+                         "rocprofsys_register_source_id");
+        ROCPROFSYS_DLSYM(rocprofsys_register_coverage_id_f, m_omnihandle,
+                         "rocprofsys_register_coverage_id");
         ROCPROFSYS_DLSYM(rocprofsys_progress_f, m_omnihandle, "rocprofsys_progress");
         ROCPROFSYS_DLSYM(rocprofsys_annotated_progress_f, m_omnihandle,
                          "rocprofsys_annotated_progress");
@@ -397,6 +413,9 @@ struct ROCPROFSYS_INTERNAL_API indirect
             _cb.push_annotated_region       = &rocprofsys_user_push_annotated_region_dl;
             _cb.pop_annotated_region        = &rocprofsys_user_pop_annotated_region_dl;
             _cb.annotated_progress          = &rocprofsys_user_annotated_progress_dl;
+            _cb.register_region             = &rocprofsys_user_register_region_dl;
+            _cb.push_region_h               = &rocprofsys_user_push_region_h_dl;
+            _cb.pop_region_h                = &rocprofsys_user_pop_region_h_dl;
             (*rocprofsys_user_configure_f)(ROCPROFSYS_USER_REPLACE_CONFIG, _cb, nullptr);
         }
     }
@@ -414,10 +433,19 @@ public:
     void (*rocprofsys_register_source_f)(const char*, const char*, size_t, size_t,
                                          const char*)                          = nullptr;
     void (*rocprofsys_register_coverage_f)(const char*, const char*, size_t)   = nullptr;
+    void (*rocprofsys_register_source_id_f)(size_t, const char*, const char*, size_t,
+                                            size_t, const char*)               = nullptr;
+    void (*rocprofsys_register_coverage_id_f)(size_t, size_t)                  = nullptr;
     void (*rocprofsys_push_trace_f)(const char*)                               = nullptr;
     void (*rocprofsys_pop_trace_f)(const char*)                                = nullptr;
+    void (*rocprofsys_register_trace_ids_f)(uint32_t*, uint32_t, const char*)  = nullptr;
+    void (*rocprofsys_push_trace_id_f)(uint32_t)                               = nullptr;
+    void (*rocprofsys_pop_trace_id_f)(uint32_t)                                = nullptr;
     int (*rocprofsys_push_region_f)(const char*)                               = nullptr;
     int (*rocprofsys_pop_region_f)(const char*)                                = nullptr;
+    uint64_t (*rocprofsys_register_region_f)(const char*)                      = nullptr;
+    int (*rocprofsys_push_region_h_f)(uint64_t)                                = nullptr;
+    int (*rocprofsys_pop_region_h_f)(uint64_t)                                 = nullptr;
     int (*rocprofsys_push_category_region_f)(rocprofsys_category_t, const char*,
                                              rocprofsys_annotation_t*, size_t) = nullptr;
     int (*rocprofsys_pop_category_region_f)(rocprofsys_category_t, const char*,
@@ -705,6 +733,40 @@ extern "C"
         }
     }
 
+    void rocprofsys_register_trace_ids(uint32_t* base, uint32_t count,
+                                       const char* names)
+    {
+        ROCPROFSYS_DL_LOG(3, "%s(%p, %u)\n", __FUNCTION__, (void*) base, count);
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_trace_ids_f, base, count,
+                             names);
+    }
+
+    void rocprofsys_push_trace_id(uint32_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_push_trace_id_f, id);
+        }
+        else
+        {
+            ++dl::get_thread_count();
+        }
+    }
+
+    void rocprofsys_pop_trace_id(uint32_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_pop_trace_id_f, id);
+        }
+        else
+        {
+            if(dl::get_thread_count()-- == 0) rocprofsys_user_start_thread_trace_dl();
+        }
+    }
+
     int rocprofsys_push_region(const char* name)
     {
         if(!dl::get_active()) return 0;
@@ -804,6 +866,21 @@ extern "C"
                              address);
     }
 
+    void rocprofsys_register_source_id(size_t id, const char* file, const char* func,
+                                       size_t line, size_t address, const char* source)
+    {
+        ROCPROFSYS_DL_LOG(3, "%s(%zu, \"%s\", \"%s\", %zu, %zu, \"%s\")\n", __FUNCTION__,
+                          id, file, func, line, address, source);
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_source_id_f, id, file,
+                             func, line, address, source);
+    }
+
+    void rocprofsys_register_coverage_id(size_t id, size_t address)
+    {
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_coverage_id_f, id,
+                             address);
+    }
+
     int rocprofsys_user_start_trace_dl(void)
     {
         dl::get_enabled().store(true);
@@ -840,6 +917,23 @@ extern "C"
         return ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_pop_region_f, name);
     }
 
+    rocprofsys_region_handle_t rocprofsys_user_register_region_dl(const char* name)
+    {
+        return ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_region_f, name);
+    }
+
+    int rocprofsys_user_push_region_h_dl(rocprofsys_region_handle_t _handle)
+    {
+        if(!dl::get_active()) return 0;
+        return ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_push_region_h_f, _handle);
+    }
+
+    int rocprofsys_user_pop_region_h_dl(rocprofsys_region_handle_t _handle)
+    {
+        if(!dl::get_active()) return 0;
+        return ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_pop_region_h_f, _handle);
+    }
+
     int rocprofsys_user_progress_dl(const char* name)
     {
         ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_progress_f, name);
@@ -32,6 +32,7 @@
 #endif
 
 #include "rocprofiler-systems/user.h"
+#include "trace_id.hpp"
 
 #include <atomic>
 #include <cstdint>
@@ -75,6 +76,10 @@ extern "C"
     void rocprofsys_set_instrumented(int) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_push_trace(const char* name) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_pop_trace(const char* name) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_trace_ids(uint32_t* base, uint32_t count,
+                                       const char* names) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_push_trace_id(uint32_t id) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_pop_trace_id(uint32_t id) ROCPROFSYS_PUBLIC_API;
     int  rocprofsys_push_region(const char*) ROCPROFSYS_PUBLIC_API;
     int  rocprofsys_pop_region(const char*) ROCPROFSYS_PUBLIC_API;
     int  rocprofsys_push_category_region(rocprofsys_category_t, const char*,
@@ -89,6 +94,10 @@ extern "C"
                                     const char* source) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_register_coverage(const char* file, const char* func,
                                       size_t address) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_source_id(size_t id, const char* file, const char* func,
+                                       size_t line, size_t address,
+                                       const char* source) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_coverage_id(size_t id, size_t address) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_progress(const char*) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_annotated_progress(const char*, rocprofsys_annotation_t*,
                                        size_t) ROCPROFSYS_PUBLIC_API;
@@ -106,6 +115,13 @@ extern "C"
     int rocprofsys_user_push_region_dl(const char*) ROCPROFSYS_HIDDEN_API;
     int rocprofsys_user_pop_region_dl(const char*) ROCPROFSYS_HIDDEN_API;
 
+    rocprofsys_region_handle_t rocprofsys_user_register_region_dl(const char*)
+        ROCPROFSYS_HIDDEN_API;
+    int rocprofsys_user_push_region_h_dl(rocprofsys_region_handle_t)
+        ROCPROFSYS_HIDDEN_API;
+    int rocprofsys_user_pop_region_h_dl(rocprofsys_region_handle_t)
+        ROCPROFSYS_HIDDEN_API;
+
     int rocprofsys_user_push_annotated_region_dl(const char*, rocprofsys_annotation_t*,
                                                  size_t) ROCPROFSYS_HIDDEN_API;
     int rocprofsys_user_pop_annotated_region_dl(const char*, rocprofsys_annotation_t*,
@@ -194,7 +210,7 @@ enum class InstrumentMode : int
     PythonProfile = 3,  // python setprofile
     Last,
 };
-}
+}  // namespace dl
 }  // namespace rocprofsys
 
 #endif  // ROCPROFSYS_DL_HPP_ 1
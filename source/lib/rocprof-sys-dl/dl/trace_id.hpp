@@ -0,0 +1,44 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ROCPROFSYS_DL_TRACE_ID_HPP_
+#define ROCPROFSYS_DL_TRACE_ID_HPP_
+
+#include <cstdint>
+
+// shared by rocprof-sys-instrument (which assigns the ids), rocprof-sys-dl, and the
+// runtime library (which decodes them) so this header must not depend on either library
+
+namespace rocprofsys
+{
+namespace dl
+{
+// the function ids passed to rocprofsys_push_trace_id and rocprofsys_pop_trace_id: the
+// upper bits identify the instrumented binary and the lower bits are a dense index of
+// the function within that binary. The upper bits are assigned by the runtime when the
+// binary registers its function names so zero identifies an unregistered binary
+inline constexpr uint32_t trace_id_index_bits = 20;
+inline constexpr uint32_t trace_id_index_max  = (1U << trace_id_index_bits);
+}  // namespace dl
+}  // namespace rocprofsys
+
+#endif  // ROCPROFSYS_DL_TRACE_ID_HPP_
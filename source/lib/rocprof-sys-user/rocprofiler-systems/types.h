@@ -37,6 +37,13 @@ extern "C"
     typedef int (*rocprofsys_annotated_region_func_t)(const char*, rocprofsys_annotation*,
                                                       size_t);
 
+    /// @typedef rocprofsys_region_handle_t
+    /// @brief Opaque identifier for a region registered via
+    /// rocprofsys_user_register_region. A value of zero is never a valid handle.
+    typedef uint64_t rocprofsys_region_handle_t;
+    typedef rocprofsys_region_handle_t (*rocprofsys_register_region_func_t)(const char*);
+    typedef int (*rocprofsys_region_handle_func_t)(rocprofsys_region_handle_t);
+
     /// @struct rocprofsys_user_callbacks
     /// @brief Struct containing the callbacks for the user API
     ///
@@ -53,6 +60,9 @@ extern "C"
         rocprofsys_annotated_region_func_t push_annotated_region;
         rocprofsys_annotated_region_func_t pop_annotated_region;
         rocprofsys_annotated_region_func_t annotated_progress;
+        rocprofsys_register_region_func_t  register_region;
+        rocprofsys_region_handle_func_t    push_region_h;
+        rocprofsys_region_handle_func_t    pop_region_h;
 
         /// @var start_trace
         /// @brief callback for enabling tracing globally
@@ -74,6 +84,12 @@ extern "C"
         /// @brief callback for ending a trace region + annotations
         /// @var annotated_progress
         /// @brief callback for marking an causal profiling event + annotations
+        /// @var register_region
+        /// @brief callback for registering a region name and obtaining a handle
+        /// @var push_region_h
+        /// @brief callback for starting a trace region from a registered handle
+        /// @var pop_region_h
+        /// @brief callback for ending a trace region from a registered handle
     } rocprofsys_user_callbacks_t;
 
     /// @enum ROCPROFSYS_USER_CONFIGURE_MODE
@@ -111,7 +127,7 @@ extern "C"
 #ifndef ROCPROFSYS_USER_CALLBACKS_INIT
 #    define ROCPROFSYS_USER_CALLBACKS_INIT                                               \
         {                                                                                \
-            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL                   \
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL \
         }
 #endif
 
@@ -80,6 +80,35 @@ extern "C"
     /// results in timemory vs. perfetto.
     extern int rocprofsys_user_pop_region(const char*) ROCPROFSYS_PUBLIC_API;
 
+    /// @fn rocprofsys_region_handle_t rocprofsys_user_register_region(const char* id)
+    /// @param id The string identifier for the region
+    /// @return A non-zero handle on success, zero on failure
+    /// @brief Register a user defined region name once and obtain a handle which can be
+    /// passed to @ref rocprofsys_user_push_region_h and
+    /// @ref rocprofsys_user_pop_region_h. The name is hashed and interned at registration
+    /// so pushing/popping via the handle avoids the per-call string hashing of
+    /// @ref rocprofsys_user_push_region.
+    /// Registering the same name multiple times returns the same handle. A region can be
+    /// registered before rocprof-sys is initialized (e.g. from a static initializer):
+    /// the handle is bound to the region on the first push/pop after initialization.
+    extern rocprofsys_region_handle_t rocprofsys_user_register_region(const char*)
+        ROCPROFSYS_PUBLIC_API;
+
+    /// @fn int rocprofsys_user_push_region_h(rocprofsys_region_handle_t handle)
+    /// @param handle Value returned by @ref rocprofsys_user_register_region
+    /// @return rocprofsys_user_error_t value
+    /// @brief Start a user defined region identified by a registered handle.
+    extern int rocprofsys_user_push_region_h(rocprofsys_region_handle_t)
+        ROCPROFSYS_PUBLIC_API;
+
+    /// @fn int rocprofsys_user_pop_region_h(rocprofsys_region_handle_t handle)
+    /// @param handle Value returned by @ref rocprofsys_user_register_region
+    /// @return rocprofsys_user_error_t value
+    /// @brief End a user defined region identified by a registered handle. The same
+    /// ordering considerations as @ref rocprofsys_user_pop_region apply.
+    extern int rocprofsys_user_pop_region_h(rocprofsys_region_handle_t)
+        ROCPROFSYS_PUBLIC_API;
+
     /// @typedef rocprofsys_annotation rocprofsys_annotation_t
     ///
     /// @fn int rocprofsys_user_push_annotated_region(const char* id,
@@ -31,7 +31,10 @@
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <unordered_map>
 
 using annotation_t = rocprofsys_annotation_t;
 
@@ -52,6 +55,45 @@ invoke(int (*_func)(Args...), Args... args)
     if((*_func)(args...) != 0) return ROCPROFSYS_USER_ERROR_INTERNAL;
     return ROCPROFSYS_USER_SUCCESS;
 }
+
+// a region registered before the tool provided the register_region callback (e.g. from
+// a static initializer). The handle given to the user is the address of the entry with
+// the lowest bit set (the handles of the tool are aligned addresses) and it is bound to
+// the handle of the tool on the first push/pop after the callback is available
+struct lazy_region
+{
+    std::string                             name   = {};
+    std::atomic<rocprofsys_region_handle_t> handle = {};
+};
+
+constexpr rocprofsys_region_handle_t lazy_region_bit = 1;
+
+std::mutex&
+get_lazy_region_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+auto&
+get_lazy_regions()
+{
+    static auto* _v = new std::unordered_map<std::string, lazy_region*>{};
+    return *_v;
+}
+
+rocprofsys_region_handle_t
+bind_lazy_region(rocprofsys_region_handle_t _handle)
+{
+    auto* _entry = reinterpret_cast<lazy_region*>(_handle & ~lazy_region_bit);
+    auto  _v     = _entry->handle.load(std::memory_order_acquire);
+    if(_v == 0 && _callbacks.register_region)
+    {
+        _v = (*_callbacks.register_region)(_entry->name.c_str());
+        _entry->handle.store(_v, std::memory_order_release);
+    }
+    return _v;
+}
 }  // namespace
 
 extern "C"
@@ -80,6 +122,51 @@ extern "C"
         return invoke(_callbacks.pop_region, id);
     }
 
+    rocprofsys_region_handle_t rocprofsys_user_register_region(const char* id)
+    {
+        if(!id) return 0;
+
+        auto  _lk      = std::unique_lock<std::mutex>{ get_lazy_region_mutex() };
+        auto& _regions = get_lazy_regions();
+
+        // a name registered before the tool was available keeps its handle
+        auto itr = _regions.find(id);
+        if(itr != _regions.end())
+            return reinterpret_cast<rocprofsys_region_handle_t>(itr->second) |
+                   lazy_region_bit;
+
+        if(_callbacks.register_region)
+        {
+            auto _v = (*_callbacks.register_region)(id);
+            if(_v != 0) return _v;
+        }
+
+        auto* _entry = _regions.emplace(id, new lazy_region{ id, {} }).first->second;
+        return reinterpret_cast<rocprofsys_region_handle_t>(_entry) | lazy_region_bit;
+    }
+
+    int rocprofsys_user_push_region_h(rocprofsys_region_handle_t _handle)
+    {
+        if(_handle == 0) return ROCPROFSYS_USER_ERROR_BAD_VALUE;
+        if((_handle & lazy_region_bit) != 0)
+        {
+            _handle = bind_lazy_region(_handle);
+            if(_handle == 0) return ROCPROFSYS_USER_ERROR_NO_BINDING;
+        }
+        return invoke(_callbacks.push_region_h, _handle);
+    }
+
+    int rocprofsys_user_pop_region_h(rocprofsys_region_handle_t _handle)
+    {
+        if(_handle == 0) return ROCPROFSYS_USER_ERROR_BAD_VALUE;
+        if((_handle & lazy_region_bit) != 0)
+        {
+            _handle = bind_lazy_region(_handle);
+            if(_handle == 0) return ROCPROFSYS_USER_ERROR_NO_BINDING;
+        }
+        return invoke(_callbacks.pop_region_h, _handle);
+    }
+
     int rocprofsys_user_progress(const char* id)
     {
         return invoke(_callbacks.progress, id);
@@ -136,6 +223,9 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_h, inp.push_region_h);
+                _update(_v.pop_region_h, inp.pop_region_h);
 
                 _callbacks = _v;
                 break;
@@ -158,6 +248,9 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_h, inp.push_region_h);
+                _update(_v.pop_region_h, inp.pop_region_h);
 
                 _callbacks = _v;
                 break;
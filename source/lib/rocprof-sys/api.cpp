@@ -38,6 +38,24 @@ rocprofsys_pop_trace(const char* _name)
     rocprofsys_pop_trace_hidden(_name);
 }
 
+extern "C" void
+rocprofsys_register_trace_ids(uint32_t* base, uint32_t count, const char* names)
+{
+    rocprofsys_register_trace_ids_hidden(base, count, names);
+}
+
+extern "C" void
+rocprofsys_push_trace_id(uint32_t id)
+{
+    rocprofsys_push_trace_id_hidden(id);
+}
+
+extern "C" void
+rocprofsys_pop_trace_id(uint32_t id)
+{
+    rocprofsys_pop_trace_id_hidden(id);
+}
+
 extern "C" int
 rocprofsys_push_region(const char* _name)
 {
@@ -66,6 +84,47 @@ rocprofsys_pop_region(const char* _name)
     return 0;
 }
 
+extern "C" uint64_t
+rocprofsys_register_region(const char* _name)
+{
+    try
+    {
+        return rocprofsys_register_region_hidden(_name);
+    } catch(std::exception& _e)
+    {
+        ROCPROFSYS_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+    return 0;
+}
+
+extern "C" int
+rocprofsys_push_region_h(uint64_t _handle)
+{
+    try
+    {
+        rocprofsys_push_region_h_hidden(_handle);
+    } catch(std::exception& _e)
+    {
+        ROCPROFSYS_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+rocprofsys_pop_region_h(uint64_t _handle)
+{
+    try
+    {
+        rocprofsys_pop_region_h_hidden(_handle);
+    } catch(std::exception& _e)
+    {
+        ROCPROFSYS_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
 extern "C" int
 rocprofsys_push_category_region(rocprofsys_category_t _category, const char* _name,
                                 rocprofsys_annotation_t* _annotations,
@@ -167,3 +226,16 @@ rocprofsys_register_coverage(const char* file, const char* func, size_t address)
 {
     rocprofsys_register_coverage_hidden(file, func, address);
 }
+
+extern "C" void
+rocprofsys_register_source_id(size_t id, const char* file, const char* func,
+                              size_t line, size_t address, const char* source)
+{
+    rocprofsys_register_source_id_hidden(id, file, func, line, address, source);
+}
+
+extern "C" void
+rocprofsys_register_coverage_id(size_t id, size_t address)
+{
+    rocprofsys_register_coverage_id_hidden(id, address);
+}
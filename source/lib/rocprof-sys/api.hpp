@@ -59,12 +59,34 @@ extern "C"
     /// stops an instrumentation region
     void rocprofsys_pop_trace(const char*) ROCPROFSYS_PUBLIC_API;
 
+    /// registers the names of the instrumented functions of a binary, separated by
+    /// newlines, in the order of the indices assigned by rocprof-sys-instrument and
+    /// stores the base which is added to those indices in the given variable
+    void rocprofsys_register_trace_ids(uint32_t* base, uint32_t count,
+                                       const char* names) ROCPROFSYS_PUBLIC_API;
+
+    /// starts an instrumentation region from a registered function id
+    void rocprofsys_push_trace_id(uint32_t) ROCPROFSYS_PUBLIC_API;
+
+    /// stops an instrumentation region from a registered function id
+    void rocprofsys_pop_trace_id(uint32_t) ROCPROFSYS_PUBLIC_API;
+
     /// starts an instrumentation region (user-defined)
     int rocprofsys_push_region(const char*) ROCPROFSYS_PUBLIC_API;
 
     /// stops an instrumentation region (user-defined)
     int rocprofsys_pop_region(const char*) ROCPROFSYS_PUBLIC_API;
 
+    /// registers a region name (user-defined) and returns a handle for it (zero on
+    /// failure)
+    uint64_t rocprofsys_register_region(const char*) ROCPROFSYS_PUBLIC_API;
+
+    /// starts an instrumentation region (user-defined) from a registered handle
+    int rocprofsys_push_region_h(uint64_t) ROCPROFSYS_PUBLIC_API;
+
+    /// stops an instrumentation region (user-defined) from a registered handle
+    int rocprofsys_pop_region_h(uint64_t) ROCPROFSYS_PUBLIC_API;
+
     /// starts an instrumentation region in a user-defined category and (optionally)
     /// adds annotations to the perfetto trace.
     int rocprofsys_push_category_region(rocprofsys_category_t, const char*,
@@ -86,6 +108,14 @@ extern "C"
     void rocprofsys_register_coverage(const char* file, const char* func,
                                       size_t address) ROCPROFSYS_PUBLIC_API;
 
+    /// stores source code information for the coverage entry with the given id
+    void rocprofsys_register_source_id(size_t id, const char* file, const char* func,
+                                       size_t line, size_t address,
+                                       const char* source) ROCPROFSYS_PUBLIC_API;
+
+    /// increments the coverage value of the entry with the given id
+    void rocprofsys_register_coverage_id(size_t id, size_t address) ROCPROFSYS_PUBLIC_API;
+
     /// mark causal progress
     void rocprofsys_progress(const char*) ROCPROFSYS_PUBLIC_API;
 
@@ -103,8 +133,15 @@ extern "C"
     void rocprofsys_set_mpi_hidden(bool, bool) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_push_trace_hidden(const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_pop_trace_hidden(const char*) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_trace_ids_hidden(uint32_t*, uint32_t,
+                                              const char*) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_push_trace_id_hidden(uint32_t) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_pop_trace_id_hidden(uint32_t) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_push_region_hidden(const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_pop_region_hidden(const char*) ROCPROFSYS_HIDDEN_API;
+    uint64_t rocprofsys_register_region_hidden(const char*) ROCPROFSYS_HIDDEN_API;
+    void     rocprofsys_push_region_h_hidden(uint64_t) ROCPROFSYS_HIDDEN_API;
+    void     rocprofsys_pop_region_h_hidden(uint64_t) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_push_category_region_hidden(rocprofsys_category_t, const char*,
                                                 rocprofsys_annotation_t*,
                                                 size_t) ROCPROFSYS_HIDDEN_API;
@@ -115,6 +152,9 @@ extern "C"
                                            const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_register_coverage_hidden(const char*, const char*,
                                              size_t) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_source_id_hidden(size_t, const char*, const char*, size_t,
+                                              size_t, const char*) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_coverage_id_hidden(size_t, size_t) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_progress_hidden(const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_annotated_progress_hidden(const char*, rocprofsys_annotation_t*,
                                               size_t) ROCPROFSYS_HIDDEN_API;
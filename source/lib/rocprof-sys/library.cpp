@@ -38,6 +38,7 @@
 #include "core/locking.hpp"
 #include "core/perfetto_fwd.hpp"
 #include "core/timemory.hpp"
+#include "core/timestamp.hpp"
 #include "core/utility.hpp"
 #include "library/causal/data.hpp"
 #include "library/causal/experiment.hpp"
@@ -48,6 +49,7 @@
 #include "library/components/numa_gotcha.hpp"
 #include "library/components/pthread_gotcha.hpp"
 #include "library/coverage.hpp"
+#include "library/event_log.hpp"
 #include "library/ompt.hpp"
 #include "library/process_sampler.hpp"
 #include "library/ptl.hpp"
@@ -57,6 +59,7 @@
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/throttle.hpp"
 #include "library/tracing.hpp"
 #include "rocprofiler-systems/categories.h"  // in rocprof-sys-user
 
@@ -446,6 +449,22 @@ rocprofsys_init_tooling_hidden()
 
     ROCPROFSYS_DEBUG_F("\n");
 
+    if(config::get_timestamp_tsc_clock())
+    {
+        if(timestamp::set_clock_source(timestamp::clock_source::tsc) ==
+           timestamp::clock_source::tsc)
+        {
+            ROCPROFSYS_VERBOSE_F(1, "Timestamp clock: tsc (%.3f MHz)\n",
+                                 timestamp::get_counter_frequency() / 1.0e6);
+        }
+        else
+        {
+            ROCPROFSYS_WARNING_F(0,
+                                 "Timestamp clock: the cycle counter is not invariant. "
+                                 "Falling back to CLOCK_REALTIME...\n");
+        }
+    }
+
     auto _dtor = scope::destructor{ []() {
         // if set to finalized, don't continue
         if(get_state() > State::Active) return;
@@ -472,6 +491,8 @@ rocprofsys_init_tooling_hidden()
             push_enable_sampling_on_child_threads(get_use_sampling());
             sampling::unblock_signals();
         }
+        event_log::setup();
+        throttle::setup();
         get_main_bundle()->start();
         ROCPROFSYS_DEBUG_F("State: %s -> State::Active\n",
                            std::to_string(get_state()).c_str());
@@ -692,7 +713,7 @@ rocprofsys_finalize_hidden(void)
 
     sampling::block_samples();
 
-    thread_info::set_stop(comp::wall_clock::record());
+    thread_info::set_stop(tracing::now());
 
     tim::signals::block_signals(get_sampling_signals(),
                                 tim::signals::sigmask_scope::process);
@@ -898,6 +919,18 @@ rocprofsys_finalize_hidden(void)
         process_sampler::post_process();
     }
 
+    if(event_log::is_active())
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Post-processing the event logs...\n");
+        event_log::post_process();
+    }
+
+    if(throttle::is_active())
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Reporting the throttled functions...\n");
+        throttle::post_process();
+    }
+
     // shutdown tasking before timemory is finalized
     ROCPROFSYS_VERBOSE_F(1, "Shutting down thread-pools...\n");
     tasking::shutdown();
@@ -293,6 +293,7 @@ compute_eligible_lines_impl()
     for(const auto& litr : _binary_info)
     {
         auto& _scoped    = _scoped_info.emplace_back();
+        _scoped.name     = litr.name;
         _scoped.bfd      = litr.bfd;
         _scoped.mappings = litr.mappings;
         _scoped.sections = litr.sections;
@@ -341,6 +342,9 @@ compute_eligible_lines_impl()
         }
     }
 
+    // build the sorted flat arrays used by is_eligible_address in the signal handlers
+    _eligible_ar.freeze();
+
     ROCPROFSYS_VERBOSE(
         0, "[causal] eligible address ranges: %zu, coarse address range: %zu [%s]\n",
         _eligible_ar.size(), _eligible_ar.range_size(),
@@ -20,6 +20,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "binary/analysis.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
@@ -69,21 +70,212 @@
 
 #include <pthread.h>
 #include <signal.h>
+#include <ucontext.h>
 
 namespace rocprofsys
 {
 namespace component
 {
+namespace
+{
+struct stack_bounds
+{
+    uintptr_t low  = 0;
+    uintptr_t high = 0;
+};
+
+// only written by the sampled thread and reduced after sampling has stopped
+struct unwind_counters
+{
+    uint64_t samples   = 0;
+    uint64_t fallbacks = 0;
+    uint64_t nsec      = 0;
+};
+
+// settings read by configure() so that the signal handler never initializes a static
+struct unwind_config
+{
+    bool             frame_pointer = false;
+    bool             timed         = false;
+    unwind_counters* counters      = nullptr;
+};
+
+using stack_trie_data      = thread_data<backtrace::stack_trie_t, category::sampling>;
+using unwind_counters_data = thread_data<unwind_counters, category::sampling>;
+
+// call-stack tree of the sampled thread, cached for the signal handler
+auto*&
+get_thread_stack_trie()
+{
+    static thread_local backtrace::stack_trie_t* _v = nullptr;
+    return _v;
+}
+
+auto&
+get_stack_bounds()
+{
+    static thread_local auto _v = stack_bounds{};
+    return _v;
+}
+
+auto&
+get_unwind_config()
+{
+    static thread_local auto _v = unwind_config{};
+    return _v;
+}
+
+// address of the signal return trampoline (__restore_rt) which glibc installs as the
+// sa_restorer of every handler. It is the return address of the signal handler frame
+// and the ucontext of the interrupted code immediately follows it on the stack
+uintptr_t
+get_sigreturn_trampoline(int _signo)
+{
+    static auto _v    = std::atomic<uintptr_t>{ 0 };
+    auto        _addr = _v.load(std::memory_order_relaxed);
+    if(_addr == 0)
+    {
+        // sigaction is async-signal-safe
+        struct sigaction _action = {};
+        if(sigaction(_signo, nullptr, &_action) == 0 &&
+           (_action.sa_flags & SA_RESTORER) != 0)
+        {
+            _addr = reinterpret_cast<uintptr_t>(_action.sa_restorer);
+            _v.store(_addr, std::memory_order_relaxed);
+        }
+    }
+    return _addr;
+}
+
+// walks the frame-pointer chain from the signal handler into the interrupted code.
+// Returns false if the chain is broken (i.e. some code in the call-stack was compiled
+// without frame-pointers) so that the caller can fall back to libunwind
+__attribute__((noinline)) bool
+frame_pointer_unwind(int _signo, backtrace::data_t& _addrs)
+{
+#if defined(__x86_64__)
+    // maximum number of frames and stack size between this frame and the handler frame
+    constexpr size_t    max_handler_depth = 16;
+    constexpr uintptr_t max_handler_size  = 64 * 1024;
+
+    const auto& _bounds     = get_stack_bounds();
+    const auto  _trampoline = get_sigreturn_trampoline(_signo);
+
+    if(_bounds.low == 0 || _trampoline == 0) return false;
+
+    auto _valid = [](uintptr_t _fp, uintptr_t _lo, uintptr_t _hi) {
+        return (_fp % sizeof(uintptr_t)) == 0 && _fp >= _lo &&
+               _fp + (2 * sizeof(uintptr_t)) <= _hi;
+    };
+
+    // frames of the signal handler: these may be on an alternate signal stack
+    auto        _lo   = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    auto        _hi   = _lo + max_handler_size;
+    auto        _fp   = _lo;
+    ucontext_t* _uctx = nullptr;
+    for(size_t i = 0; i < max_handler_depth; ++i)
+    {
+        if(!_valid(_fp, _lo, _hi)) return false;
+
+        const auto* _frame = reinterpret_cast<const uintptr_t*>(_fp);
+        if(_frame[1] == _trampoline)
+        {
+            _uctx = reinterpret_cast<ucontext_t*>(const_cast<uintptr_t*>(&_frame[2]));
+            break;
+        }
+
+        if(_frame[0] <= _fp) return false;
+        _fp = _frame[0];
+    }
+
+    if(!_uctx) return false;
+
+    // interrupted code: the first entry is the instruction pointer at the time of the
+    // signal and the remaining entries are return addresses
+    _addrs.clear();
+    _addrs.emplace_back(static_cast<uintptr_t>(_uctx->uc_mcontext.gregs[REG_RIP]));
+
+    _fp = static_cast<uintptr_t>(_uctx->uc_mcontext.gregs[REG_RBP]);
+    _lo = std::max<uintptr_t>(_bounds.low,
+                              static_cast<uintptr_t>(_uctx->uc_mcontext.gregs[REG_RSP]));
+    _hi = _bounds.high;
+
+    while(_fp != 0 && _addrs.size() < _addrs.capacity())
+    {
+        if(!_valid(_fp, _lo, _hi)) return false;
+
+        const auto* _frame = reinterpret_cast<const uintptr_t*>(_fp);
+        if(_frame[1] == 0) break;
+        _addrs.emplace_back(_frame[1]);
+
+        // outermost frame (e.g. _start or clone) zeroes the frame pointer
+        if(_frame[0] == 0) break;
+        if(_frame[0] <= _fp) return false;
+        _lo = _fp;
+        _fp = _frame[0];
+    }
+
+    return true;
+#else
+    (void) _signo;
+    (void) _addrs;
+    return false;
+#endif
+}
+
+// collects the instruction pointers of the interrupted code, i.e. the frames after the
+// signal trampoline, via libunwind. On RedHat, unw_step involves a mutex lock
+__attribute__((noinline)) void
+libunwind_unwind(backtrace::data_t& _addrs)
+{
+    constexpr size_t max_handler_depth = 16;
+    // ignore depth when the signal frame is not identified:
+    // 1. this frame
+    // 2. backtrace::sample(...)
+    // 3. tim::sampling::sampler<...>::sample(...) [always inline]
+    // 4. tim::sampling::sampler<...>::execute(...)
+    constexpr size_t ignore_depth = 4;
+
+    _addrs.clear();
+
+    unw_context_t _context;
+    unw_cursor_t  _cursor;
+    if(unw_getcontext(&_context) != 0 || unw_init_local(&_cursor, &_context) != 0)
+        return;
+
+    auto   _ips    = std::array<uintptr_t, backtrace::stack_depth + max_handler_depth>{};
+    size_t _n      = 0;
+    size_t _offset = ignore_depth;
+    bool   _found  = false;
+    do
+    {
+        unw_word_t _ip = 0;
+        if(unw_get_reg(&_cursor, UNW_REG_IP, &_ip) != 0 || _ip == 0) break;
+        if(!_found && _n < max_handler_depth && unw_is_signal_frame(&_cursor) > 0)
+        {
+            _found  = true;
+            _offset = _n + 1;
+        }
+        _ips[_n++] = _ip;
+    } while(_n < _ips.size() && unw_step(&_cursor) > 0);
+
+    for(size_t i = _offset; i < _n && _addrs.size() < _addrs.capacity(); ++i)
+        _addrs.emplace_back(_ips[i]);
+}
+}  // namespace
+
 std::vector<backtrace::entry_type>
 backtrace::get() const
 {
     std::vector<entry_type> _v = {};
     if(size() == 0) return _v;
 
+    auto _data = get_data(threading::get_id());
+    _v.reserve(_data.size());
+    for(auto itr : _data)
     {
-        static auto _cache = cache_type{ get_sampling_include_inlines() };
-        auto_lock_t _lk{ type_mutex<backtrace>() };
-        _v = m_data.get(&_cache, false);
+        auto _entry = binary::lookup_ipaddr_entry<false>(itr);
+        if(_entry) _v.emplace_back(*_entry);
     }
 
     // put the bottom of the call-stack on top
@@ -110,49 +302,53 @@ backtrace::description()
     return "Records backtrace data";
 }
 
-std::vector<backtrace::entry_type>
-backtrace::filter_and_patch(const std::vector<entry_type>& _data)
+short
+backtrace::use_label(std::string_view _lbl)
 {
     // check whether the call-stack entry should be used. -1 means break, 0 means continue
-    auto _use_label = [](std::string_view _lbl) -> short {
-        // debugging feature
-        bool       _keep_internal = get_sampling_keep_internal();
-        const auto _npos          = std::string::npos;
-        if(_keep_internal) return 1;
-        if(_lbl.find("rocprofsys_main") != _npos) return 0;
-        if(_lbl.find("rocprofsys::") != _npos) return 0;
-        if(_lbl.find("tim::openmp::") != _npos) return -1;
-        if(_lbl.find("tim::") != _npos) return 0;
-        if(_lbl.find("DYNINST_") != _npos) return 0;
-        if(_lbl.find("rocprofsys_") != _npos) return -1;
-        if(_lbl.find("rocprofiler_") != _npos) return -1;
-        if(_lbl.find("roctracer_") != _npos) return -1;
-        if(_lbl.find("perfetto::") != _npos) return -1;
-        if(_lbl.find("protozero::") == 0) return -1;
-        if(_lbl.find("gotcha_") != _npos) return -1;
-        return 1;
-    };
+    bool       _keep_internal = get_sampling_keep_internal();
+    const auto _npos          = std::string::npos;
+    // debugging feature
+    if(_keep_internal) return 1;
+    if(_lbl.find("rocprofsys_main") != _npos) return 0;
+    if(_lbl.find("rocprofsys::") != _npos) return 0;
+    if(_lbl.find("tim::openmp::") != _npos) return -1;
+    if(_lbl.find("tim::") != _npos) return 0;
+    if(_lbl.find("DYNINST_") != _npos) return 0;
+    if(_lbl.find("rocprofsys_") != _npos) return -1;
+    if(_lbl.find("rocprofiler_") != _npos) return -1;
+    if(_lbl.find("roctracer_") != _npos) return -1;
+    if(_lbl.find("perfetto::") != _npos) return -1;
+    if(_lbl.find("protozero::") == 0) return -1;
+    if(_lbl.find("gotcha_") != _npos) return -1;
+    return 1;
+}
 
+std::string
+backtrace::patch_label(std::string_view _lbl)
+{
     static bool _keep_suffix = tim::get_env<bool>(
         "ROCPROFSYS_SAMPLING_KEEP_DYNINST_SUFFIX", get_debug_sampling());
 
     // in the dyninst binary rewrite runtime, instrumented functions are appended with
     // "_dyninst", i.e. "main" will show up as "main_dyninst" in the backtrace.
-    auto _patch_label = [](std::string_view _lbl) -> std::string {
-        // debugging feature
-        if(_keep_suffix) return std::string{ _lbl };
-        const std::string _dyninst{ "_dyninst" };
-        auto              _pos = _lbl.find(_dyninst);
-        if(_pos == std::string::npos) return std::string{ _lbl };
-        return std::string{ _lbl }.replace(_pos, _dyninst.length(), "");
-    };
+    // debugging feature
+    if(_keep_suffix) return std::string{ _lbl };
+    const std::string _dyninst{ "_dyninst" };
+    auto              _pos = _lbl.find(_dyninst);
+    if(_pos == std::string::npos) return std::string{ _lbl };
+    return std::string{ _lbl }.replace(_pos, _dyninst.length(), "");
+}
 
+std::vector<backtrace::entry_type>
+backtrace::filter_and_patch(const std::vector<entry_type>& _data)
+{
     auto _ret = std::vector<entry_type>{};
     _ret.reserve(_data.size());
     for(const auto& itr : _data)
     {
-        auto _name = tim::demangle(_patch_label(itr.name));
-        auto _use  = _use_label(_name);
+        auto _name = tim::demangle(patch_label(itr.name));
+        auto _use  = use_label(_name);
         if(_use == -1) break;
         if(_use == 0) continue;
         auto _v = itr;
@@ -171,6 +367,100 @@ void
 backtrace::stop()
 {}
 
+void
+backtrace::configure(bool _setup, int64_t _tid)
+{
+    // the call-stack tree and stack bounds are cached in thread-local storage so this
+    // must be called on the sampled thread
+    if(!_setup || _tid != threading::get_id()) return;
+
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    if(!get_thread_stack_trie())
+        get_thread_stack_trie() =
+            stack_trie_data::instance(construct_on_thread{ _tid }).get();
+#endif
+
+    auto& _config = get_unwind_config();
+    if(!_config.counters)
+        _config.counters =
+            unwind_counters_data::instance(construct_on_thread{ _tid }).get();
+    _config.frame_pointer = get_sampling_frame_pointer_unwind();
+    _config.timed         = get_sampling_unwind_stats();
+
+    if(!_config.frame_pointer) return;
+
+    auto& _bounds = get_stack_bounds();
+    if(_bounds.low != 0) return;
+
+    pthread_attr_t _attr;
+    if(pthread_getattr_np(pthread_self(), &_attr) != 0) return;
+
+    void*  _addr = nullptr;
+    size_t _size = 0;
+    if(pthread_attr_getstack(&_attr, &_addr, &_size) == 0 && _addr != nullptr)
+    {
+        _bounds.low  = reinterpret_cast<uintptr_t>(_addr);
+        _bounds.high = _bounds.low + _size;
+    }
+    pthread_attr_destroy(&_attr);
+
+    ROCPROFSYS_VERBOSE(3, "[sampling] thread %li stack bounds: [%p, %p)\n", _tid,
+                       reinterpret_cast<void*>(_bounds.low),
+                       reinterpret_cast<void*>(_bounds.high));
+}
+
+backtrace::unwind_stats
+backtrace::get_unwind_stats()
+{
+    auto        _stats = unwind_stats{};
+    const auto* _data  = unwind_counters_data::get();
+    if(!_data) return _stats;
+
+    for(const auto& itr : *_data)
+    {
+        if(!itr) continue;
+        _stats.samples += itr->samples;
+        _stats.fallbacks += itr->fallbacks;
+        _stats.nsec += itr->nsec;
+    }
+    return _stats;
+}
+
+const backtrace::stack_trie_t*
+backtrace::get_stack_trie(int64_t _tid)
+{
+    const auto* _data = stack_trie_data::get();
+    if(!_data || _tid < 0 || static_cast<size_t>(_tid) >= _data->size()) return nullptr;
+    return _data->at(_tid).get();
+}
+
+backtrace::stack_id_t
+backtrace::intern(const data_t& _data)
+{
+    auto* _trie = get_thread_stack_trie();
+    return (_trie) ? _trie->insert(_data) : stack_trie_t::npos;
+}
+
+backtrace::data_t
+backtrace::expand(int64_t _tid, stack_id_t _id)
+{
+    auto        _data = data_t{};
+    const auto* _trie = get_stack_trie(_tid);
+    if(_trie) _trie->expand(_id, _data);
+    return _data;
+}
+
+backtrace::data_t
+backtrace::get_data(int64_t _tid) const
+{
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    return expand(_tid, m_stack_id);
+#else
+    (void) _tid;
+    return m_data;
+#endif
+}
+
 bool
 backtrace::empty() const
 {
@@ -180,7 +470,11 @@ backtrace::empty() const
 size_t
 backtrace::size() const
 {
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    return m_depth;
+#else
     return m_data.size();
+#endif
 }
 
 void
@@ -188,20 +482,37 @@ backtrace::sample(int signo)
 {
     if(signo == get_sampling_overflow_signal()) return;
 
-    // on RedHat, the unw_step within get_unw_stack involves a mutex lock
+    // on RedHat, the unw_step within libunwind involves a mutex lock
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
 
-    using namespace tim::backtrace;
-    constexpr bool   with_signal_frame = false;
-    constexpr size_t ignore_depth      = 3;
-    // ignore depth based on:
-    // 1. this frame
-    // 2. tim::sampling::sampler<...>::sample(...) [always inline]
-    // 3. tim::sampling::sampler<...>::execute(...)
-    // 4a. funlockfile       [common but not explicitly in call-stack]
-    // 4b. __resume_rt       [common but not explicitly in call-stack]
-    // 4c. killpg            [common but not explicitly in call-stack]
-    m_data = get_unw_stack<stack_depth, ignore_depth, with_signal_frame>();
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    auto  _local = data_t{};
+    auto& _data  = _local;
+#else
+    auto& _data = m_data;
+#endif
+
+    const auto& _config  = get_unwind_config();
+    auto        _beg     = (_config.timed) ? clock_type::now() : clock_type::time_point{};
+    bool        _unwound = false;
+
+    if(_config.frame_pointer) _unwound = frame_pointer_unwind(signo, _data);
+    if(!_unwound) libunwind_unwind(_data);
+
+    if(auto* _counters = _config.counters)
+    {
+        ++_counters->samples;
+        if(_config.frame_pointer && !_unwound) ++_counters->fallbacks;
+        if(_config.timed)
+            _counters->nsec += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   clock_type::now() - _beg)
+                                   .count();
+    }
+
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    m_stack_id = intern(_data);
+    m_depth    = (m_stack_id == stack_trie_t::npos) ? 0 : _data.size();
+#endif
 }
 }  // namespace component
 }  // namespace rocprofsys
@@ -24,21 +24,23 @@
 
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
+#include "core/containers/stack_trie.hpp"
+#include "core/containers/static_vector.hpp"
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/components/base/declaration.hpp>
 #include <timemory/mpl/concepts.hpp>
-#include <timemory/unwind/cache.hpp>
 #include <timemory/unwind/processed_entry.hpp>
-#include <timemory/unwind/stack.hpp>
 
 #include <array>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace rocprofsys
@@ -49,14 +51,23 @@ struct backtrace : comp::empty_base
 {
     static constexpr size_t stack_depth = ROCPROFSYS_MAX_UNWIND_DEPTH;
 
-    using data_t            = tim::unwind::stack<stack_depth>;
-    using cache_type        = typename data_t::cache_type;
+    using data_t            = container::static_vector<uintptr_t, stack_depth>;
+    using stack_trie_t      = container::stack_trie<uintptr_t>;
+    using stack_id_t        = typename stack_trie_t::id_type;
     using entry_type        = tim::unwind::processed_entry;
     using clock_type        = std::chrono::steady_clock;
     using value_type        = void;
     using system_clock      = std::chrono::system_clock;
     using system_time_point = typename system_clock::time_point;
 
+    // per-sample latency of the unwinder in the signal handler
+    struct unwind_stats
+    {
+        uint64_t samples   = 0;
+        uint64_t fallbacks = 0;
+        uint64_t nsec      = 0;
+    };
+
     static std::string label();
     static std::string description();
 
@@ -68,19 +79,37 @@ struct backtrace : comp::empty_base
     backtrace& operator=(const backtrace&) = default;
     backtrace& operator=(backtrace&&) noexcept = default;
 
+    static short                   use_label(std::string_view);
+    static std::string             patch_label(std::string_view);
     static std::vector<entry_type> filter_and_patch(const std::vector<entry_type>&);
 
-    static void start();
-    static void stop();
+    static void         start();
+    static void         stop();
+    static void         configure(bool, int64_t _tid = threading::get_id());
+    static unwind_stats get_unwind_stats();
+
+    // call-stack tree of the given thread when ROCPROFSYS_SAMPLING_COMPACT_STACKS is
+    // enabled. intern must be called on the sampled thread
+    static const stack_trie_t* get_stack_trie(int64_t _tid);
+    static stack_id_t          intern(const data_t&);
+    static data_t              expand(int64_t _tid, stack_id_t);
 
     void                    sample(int = -1);
     bool                    empty() const;
     size_t                  size() const;
     std::vector<entry_type> get() const;
-    data_t                  get_data() const { return m_data; }
+    data_t                  get_data(int64_t _tid) const;
 
 private:
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    // leaf node of the call-stack in the call-stack tree of the sampled thread
+    stack_id_t m_stack_id = stack_trie_t::npos;
+    uint32_t   m_depth    = 0;
+#else
+    // instruction pointer of the interrupted code followed by the return addresses.
+    // symbolization is deferred to post-processing
     data_t m_data = {};
+#endif
 };
 }  // namespace component
 }  // namespace rocprofsys
@@ -26,6 +26,7 @@
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/perf.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
@@ -60,6 +61,7 @@
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
+#include <limits>
 #include <mutex>
 #include <regex>
 #include <sstream>
@@ -93,6 +95,30 @@ namespace
 struct perfetto_rusage
 {};
 
+// per-thread perf_event group replacing getrusage, the thread CPU clock, and the PAPI
+// reads in the signal handler when ROCPROFSYS_SAMPLING_METRICS_BACKEND=perf. The
+// indexes are the positions of the counts read from the group
+struct perf_metrics
+{
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    perf::counter_group group         = {};
+    size_t              cpu_idx       = npos;
+    size_t              page_flt_idx  = npos;
+    size_t              ctx_swch_idx  = npos;
+    size_t              hw_idx        = npos;
+    int64_t             last_page_flt = -1;
+    int64_t             last_mem_peak = 0;
+};
+
+using perf_metrics_instances = thread_data<perf_metrics, category::sampling>;
+
+unique_ptr_t<perf_metrics>&
+get_perf_metrics(int64_t _tid)
+{
+    return perf_metrics_instances::instance(construct_on_thread{ _tid });
+}
+
 unique_ptr_t<std::vector<std::string>>&
 get_papi_labels(int64_t _tid)
 {
@@ -156,7 +182,187 @@ auto get_enabled(tim::type_list<Tp...>)
     (_v.set(_n++, trait::runtime_enabled<Tp>::get()), ...);
     return _v;
 }
+
+template <typename Tp>
+bool
+is_enabled(backtrace_metrics::valid_array_t _valid)
+{
+    return _valid.test(tim::index_of<Tp, backtrace_metrics::categories_t>::value);
+}
+
+// counting kernel-side events, e.g. context switches, is not permitted when
+// perf_event_paranoid >= 2 so the group is opened without them when that fails
+std::optional<std::string>
+open_perf_metrics(perf_metrics& _data, backtrace_metrics::valid_array_t _valid,
+                  const std::vector<std::string>& _hw_labels, bool _kernel)
+{
+    auto _attrs = std::vector<struct perf_event_attr>{};
+    auto _add   = [&_attrs, _kernel](uint64_t _config) {
+        auto _pe = perf_event_attr{};
+        memset(&_pe, 0, sizeof(_pe));
+        _pe.type           = PERF_TYPE_SOFTWARE;
+        _pe.config         = _config;
+        _pe.exclude_kernel = (_kernel) ? 0 : 1;
+        _pe.exclude_hv     = 1;
+        _attrs.emplace_back(_pe);
+        return _attrs.size() - 1;
+    };
+
+    _data.cpu_idx      = perf_metrics::npos;
+    _data.page_flt_idx = perf_metrics::npos;
+    _data.ctx_swch_idx = perf_metrics::npos;
+    _data.hw_idx       = perf_metrics::npos;
+
+    if(is_enabled<category::thread_cpu_time>(_valid))
+        _data.cpu_idx = _add(PERF_COUNT_SW_TASK_CLOCK);
+
+    // the peak memory is only updated when the page-fault count changes
+    if(is_enabled<category::thread_page_fault>(_valid) ||
+       is_enabled<category::thread_peak_memory>(_valid))
+        _data.page_flt_idx = _add(PERF_COUNT_SW_PAGE_FAULTS);
+
+    if(is_enabled<category::thread_context_switch>(_valid) && _kernel)
+        _data.ctx_swch_idx = _add(PERF_COUNT_SW_CONTEXT_SWITCHES);
+
+    // the hardware counters are only read from the group when every PAPI event has a
+    // generic perf equivalent
+    if(is_enabled<category::thread_hardware_counter>(_valid) &&
+       is_enabled<backtrace_metrics::hw_counters>(_valid) && !_hw_labels.empty())
+    {
+        auto _hw_attrs = std::vector<struct perf_event_attr>{};
+        for(const auto& itr : _hw_labels)
+        {
+            auto _pe = perf_event_attr{};
+            if(!perf::config_counting(_pe, itr)) break;
+            _hw_attrs.emplace_back(_pe);
+        }
+
+        if(_hw_attrs.size() == _hw_labels.size() &&
+           _attrs.size() + _hw_attrs.size() <= perf::counter_group::max_events)
+        {
+            _data.hw_idx = _attrs.size();
+            for(const auto& itr : _hw_attrs)
+                _attrs.emplace_back(itr);
+        }
+    }
+
+    if(_attrs.empty()) return std::optional<std::string>{};
+
+    return _data.group.open(_attrs);
+}
+
+void
+open_perf_metrics(int64_t _tid)
+{
+    auto& _data = get_perf_metrics(_tid);
+    if(!_data || _data->group.is_open()) return;
+
+    auto _valid  = get_enabled(backtrace_metrics::categories_t{});
+    auto _labels = backtrace_metrics::get_hw_counter_labels(_tid);
+    auto _err    = open_perf_metrics(*_data, _valid, _labels, true);
+    if(_err && is_enabled<category::thread_context_switch>(_valid))
+    {
+        ROCPROFSYS_VERBOSE(2,
+                           "[sampling] perf metrics for thread %li: %s. Retrying without "
+                           "kernel events (context switches)...\n",
+                           _tid, _err->c_str());
+        _err = open_perf_metrics(*_data, _valid, _labels, false);
+    }
+
+    if(_err)
+    {
+        ROCPROFSYS_WARNING(0,
+                           "[sampling] perf metrics for thread %li: %s. Falling back to "
+                           "getrusage...\n",
+                           _tid, _err->c_str());
+        _data->hw_idx = perf_metrics::npos;
+        return;
+    }
+
+    if(!_data->group.is_open()) return;
+
+    // the hardware counters are read from the group so stop the PAPI counters to
+    // release the PMU counters
+    if constexpr(tim::trait::is_available<hw_counters>::value)
+    {
+        if(_data->hw_idx != perf_metrics::npos && get_papi_vector(_tid))
+            get_papi_vector(_tid)->stop();
+    }
+
+    _data->group.start();
+
+    ROCPROFSYS_VERBOSE(2,
+                       "[sampling] perf metrics for thread %li: %zu events, hardware "
+                       "counters: %s, rdpmc: %s\n",
+                       _tid, _data->group.size(),
+                       (_data->hw_idx != perf_metrics::npos) ? "perf" : "papi",
+                       (_data->group.uses_rdpmc()) ? "yes" : "no");
+}
 }  // namespace
+bool
+backtrace_metrics::sample_perf(int64_t _tid)
+{
+    auto& _data = get_perf_metrics(_tid);
+    if(!_data || !_data->group.is_open()) return false;
+
+    uint64_t _counts[perf::counter_group::max_events] = {};
+    if(!_data->group.read(_counts)) return false;
+
+    auto _get = [&_counts](size_t _idx) { return static_cast<int64_t>(_counts[_idx]); };
+
+    m_cpu = (_data->cpu_idx != perf_metrics::npos)
+                ? _get(_data->cpu_idx)
+                : tim::get_clock_thread_now<int64_t, std::nano>();
+
+    if(_data->page_flt_idx != perf_metrics::npos) m_page_flt = _get(_data->page_flt_idx);
+    if(_data->ctx_swch_idx != perf_metrics::npos) m_ctx_swch = _get(_data->ctx_swch_idx);
+
+    // the resident set size only grows when pages are faulted in so getrusage is only
+    // required for the peak memory when the page-fault count changed or when the
+    // context switches could not be counted by the group
+    bool _ctx_swch = (*this)(category::thread_context_switch{}) &&
+                     _data->ctx_swch_idx == perf_metrics::npos;
+    bool _mem_peak = (*this)(category::thread_peak_memory{}) &&
+                     (_data->page_flt_idx == perf_metrics::npos ||
+                      m_page_flt != _data->last_page_flt);
+
+    if(_ctx_swch || _mem_peak)
+    {
+        auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
+        if(_mem_peak) _data->last_mem_peak = _cache.get_peak_rss();
+        if(_ctx_swch)
+            m_ctx_swch = _cache.get_num_priority_context_switch() +
+                         _cache.get_num_voluntary_context_switch();
+        if(_data->page_flt_idx == perf_metrics::npos)
+            m_page_flt = _cache.get_num_major_page_faults() +
+                         _cache.get_num_minor_page_faults();
+    }
+    m_mem_peak           = _data->last_mem_peak;
+    _data->last_page_flt = m_page_flt;
+
+    if constexpr(tim::trait::is_available<hw_counters>::value)
+    {
+        if((*this)(category::thread_hardware_counter{}) &&
+           (*this)(type_list<hw_counters>{}))
+        {
+            if(_data->hw_idx != perf_metrics::npos)
+            {
+                auto _n = std::min<size_t>(m_hw_counter.size(),
+                                           _data->group.size() - _data->hw_idx);
+                for(size_t i = 0; i < _n; ++i)
+                    m_hw_counter.at(i) = _get(_data->hw_idx + i);
+            }
+            else
+            {
+                assert(get_papi_vector(_tid).get() != nullptr);
+                m_hw_counter = get_papi_vector(_tid)->record();
+            }
+        }
+    }
+
+    return true;
+}
+
 void
 backtrace_metrics::sample(int)
 {
@@ -171,6 +377,9 @@ backtrace_metrics::sample(int)
     // return if everything is disabled
     if(!m_valid.any()) return;
 
+    auto _tid = threading::get_id();
+    if(get_sampling_perf_metrics() && sample_perf(_tid)) return;
+
     auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
     m_cpu       = tim::get_clock_thread_now<int64_t, std::nano>();
     m_mem_peak  = _cache.get_peak_rss();
@@ -184,7 +393,6 @@ backtrace_metrics::sample(int)
         constexpr auto hw_category_idx =
             tim::index_of<category::thread_hardware_counter, categories_t>::value;
 
-        auto _tid = threading::get_id();
         if(m_valid.test(hw_category_idx) && m_valid.test(hw_counters_idx))
         {
             assert(get_papi_vector(_tid).get() != nullptr);
@@ -217,6 +425,8 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
                 *get_papi_labels(_tid) = get_papi_vector(_tid)->get_config()->labels;
             }
         }
+
+        if(get_sampling_perf_metrics()) open_perf_metrics(_tid);
     }
     else if(!_setup && _is_running)
     {
@@ -225,12 +435,18 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
 
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
-            if(_tid == threading::get_id())
+            bool _papi_running =
+                !get_sampling_perf_metrics() || !get_perf_metrics(_tid) ||
+                get_perf_metrics(_tid)->hw_idx == perf_metrics::npos;
+            if(_tid == threading::get_id() && _papi_running)
             {
                 if(get_papi_vector(_tid)) get_papi_vector(_tid)->stop();
                 ROCPROFSYS_DEBUG("HW COUNTER: stopped...\n");
             }
         }
+
+        if(get_sampling_perf_metrics() && get_perf_metrics(_tid))
+            get_perf_metrics(_tid)->group.close();
         ROCPROFSYS_DEBUG("Sampler destroyed for thread %lu\n", _tid);
     }
 }
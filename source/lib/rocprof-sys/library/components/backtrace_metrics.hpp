@@ -123,6 +123,8 @@ struct backtrace_metrics : comp::empty_base
     }
 
 private:
+    bool sample_perf(int64_t _tid);
+
     valid_array_t     m_valid      = {};
     int64_t           m_cpu        = 0;
     int64_t           m_mem_peak   = 0;
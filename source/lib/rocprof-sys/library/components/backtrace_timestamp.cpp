@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "library/components/backtrace_timestamp.hpp"
+#include "core/timestamp.hpp"
+#include "library/sampling_rate.hpp"
 #include "library/thread_info.hpp"
 
 #include <timemory/components/timing/backends.hpp>
@@ -43,10 +45,11 @@ backtrace_timestamp::is_valid() const
 }
 
 void
-backtrace_timestamp::sample(int)
+backtrace_timestamp::sample(int signo)
 {
     m_tid  = tim::threading::get_id();
-    m_real = tim::get_clock_real_now<uint64_t, std::nano>();
+    m_real   = timestamp::now();
+    m_period = sampling::rate_controller::get_period(signo);
 }
 }  // namespace component
 }  // namespace rocprofsys
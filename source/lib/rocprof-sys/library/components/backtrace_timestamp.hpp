@@ -62,11 +62,13 @@ struct backtrace_timestamp : comp::empty_base
 
     auto get_tid() const { return m_tid; }
     auto get_timestamp() const { return m_real; }
+    auto get_period() const { return m_period; }
     bool is_valid() const;
 
 private:
-    int64_t  m_tid  = 0;
-    uint64_t m_real = 0;
+    int64_t  m_tid    = 0;
+    uint64_t m_real   = 0;
+    uint64_t m_period = 0;  // effective sampling period (nsec), zero if unknown
 };
 }  // namespace component
 }  // namespace rocprofsys
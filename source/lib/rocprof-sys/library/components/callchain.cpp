@@ -28,8 +28,10 @@
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "core/timestamp.hpp"
 #include "library/components/ensure_storage.hpp"
 #include "library/perf.hpp"
+#include "library/perf_unwind.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
@@ -69,6 +71,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <pthread.h>
@@ -78,6 +81,71 @@ namespace rocprofsys
 {
 namespace component
 {
+namespace
+{
+// samples drained from the perf ring buffers by the overflow collector thread. The
+// call-stacks are stored contiguously since most of them are much shorter than the
+// maximum depth
+struct collected_samples
+{
+    std::vector<uint64_t>  timestamps = {};
+    std::vector<size_t>    offsets    = {};
+    std::vector<uintptr_t> pcs        = {};
+};
+
+auto&
+get_collected_samples()
+{
+    static auto _v = std::unordered_map<int64_t, collected_samples>{};
+    return _v;
+}
+
+backtrace::data_t
+get_callchain_pcs(const perf::perf_event::record& _record)
+{
+    auto _ip  = _record.get_ip();
+    auto _pcs = backtrace::data_t{};
+    _pcs.emplace_back(_ip);
+    bool _skip_ip = true;
+    for(auto itr : _record.get_callchain())
+    {
+        // skip the first instance of current IP but allow after that since this
+        // might be a recursive call
+        if(itr == _ip && _skip_ip)
+            _skip_ip = false;
+        else
+            _pcs.emplace_back(itr);
+        if(_pcs.size() == _pcs.capacity()) break;
+    }
+    return _pcs;
+}
+
+template <typename Iter>
+callchain::ts_entry_vec_t
+resolve(uint64_t _ts, Iter _beg, Iter _end)
+{
+    static const auto _known_excludes =
+        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
+
+    auto _v = callchain::ts_entry_vec_t{ _ts, {} };
+    for(auto itr = _beg; itr != _end; ++itr)
+    {
+        auto _entry = binary::lookup_ipaddr_entry<true>(*itr);
+        if(_entry) _v.second.emplace_back(*_entry);
+    }
+
+    // put the bottom of the call-stack on top
+    std::reverse(_v.second.begin(), _v.second.end());
+
+    // remove some known functions which are by-products of interrupts
+    while(!_v.second.empty() &&
+          _known_excludes.find(_v.second.back().name) != _known_excludes.end())
+        _v.second.pop_back();
+
+    return _v;
+}
+}  // namespace
+
 bool
 callchain::record::operator<(const record& rhs) const
 {
@@ -85,7 +153,7 @@ callchain::record::operator<(const record& rhs) const
 }
 
 std::vector<callchain::ts_entry_vec_t>
-callchain::get() const
+callchain::get(int64_t _tid) const
 {
     std::vector<ts_entry_vec_t> _v = {};
     if(size() == 0) return _v;
@@ -95,29 +163,14 @@ callchain::get() const
     std::sort(_data.begin(), _data.end());
     for(const auto& itr : _data)
     {
-        auto _v2 = ts_entry_vec_t{ itr.timestamp, {} };
-        for(auto iitr : itr.data)
-        {
-            auto _entry = binary::lookup_ipaddr_entry<true>(iitr);
-            if(_entry) _v2.second.emplace_back(*_entry);
-        }
-
-        if(!_v2.second.empty())
-        {
-            // put the bottom of the call-stack on top
-            std::reverse(_v2.second.begin(), _v2.second.end());
-            _v.emplace_back(std::move(_v2));
-        }
-    }
-
-    auto _known_excludes =
-        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
-    // remove some known functions which are by-products of interrupts
-    for(auto& itr : _v)
-    {
-        while(!itr.second.empty() &&
-              _known_excludes.find(itr.second.back().name) != _known_excludes.end())
-            itr.second.pop_back();
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+        auto _pcs = backtrace::expand(_tid, itr.data);
+#else
+        const auto& _pcs = itr.data;
+        (void) _tid;
+#endif
+        auto _v2 = resolve(itr.timestamp, _pcs.begin(), _pcs.end());
+        if(!_v2.second.empty()) _v.emplace_back(std::move(_v2));
     }
 
     std::sort(_v.begin(), _v.end(),
@@ -192,27 +245,102 @@ callchain::sample(int signo)
     {
         if(itr.is_sample())
         {
-            auto _ip        = itr.get_ip();
+            auto _pcs       = get_callchain_pcs(itr);
             auto _data      = record{};
             _data.timestamp = itr.get_time();
-            _data.data.emplace_back(_ip);
-            bool _skip_ip = true;
-            for(auto ditr : itr.get_callchain())
-            {
-                // skip the first instance of current IP but allow after that since this
-                // might be a recursive call
-                if(ditr == _ip && _skip_ip)
-                    _skip_ip = false;
-                else
-                    _data.data.emplace_back(ditr);
-                if(_data.data.size() == _data.data.capacity()) break;
-            }
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+            _data.data = backtrace::intern(_pcs);
+            if(_data.data != backtrace::stack_trie_t::npos) m_data.emplace_back(_data);
+#else
+            _data.data = _pcs;
             if(!_data.data.empty()) m_data.emplace_back(_data);
+#endif
         }
     }
 
     _perf_event->start();
 }
+
+void
+callchain::collect(int64_t _tid, const perf::perf_event::record& _record)
+{
+    // invoked on the collector thread so the perf timestamps (CLOCK_MONOTONIC) are
+    // converted to the clock of the backtrace_timestamp component (timestamp::now)
+    // here. The clock is read between two reads of CLOCK_MONOTONIC to bound the error
+    static const auto _offset = []() {
+        auto _beg = tim::get_clock_monotonic_now<uint64_t, std::nano>();
+        auto _now = ::rocprofsys::timestamp::now();
+        auto _end = tim::get_clock_monotonic_now<uint64_t, std::nano>();
+        return _now - (_beg + ((_end - _beg) / 2));
+    }();
+
+    auto _pcs = get_callchain_pcs(_record);
+
+    // the copy of the user stack is unwound after sampling stops
+    if(_record.has_user_stack())
+    {
+        perf::get_stack_snapshots().add(_tid, _record.get_time() + _offset, _record,
+                                        _pcs.data(), _pcs.size());
+        return;
+    }
+
+    auto& _data = get_collected_samples()[_tid];
+    _data.timestamps.emplace_back(_record.get_time() + _offset);
+    _data.offsets.emplace_back(_data.pcs.size());
+    _data.pcs.insert(_data.pcs.end(), _pcs.begin(), _pcs.end());
+}
+
+size_t
+callchain::unwind_collected()
+{
+    auto& _snapshots = perf::get_stack_snapshots();
+    if(_snapshots.size() == 0) return 0;
+
+    auto _n = _snapshots.unwind(
+        backtrace::stack_depth,
+        [](int64_t _tid, uint64_t _ts, const std::vector<uintptr_t>& _pcs) {
+            auto& _data = get_collected_samples()[_tid];
+            _data.timestamps.emplace_back(_ts);
+            _data.offsets.emplace_back(_data.pcs.size());
+            _data.pcs.insert(_data.pcs.end(), _pcs.begin(), _pcs.end());
+        });
+    _snapshots.clear();
+    return _n;
+}
+
+size_t
+callchain::get_collected_size(int64_t _tid)
+{
+    const auto& _samples = get_collected_samples();
+    auto        itr      = _samples.find(_tid);
+    return (itr != _samples.end()) ? itr->second.timestamps.size() : 0;
+}
+
+std::vector<callchain::ts_entry_vec_t>
+callchain::get_collected(int64_t _tid)
+{
+    auto        _v       = std::vector<ts_entry_vec_t>{};
+    const auto& _samples = get_collected_samples();
+    auto        itr      = _samples.find(_tid);
+    if(itr == _samples.end()) return _v;
+
+    const auto& _data = itr->second;
+    _v.reserve(_data.timestamps.size());
+    for(size_t i = 0; i < _data.timestamps.size(); ++i)
+    {
+        auto _beg = _data.pcs.begin() + _data.offsets.at(i);
+        auto _end = (i + 1 < _data.offsets.size())
+                        ? _data.pcs.begin() + _data.offsets.at(i + 1)
+                        : _data.pcs.end();
+        auto _v2  = resolve(_data.timestamps.at(i), _beg, _end);
+        if(!_v2.second.empty()) _v.emplace_back(std::move(_v2));
+    }
+
+    std::sort(_v.begin(), _v.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.first < _rhs.first; });
+
+    return _v;
+}
 }  // namespace component
 }  // namespace rocprofsys
 
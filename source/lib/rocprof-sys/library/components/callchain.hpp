@@ -27,6 +27,8 @@
 #include "core/containers/static_vector.hpp"
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
+#include "library/components/backtrace.hpp"
+#include "library/perf.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/components/base/declaration.hpp>
@@ -52,8 +54,13 @@ struct callchain : comp::empty_base
 
     struct record
     {
-        uint64_t                                         timestamp = 0;
-        container::static_vector<uintptr_t, stack_depth> data      = {};
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+        uint64_t              timestamp = 0;
+        backtrace::stack_id_t data      = backtrace::stack_trie_t::npos;
+#else
+        uint64_t          timestamp = 0;
+        backtrace::data_t data      = {};
+#endif
 
         bool operator<(const record& rhs) const;
     };
@@ -82,10 +89,20 @@ struct callchain : comp::empty_base
     static void start();
     static void stop();
 
+    // samples drained from the perf ring buffers by perf::collector when
+    // ROCPROFSYS_SAMPLING_OVERFLOW_MODE=collector. collect is only invoked on the
+    // collector thread and the other functions may only be used after it was stopped.
+    // unwind_collected adds the samples with a copy of the user stack (see
+    // ROCPROFSYS_SAMPLING_OVERFLOW_STACK_SIZE) and returns the number which were unwound
+    static void                        collect(int64_t, const perf::perf_event::record&);
+    static size_t                      unwind_collected();
+    static size_t                      get_collected_size(int64_t);
+    static std::vector<ts_entry_vec_t> get_collected(int64_t);
+
     void                        sample(int = -1);
     bool                        empty() const;
     size_t                      size() const;
-    std::vector<ts_entry_vec_t> get() const;
+    std::vector<ts_entry_vec_t> get(int64_t _tid = threading::get_id()) const;
     data_t                      get_data() const { return m_data; }
 
 private:
@@ -103,6 +103,12 @@ struct category_region : comp::base<category_region<CategoryT>, void>
     template <typename... OptsT, typename... Args>
     static void stop(std::string_view name, Args&&...);
 
+    template <typename... OptsT, typename... Args>
+    static void start(const tracing::region_handle&, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop(const tracing::region_handle&, Args&&...);
+
     template <typename... OptsT, typename... Args>
     static void mark(std::string_view name, Args&&...);
 
@@ -120,12 +126,53 @@ struct category_region : comp::base<category_region<CategoryT>, void>
 
     template <typename... OptsT, typename... Args>
     static void audit(quirk::config<OptsT...>, Args&&...);
+
+private:
+    // a hash of zero means the hash of the name has not been computed
+    template <typename... OptsT, typename... Args>
+    static void start_impl(std::string_view name, tim::hash_value_t, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop_impl(std::string_view name, tim::hash_value_t, Args&&...);
 };
 
 template <typename CategoryT>
 template <typename... OptsT, typename... Args>
 void
 category_region<CategoryT>::start(std::string_view name, Args&&... args)
+{
+    start_impl<OptsT...>(name, tim::hash_value_t{ 0 }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+{
+    stop_impl<OptsT...>(name, tim::hash_value_t{ 0 }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::start(const tracing::region_handle& _handle, Args&&... args)
+{
+    start_impl<OptsT...>(_handle.name, _handle.hash, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(const tracing::region_handle& _handle, Args&&... args)
+{
+    stop_impl<OptsT...>(_handle.name, _handle.hash, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::start_impl(std::string_view name, tim::hash_value_t _hash,
+                                       Args&&... args)
 {
     // skip if category is disabled
     if(tracing::category_push_disabled<CategoryT>()) return;
@@ -165,8 +212,11 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         ++tracing::push_count();
     }
 
-    auto _hash = tim::add_hash_id(name);
-    name       = tim::get_hash_identifier_fast(_hash);
+    if(_hash == 0)
+    {
+        _hash = tim::add_hash_id(name);
+        name  = tim::get_hash_identifier_fast(_hash);
+    }
 
     if constexpr(_ct_use_causal)
     {
@@ -180,7 +230,7 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
     {
         if(get_use_timemory())
         {
-            tracing::push_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+            tracing::push_timemory(CategoryT{}, _hash, std::forward<Args>(args)...);
         }
     }
 
@@ -196,7 +246,8 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
 template <typename CategoryT>
 template <typename... OptsT, typename... Args>
 void
-category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+category_region<CategoryT>::stop_impl(std::string_view name, tim::hash_value_t _hash,
+                                      Args&&... args)
 {
     // skip if category is disabled
     if(tracing::category_pop_disabled<CategoryT>()) return;
@@ -241,7 +292,8 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
         {
             if(get_use_timemory())
             {
-                tracing::pop_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+                if(_hash == 0) _hash = tim::hash::get_hash_id(name);
+                tracing::pop_timemory(CategoryT{}, _hash, std::forward<Args>(args)...);
             }
         }
 
@@ -31,49 +31,162 @@
 #include <timemory/units.hpp>
 #include <timemory/utility/locking.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
 namespace rocprofsys
 {
 namespace component
 {
 namespace
 {
-template <typename Tp, typename... Args>
+// running total split into cache-line sized shards. Each thread adds to the shard of its
+// thread index so concurrent MPI/RCCL calls do not contend and the total is the sum of
+// the shards.
+struct sharded_counter
+{
+    static constexpr size_t num_shards = 32;
+
+    void add(uint64_t _v)
+    {
+        auto _idx = static_cast<size_t>(threading::get_id()) % num_shards;
+        m_shards[_idx].value.fetch_add(_v, std::memory_order_relaxed);
+    }
+
+    uint64_t load() const
+    {
+        uint64_t _v = 0;
+        for(const auto& itr : m_shards)
+            _v += itr.value.load(std::memory_order_relaxed);
+        return _v;
+    }
+
+private:
+    struct alignas(64) shard
+    {
+        std::atomic<uint64_t> value = { 0 };
+    };
+
+    std::array<shard, num_shards> m_shards = {};
+};
+
+// when true, the counters are emitted by the background process sampler instead of by
+// the MPI/RCCL wrappers
+auto&
+get_sampled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+template <typename Tp>
+auto&
+get_counter()
+{
+    static auto _v = sharded_counter{};
+    return _v;
+}
+
+template <typename Tp>
+auto&
+get_last_sampled()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+template <typename Tp>
 void
-write_perfetto_counter_track(uint64_t _val)
+emit_perfetto_counter_track(uint64_t _ts, uint64_t _val)
 {
     using counter_track = rocprofsys::perfetto_counter_track<Tp>;
 
+    auto _emplace = [](const size_t _idx) {
+        if(!counter_track::exists(_idx))
+        {
+            std::string _label = (_idx > 0)
+                                     ? JOIN(" ", Tp::label, JOIN("", '[', _idx, ']'))
+                                     : Tp::label;
+            counter_track::emplace(_idx, _label, "bytes");
+        }
+    };
+
+    const size_t          _idx = 0;
+    static std::once_flag _once{};
+    std::call_once(_once, _emplace, _idx);
+
+    TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _ts, _val);
+}
+
+template <typename Tp>
+void
+sample_perfetto_counter_track(uint64_t _ts)
+{
+    auto _val = get_counter<Tp>().load();
+    if(get_last_sampled<Tp>().exchange(_val) != _val)
+        emit_perfetto_counter_track<Tp>(_ts, _val);
+}
+
+template <typename Tp, typename... Args>
+void
+write_perfetto_counter_track(uint64_t _val)
+{
     if(rocprofsys::get_use_perfetto() &&
        rocprofsys::get_state() == rocprofsys::State::Active)
     {
-        auto _emplace = [](const size_t _idx) {
-            if(!counter_track::exists(_idx))
-            {
-                std::string _label = (_idx > 0)
-                                         ? JOIN(" ", Tp::label, JOIN("", '[', _idx, ']'))
-                                         : Tp::label;
-                counter_track::emplace(_idx, _label, "bytes");
-            }
-        };
-
-        const size_t          _idx = 0;
-        static std::once_flag _once{};
-        std::call_once(_once, _emplace, _idx);
-
-        static std::mutex _mutex{};
-        static uint64_t   value = 0;
-        uint64_t          _now  = 0;
+        get_counter<Tp>().add(_val);
+
+        if(!get_sampled().load(std::memory_order_relaxed))
         {
-            std::unique_lock<std::mutex> _lk{ _mutex };
-            _now = rocprofsys::tracing::now<uint64_t>();
-            _val = (value += _val);
+            // the timestamp and the total are read while the lock is held so that
+            // concurrent calls cannot emit a total which decreases over time
+            static auto                 _mutex = std::mutex{};
+            std::lock_guard<std::mutex> _lk{ _mutex };
+            emit_perfetto_counter_track<Tp>(rocprofsys::tracing::now<uint64_t>(),
+                                            get_counter<Tp>().load());
         }
-
-        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _val);
     }
 }
+
+void
+sample_perfetto_counter_tracks()
+{
+    auto _ts = rocprofsys::tracing::now<uint64_t>();
+    sample_perfetto_counter_track<comm_data::mpi_send>(_ts);
+    sample_perfetto_counter_track<comm_data::mpi_recv>(_ts);
+    sample_perfetto_counter_track<comm_data::rccl_send>(_ts);
+    sample_perfetto_counter_track<comm_data::rccl_recv>(_ts);
+}
 }  // namespace
 
+void
+comm_data::set_sampled(bool _v)
+{
+    get_sampled().store(_v);
+}
+
+void
+comm_data::sample()
+{
+    if(!rocprofsys::get_use_perfetto() ||
+       rocprofsys::get_state() != rocprofsys::State::Active)
+        return;
+
+    sample_perfetto_counter_tracks();
+}
+
+void
+comm_data::flush()
+{
+    // invoked when the process sampler shuts down, i.e. after the state is no longer
+    // active, so that the bytes of the last sampling interval are emitted
+    if(!rocprofsys::get_use_perfetto()) return;
+
+    sample_perfetto_counter_tracks();
+}
+
 void
 comm_data::preinit()
 {
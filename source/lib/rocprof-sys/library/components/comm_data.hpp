@@ -95,6 +95,12 @@ struct comm_data : base<comm_data, void>
     static void preinit();
     static void configure();
     static void global_finalize();
+
+    // emit the perfetto counters from the background process sampler (see sample())
+    // instead of from every MPI/RCCL call
+    static void set_sampled(bool);
+    static void sample();
+    static void flush();
     static void start() {}
     static void stop() {}
 
@@ -202,7 +202,7 @@ pthread_create_gotcha::wrapper::operator()() const
             auto _active = (get_state() == ::rocprofsys::State::Active &&
                             bundles != nullptr && bundles_mutex != nullptr);
             if(!_active) return;
-            thread_info::set_stop(comp::wall_clock::record());
+            thread_info::set_stop(tracing::now());
             auto& _thr_bundle = thread_bundle_data_t::instance();
             if(_thr_bundle && _thr_bundle->get<comp::wall_clock>() &&
                _thr_bundle->get<comp::wall_clock>()->get_is_running())
@@ -32,12 +32,18 @@
 #include <timemory/utility/popen.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #define ROCPROFSYS_SERIALIZE(MEMBER_VARIABLE)                                            \
     ar(::tim::cereal::make_nvp(#MEMBER_VARIABLE, MEMBER_VARIABLE))
@@ -48,17 +54,15 @@ namespace coverage
 {
 namespace
 {
-template <typename... Tp>
-using uomap_t = std::unordered_map<Tp...>;
+constexpr auto npos = std::numeric_limits<size_t>::max();
 //
-using coverage_thread_data_type =
-    uomap_t<std::string_view, uomap_t<std::string_view, std::map<size_t, size_t>>>;
+// per-thread hit counts indexed by the dense index of the entry in get_coverage_data()
+using coverage_thread_data_type = std::vector<size_t>;
 //
 using coverage_data_vector = std::vector<coverage_data>;
 //
-using coverage_data_map =
-    uomap_t<std::string_view,
-            uomap_t<std::string_view, std::map<size_t, coverage_data_vector::iterator>>>;
+// (file, func, address)
+using coverage_key_type = std::tuple<std::string, std::string, size_t>;
 //
 using coverage_thread_data =
     rocprofsys::thread_data<coverage_thread_data_type, code_coverage>;
@@ -84,11 +88,132 @@ get_coverage_data()
     return _v;
 }
 //
+// number of entries in get_coverage_data() which is read when a coverage entry is hit
+// instead of the size of the vector which may be modified concurrently
+auto&
+get_coverage_size()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+//
+// (file, func, address) -> dense index
+auto&
+get_coverage_index()
+{
+    static auto _v = std::map<coverage_key_type, size_t>{};
+    return _v;
+}
+//
+// id assigned by rocprof-sys-instrument -> dense index. The entries are stored in
+// chunks which are allocated on demand and never moved so that the lookups when a
+// coverage entry is hit do not need the lock while other binaries are registering.
+// An id which was assigned to different entries (e.g. when several separately
+// instrumented binaries are loaded in the same process) is resolved via the address
+// through a list of entries which are only ever appended
+struct coverage_id_entry
+{
+    std::atomic<size_t>             index   = { npos };
+    size_t                          address = 0;
+    std::atomic<coverage_id_entry*> next    = { nullptr };
+};
+//
+struct coverage_id_table
+{
+    static constexpr size_t chunk_size = 4096;
+    static constexpr size_t max_chunks = 16384;
+
+    using chunk_type = std::array<coverage_id_entry, chunk_size>;
+
+    // returns the entry of the id or nullptr if the chunk was never allocated
+    const coverage_id_entry* find(size_t _id) const
+    {
+        if(_id / chunk_size >= max_chunks) return nullptr;
+        const auto* _chunk = chunks[_id / chunk_size].load(std::memory_order_acquire);
+        return (_chunk) ? &(*_chunk)[_id % chunk_size] : nullptr;
+    }
+
+    // must be called while the coverage mutex is held
+    coverage_id_entry* emplace(size_t _id)
+    {
+        if(_id / chunk_size >= max_chunks) return nullptr;
+        auto& _chunk = chunks[_id / chunk_size];
+        if(!_chunk.load(std::memory_order_relaxed))
+            _chunk.store(new chunk_type{}, std::memory_order_release);
+        return &(*_chunk.load(std::memory_order_relaxed))[_id % chunk_size];
+    }
+
+    std::array<std::atomic<chunk_type*>, max_chunks> chunks = {};
+};
+//
+auto&
+get_coverage_ids()
+{
+    // never deleted since the instrumentation may be invoked during exit
+    static auto* _v = new coverage_id_table{};
+    return *_v;
+}
+//
+auto&
+get_coverage_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+//
 auto&
 get_coverage_count(int64_t _tid = tim::threading::get_id())
 {
     return coverage_thread_data::instance(construct_on_thread{ _tid });
 }
+//
+size_t
+add_coverage_entry(const char* file, const char* func, size_t line, size_t address,
+                   const char* source)
+{
+    auto _key = coverage_key_type{ file, func, address };
+    auto _lk  = std::unique_lock<std::mutex>{ get_coverage_mutex() };
+
+    auto& _index = get_coverage_index();
+    auto  itr    = _index.find(_key);
+    if(itr != _index.end()) return itr->second;
+
+    auto _idx = get_coverage_data().size();
+    get_coverage_data().emplace_back(
+        coverage_data{ size_t{ 0 }, address, line, file, func,
+                       (source && strlen(source) > 0) ? source : func });
+    get_coverage_size().store(_idx + 1);
+    _index.emplace(std::move(_key), _idx);
+
+    get_code_coverage().size += 1;
+    get_code_coverage().possible.modules.emplace(file);
+    get_code_coverage().possible.functions.emplace(func);
+    get_code_coverage().possible.addresses.emplace(address);
+
+    return _idx;
+}
+//
+size_t
+find_coverage_entry(size_t _id, size_t _addr)
+{
+    const auto* itr = get_coverage_ids().find(_id);
+    while(itr)
+    {
+        auto _idx = itr->index.load(std::memory_order_acquire);
+        if(_idx != npos && itr->address == _addr) return _idx;
+        itr = itr->next.load(std::memory_order_acquire);
+    }
+    return npos;
+}
+//
+void
+increment_coverage_entry(size_t _idx)
+{
+    static thread_local auto& _counts = get_coverage_count();
+    if(_idx >= _counts->size())
+        _counts->resize(std::max(_idx + 1, get_coverage_size().load()), 0);
+    ++(*_counts)[_idx];
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -114,68 +239,24 @@ post_process()
         return;
     }
 
-    auto _data = coverage_thread_data_type{};
+    // reduce the per-thread hit counts
+    for(size_t i = 0; i < coverage_thread_data::size(); ++i)
     {
-        auto _coverage_map = coverage_data_map{};
-        auto _find         = [&_coverage_data, &_coverage_map](data_tuple_t&& _v) {
-            auto& _cache = _coverage_map[std::get<0>(_v)][std::get<1>(_v)];
-            auto  mitr   = _cache.find(std::get<2>(_v));
-            if(mitr != _cache.end()) return std::make_pair(mitr->second, true);
-
-            for(auto itr = _coverage_data.begin(); itr != _coverage_data.end(); ++itr)
-            {
-                if(*itr == _v)
-                {
-                    _cache[std::get<2>(_v)] = itr;
-                    return std::make_pair(itr, true);
-                }
-            }
-            return std::make_pair(_coverage_data.end(), false);
-        };
-
-        for(size_t i = 0; i < coverage_thread_data::size(); ++i)
-        {
-            const auto& _thr_data = *get_coverage_count(i);
-            for(const auto& file : _thr_data)
-            {
-                for(const auto& func : file.second)
-                {
-                    for(const auto& addr : func.second)
-                    {
-                        _data[file.first][func.first][addr.first] += addr.second;
-                        auto&& _v = _find({ file.first, func.first, addr.first });
-                        if(_v.second)
-                        {
-                            _v.first->count += addr.second;
-                        }
-                        else
-                        {
-                            ROCPROFSYS_VERBOSE_F(0,
-                                                 "Warning! No matching coverage data for "
-                                                 "%s :: %s (0x%x)\n",
-                                                 func.first.data(), file.first.data(),
-                                                 (unsigned int) addr.first);
-                        }
-                    }
-                }
-            }
-        }
+        const auto& _counts = get_coverage_count(i);
+        if(!_counts) continue;
+        auto _n = std::min(_counts->size(), _coverage_data.size());
+        for(size_t j = 0; j < _n; ++j)
+            _coverage_data[j].count += (*_counts)[j];
     }
 
-    for(const auto& file : _data)
+    for(const auto& itr : _coverage_data)
     {
-        for(const auto& func : file.second)
+        if(itr.count > 0)
         {
-            for(const auto& addr : func.second)
-            {
-                if(addr.second > 0)
-                {
-                    _coverage.count += 1;
-                    _coverage.covered.modules.emplace(file.first);
-                    _coverage.covered.functions.emplace(func.first);
-                    _coverage.covered.addresses.emplace(addr.first);
-                }
-            }
+            _coverage.count += 1;
+            _coverage.covered.modules.emplace(itr.module);
+            _coverage.covered.functions.emplace(itr.function);
+            _coverage.covered.addresses.emplace(itr.address);
         }
     }
 
@@ -183,27 +264,15 @@ post_process()
               std::greater<coverage_data>{});
 
     {
-        auto _tmp_map     = coverage_data_map{};
-        auto _tmp         = std::decay_t<decltype(_coverage_data)>{};
-        auto _find_in_tmp = [&_tmp, &_tmp_map](const auto& _v) {
-            auto& _cache = _tmp_map[_v.module][_v.function];
-            auto  mitr   = _cache.find(_v.address);
-            if(mitr != _cache.end()) return std::make_pair(mitr->second, true);
-
-            for(auto titr = _tmp.begin(); titr != _tmp.end(); ++titr)
-            {
-                if(titr->source == _v.source && titr->address != _v.address &&
-                   titr->count == _v.count)
-                {
-                    _cache[_v.address] = titr;
-                    return std::make_pair(titr, true);
-                }
-            }
-            return std::make_pair(_tmp.end(), false);
-        };
-        for(auto&& itr : _coverage_data)
+        // drop entries with the same source and count as an entry at another address
+        // (e.g. multiple basic blocks on the same line)
+        auto _kept = std::map<std::pair<std::string_view, size_t>, size_t>{};
+        auto _tmp  = std::decay_t<decltype(_coverage_data)>{};
+        for(const auto& itr : _coverage_data)
         {
-            if(!_find_in_tmp(itr).second) _tmp.emplace_back(itr);
+            auto _key = std::make_pair(std::string_view{ itr.source }, itr.count);
+            auto kitr = _kept.emplace(_key, itr.address).first;
+            if(kitr->second == itr.address) _tmp.emplace_back(itr);
         }
         std::swap(_coverage_data, _tmp);
     }
@@ -306,31 +375,101 @@ rocprofsys_register_source_hidden(const char* file, const char* func, size_t lin
 {
     if(coverage::get_post_processed()) return;
 
-    using coverage_data = coverage::coverage_data;
-
     ROCPROFSYS_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s\n",
                                (unsigned int) address, func, file, line, source);
 
-    coverage::get_coverage_data().emplace_back(
-        coverage_data{ size_t{ 0 }, address, line, file, func,
-                       (source && strlen(source) > 0) ? source : func });
+    coverage::add_coverage_entry(file, func, line, address, source);
+}
 
-    coverage::get_code_coverage().size += 1;
-    coverage::get_code_coverage().possible.modules.emplace(file);
-    coverage::get_code_coverage().possible.functions.emplace(func);
-    coverage::get_code_coverage().possible.addresses.emplace(address);
+//--------------------------------------------------------------------------------------//
 
-    // initialize
-    for(size_t i = 0; i < coverage::coverage_thread_data::size(); ++i)
+extern "C" void
+rocprofsys_register_coverage_hidden(const char* file, const char* func, size_t address)
+{
+    if(coverage::get_post_processed()) return;
+    if(rocprofsys::get_state() < rocprofsys::State::Active &&
+       !rocprofsys_init_tooling_hidden())
+        return;
+    else if(rocprofsys::get_state() >= rocprofsys::State::Finalized)
+        return;
+
+    ROCPROFSYS_BASIC_VERBOSE_F(3, "[0x%x] %-20s :: %20s\n", (unsigned int) address, func,
+                               file);
+
+    // cache the dense index by the addresses of the strings to avoid constructing the
+    // strings for the lookup in every call
+    using cache_key_t   = std::tuple<const void*, const void*, size_t>;
+    static thread_local auto _cache = std::map<cache_key_t, size_t>{};
+
+    auto _key = cache_key_t{ file, func, address };
+    auto itr  = _cache.find(_key);
+    if(itr == _cache.end())
     {
-        (*coverage::get_coverage_count(i))[file][func].emplace(address, 0);
+        auto  _lk    = std::unique_lock<std::mutex>{ coverage::get_coverage_mutex() };
+        auto& _index = coverage::get_coverage_index();
+        auto  iitr   = _index.find(coverage::coverage_key_type{ file, func, address });
+        if(iitr == _index.end())
+        {
+            ROCPROFSYS_VERBOSE_F(0,
+                                 "Warning! No matching coverage data for %s :: %s "
+                                 "(0x%x)\n",
+                                 func, file, (unsigned int) address);
+        }
+        itr = _cache
+                  .emplace(_key, (iitr != _index.end()) ? iitr->second : coverage::npos)
+                  .first;
     }
+
+    if(itr->second != coverage::npos) coverage::increment_coverage_entry(itr->second);
 }
 
 //--------------------------------------------------------------------------------------//
 
 extern "C" void
-rocprofsys_register_coverage_hidden(const char* file, const char* func, size_t address)
+rocprofsys_register_source_id_hidden(size_t id, const char* file, const char* func,
+                                     size_t line, size_t address, const char* source)
+{
+    if(coverage::get_post_processed()) return;
+
+    ROCPROFSYS_BASIC_VERBOSE_F(4, "[%zu][0x%x] :: %-20s :: %20s:%zu :: %s\n", id,
+                               (unsigned int) address, func, file, line, source);
+
+    auto _idx = coverage::add_coverage_entry(file, func, line, address, source);
+
+    auto  _lk    = std::unique_lock<std::mutex>{ coverage::get_coverage_mutex() };
+    auto* _entry = coverage::get_coverage_ids().emplace(id);
+    if(!_entry)
+    {
+        ROCPROFSYS_VERBOSE_F(0, "Warning! Coverage id %zu exceeds the maximum id\n", id);
+        return;
+    }
+
+    // the address is written before the index is published
+    if(_entry->index.load(std::memory_order_relaxed) == coverage::npos)
+    {
+        _entry->address = address;
+        _entry->index.store(_idx, std::memory_order_release);
+        return;
+    }
+
+    for(auto* itr = _entry; itr != nullptr; itr = itr->next.load())
+    {
+        if(itr->address == address && itr->index.load() == _idx) return;
+        if(!itr->next.load())
+        {
+            auto* _collision    = new coverage::coverage_id_entry{};
+            _collision->address = address;
+            _collision->index.store(_idx, std::memory_order_relaxed);
+            itr->next.store(_collision, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------//
+
+extern "C" void
+rocprofsys_register_coverage_id_hidden(size_t id, size_t address)
 {
     if(coverage::get_post_processed()) return;
     if(rocprofsys::get_state() < rocprofsys::State::Active &&
@@ -339,9 +478,15 @@ rocprofsys_register_coverage_hidden(const char* file, const char* func, size_t a
     else if(rocprofsys::get_state() >= rocprofsys::State::Finalized)
         return;
 
-    ROCPROFSYS_BASIC_VERBOSE_F(3, "[0x%x] %-20s :: %20s\n", (unsigned int) address, func,
-                               file);
-    (*coverage::get_coverage_count())[file][func][address] += 1;
+    auto _idx = coverage::find_coverage_entry(id, address);
+    if(_idx == coverage::npos)
+    {
+        ROCPROFSYS_VERBOSE_F(0, "Warning! No matching coverage data for id %zu (0x%x)\n",
+                             id, (unsigned int) address);
+        return;
+    }
+
+    coverage::increment_coverage_entry(_idx);
 }
 
 //--------------------------------------------------------------------------------------//
@@ -27,6 +27,7 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/timestamp.hpp"
 #include "core/timemory.hpp"
 #include "library/components/cpu_freq.hpp"
 #include "library/thread_data.hpp"
@@ -55,9 +56,54 @@ using type_list = tim::type_list<Tp...>;
 
 namespace
 {
-using cpu_data_tuple_t = std::tuple<size_t, int64_t, int64_t, int64_t, int64_t, int64_t,
-                                    int64_t, int64_t, component::cpu_freq>;
-std::deque<cpu_data_tuple_t> data = {};
+// the samples are stored as a structure of arrays (one array per quantity and one array
+// per enabled CPU for the frequencies) and are written to the perfetto counter tracks
+// whenever the number of samples reaches ROCPROFSYS_PROCESS_SAMPLING_BUFFER_SIZE so
+// that the memory usage does not grow with the runtime of the process
+struct sample_buffer
+{
+    size_t size() const { return timestamp.size(); }
+    void   reserve(size_t _n);
+    void   clear();
+
+    std::vector<uint64_t>              timestamp        = {};
+    std::vector<int64_t>               page_rss         = {};
+    std::vector<int64_t>               virt_mem         = {};
+    std::vector<int64_t>               peak_rss         = {};
+    std::vector<int64_t>               context_switch   = {};
+    std::vector<int64_t>               page_fault       = {};
+    std::vector<int64_t>               user_mode_time   = {};
+    std::vector<int64_t>               kernel_mode_time = {};
+    std::vector<std::vector<float>>    freq             = {};
+};
+
+void
+sample_buffer::reserve(size_t _n)
+{
+    for(auto* itr : { &page_rss, &virt_mem, &peak_rss, &context_switch, &page_fault,
+                      &user_mode_time, &kernel_mode_time })
+        itr->reserve(_n);
+    timestamp.reserve(_n);
+    for(auto& itr : freq)
+        itr.reserve(_n);
+}
+
+void
+sample_buffer::clear()
+{
+    for(auto* itr : { &page_rss, &virt_mem, &peak_rss, &context_switch, &page_fault,
+                      &user_mode_time, &kernel_mode_time })
+        itr->clear();
+    timestamp.clear();
+    for(auto& itr : freq)
+        itr.clear();
+}
+
+sample_buffer data        = {};
+size_t        num_samples = 0;
+
+void
+flush();
 
 template <typename... Types>
 void init_perfetto_counter_tracks(type_list<Types...>)
@@ -75,6 +121,13 @@ namespace cpu_freq
 void
 setup()
 {
+    auto _capacity = config::get_process_sampling_buffer_size();
+    if(_capacity > 0)
+    {
+        data.freq.resize(component::cpu_freq::get_enabled_cpus().size());
+        data.reserve(_capacity);
+    }
+
     init_perfetto_counter_tracks(
         type_list<category::cpu_freq, category::process_page, category::process_virt,
                   category::process_peak, category::process_context_switch,
@@ -91,19 +144,30 @@ config()
 void
 sample()
 {
-    auto _ts = tim::get_clock_real_now<size_t, std::nano>();
+    auto _ts = static_cast<size_t>(timestamp::now());
 
     auto _rcache = tim::rusage_cache{ RUSAGE_SELF };
-    auto _freqs  = component::cpu_freq{}.sample();
+    auto _freqs  = component::cpu_freq{}.sample().get();
+
+    if(data.freq.size() != _freqs.size()) data.freq.resize(_freqs.size());
 
     // user and kernel mode times are in microseconds
-    data.emplace_back(
-        _ts, tim::get_page_rss(), tim::get_virt_mem(), _rcache.get_peak_rss(),
-        _rcache.get_num_priority_context_switch() +
-            _rcache.get_num_voluntary_context_switch(),
-        _rcache.get_num_major_page_faults() + _rcache.get_num_minor_page_faults(),
-        _rcache.get_user_mode_time() * 1000, _rcache.get_kernel_mode_time() * 1000,
-        std::move(_freqs));
+    data.timestamp.emplace_back(_ts);
+    data.page_rss.emplace_back(tim::get_page_rss());
+    data.virt_mem.emplace_back(tim::get_virt_mem());
+    data.peak_rss.emplace_back(_rcache.get_peak_rss());
+    data.context_switch.emplace_back(_rcache.get_num_priority_context_switch() +
+                                     _rcache.get_num_voluntary_context_switch());
+    data.page_fault.emplace_back(_rcache.get_num_major_page_faults() +
+                                 _rcache.get_num_minor_page_faults());
+    data.user_mode_time.emplace_back(_rcache.get_user_mode_time() * 1000);
+    data.kernel_mode_time.emplace_back(_rcache.get_kernel_mode_time() * 1000);
+    for(size_t i = 0; i < data.freq.size(); ++i)
+        data.freq[i].emplace_back(_freqs[i]);
+    ++num_samples;
+
+    auto _capacity = config::get_process_sampling_buffer_size();
+    if(_capacity > 0 && data.size() >= _capacity) flush();
 }
 
 void
@@ -154,21 +218,21 @@ write_perfetto_counter_track(index&& _idx, Args... _args)
     using track = perfetto_counter_track<Tp>;
     TRACE_COUNTER(trait::name<Tp>::value, track::at(_idx.value, 0), _args...);
 }
-}  // namespace
 
 void
-post_process()
+config_perfetto_counter_tracks()
 {
-    ROCPROFSYS_VERBOSE(1,
-                       "Post-processing %zu cpu frequency and memory usage entries...\n",
-                       data.size());
-    auto _process_frequencies = [](size_t _idx, size_t _offset) {
-        using freq_track = perfetto_counter_track<category::cpu_freq>;
-
-        const auto& _thread_info = thread_info::get(0, InternalTID);
-        ROCPROFSYS_CI_THROW(!_thread_info, "Missing thread info for thread 0");
-        if(!_thread_info) return;
+    config_perfetto_counter_tracks(
+        type_list<category::process_page, category::process_virt, category::process_peak,
+                  category::process_context_switch, category::process_page_fault,
+                  category::process_user_mode_time, category::process_kernel_mode_time>{},
+        { "Memory Usage", "Virtual Memory Usage", "Peak Memory", "Context Switches",
+          "Page Faults", "User Time", "Kernel Time" },
+        { "MB", "MB", "MB", "", "", "sec", "sec" });
 
+    using freq_track = perfetto_counter_track<category::cpu_freq>;
+    for(auto _idx : component::cpu_freq::get_enabled_cpus())
+    {
         if(!freq_track::exists(_idx))
         {
             auto addendum = [&](const char* _v) {
@@ -176,59 +240,89 @@ post_process()
             };
             freq_track::emplace(_idx, addendum("Frequency"), "MHz");
         }
+    }
+}
 
-        for(auto& itr : data)
-        {
-            uint64_t _ts   = std::get<0>(itr);
-            double   _freq = static_cast<double>(std::get<8>(itr).at(_offset));
-            if(!_thread_info->is_valid_time(_ts)) continue;
-            write_perfetto_counter_track<category::cpu_freq>(index{ _idx }, _ts, _freq);
-        }
+// writes the buffered samples to the perfetto counter tracks and clears the buffer.
+// Invoked by the sampling thread when the buffer is full and once more during
+// post-processing.
+void
+flush()
+{
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    ROCPROFSYS_CI_THROW(!_thread_info, "Missing thread info for thread 0");
+    if(!_thread_info)
+    {
+        data.clear();
+        return;
+    }
 
-        auto _end_ts = _thread_info->get_stop();
-        write_perfetto_counter_track<category::cpu_freq>(index{ _idx }, _end_ts, 0);
+    config_perfetto_counter_tracks();
+
+    // the end of the lifetime of the main thread is not set until finalization
+    auto _beg_ts      = _thread_info->lifetime.first;
+    auto _end_ts      = _thread_info->get_stop();
+    auto _is_valid_ts = [_beg_ts, _end_ts](uint64_t _ts) {
+        return (_ts >= _beg_ts && (_end_ts == 0 || _ts <= _end_ts));
     };
 
-    auto _process_cpu_rusage = []() {
-        config_perfetto_counter_tracks(
-            type_list<category::process_page, category::process_virt,
-                      category::process_peak, category::process_context_switch,
-                      category::process_page_fault, category::process_user_mode_time,
-                      category::process_kernel_mode_time>{},
-            { "Memory Usage", "Virtual Memory Usage", "Peak Memory", "Context Switches",
-              "Page Faults", "User Time", "Kernel Time" },
-            { "MB", "MB", "MB", "", "", "sec", "sec" });
-
-        const auto& _thread_info = thread_info::get(0, InternalTID);
-        ROCPROFSYS_CI_THROW(!_thread_info, "Missing thread info for thread 0");
-        if(!_thread_info) return;
-
-        for(auto& itr : data)
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        uint64_t _ts = data.timestamp[i];
+        if(!_is_valid_ts(_ts)) continue;
+
+        double   _page = data.page_rss[i];
+        double   _virt = data.virt_mem[i];
+        double   _peak = data.peak_rss[i];
+        uint64_t _cntx = data.context_switch[i];
+        uint64_t _flts = data.page_fault[i];
+        double   _user = data.user_mode_time[i];
+        double   _kern = data.kernel_mode_time[i];
+        write_perfetto_counter_track<category::process_page>(_ts,
+                                                             _page / units::megabyte);
+        write_perfetto_counter_track<category::process_virt>(_ts,
+                                                             _virt / units::megabyte);
+        write_perfetto_counter_track<category::process_peak>(_ts,
+                                                             _peak / units::megabyte);
+        write_perfetto_counter_track<category::process_context_switch>(_ts, _cntx);
+        write_perfetto_counter_track<category::process_page_fault>(_ts, _flts);
+        write_perfetto_counter_track<category::process_user_mode_time>(
+            _ts, _user / units::sec);
+        write_perfetto_counter_track<category::process_kernel_mode_time>(
+            _ts, _kern / units::sec);
+    }
+
+    auto& enabled_cpu_freqs = component::cpu_freq::get_enabled_cpus();
+    auto  _offset           = size_t{ 0 };
+    for(auto itr = enabled_cpu_freqs.begin();
+        itr != enabled_cpu_freqs.end() && _offset < data.freq.size(); ++itr, ++_offset)
+    {
+        const auto& _freqs = data.freq[_offset];
+        for(size_t i = 0; i < _freqs.size(); ++i)
         {
-            uint64_t _ts = std::get<0>(itr);
-            if(!_thread_info->is_valid_time(_ts)) continue;
-
-            double   _page = std::get<1>(itr);
-            double   _virt = std::get<2>(itr);
-            double   _peak = std::get<3>(itr);
-            uint64_t _cntx = std::get<4>(itr);
-            uint64_t _flts = std::get<5>(itr);
-            double   _user = std::get<6>(itr);
-            double   _kern = std::get<7>(itr);
-            write_perfetto_counter_track<category::process_page>(_ts,
-                                                                 _page / units::megabyte);
-            write_perfetto_counter_track<category::process_virt>(_ts,
-                                                                 _virt / units::megabyte);
-            write_perfetto_counter_track<category::process_peak>(_ts,
-                                                                 _peak / units::megabyte);
-            write_perfetto_counter_track<category::process_context_switch>(_ts, _cntx);
-            write_perfetto_counter_track<category::process_page_fault>(_ts, _flts);
-            write_perfetto_counter_track<category::process_user_mode_time>(
-                _ts, _user / units::sec);
-            write_perfetto_counter_track<category::process_kernel_mode_time>(
-                _ts, _kern / units::sec);
+            uint64_t _ts = data.timestamp[i];
+            if(!_is_valid_ts(_ts)) continue;
+            write_perfetto_counter_track<category::cpu_freq>(
+                index{ *itr }, _ts, static_cast<double>(_freqs[i]));
         }
+    }
 
+    data.clear();
+}
+}  // namespace
+
+void
+post_process()
+{
+    ROCPROFSYS_VERBOSE(1,
+                       "Post-processing %zu cpu frequency and memory usage entries...\n",
+                       num_samples);
+
+    flush();
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    if(_thread_info)
+    {
         auto _end_ts = _thread_info->get_stop();
         write_perfetto_counter_track<category::process_page>(_end_ts, 0.0);
         write_perfetto_counter_track<category::process_virt>(_end_ts, 0.0);
@@ -237,18 +331,14 @@ post_process()
         write_perfetto_counter_track<category::process_page_fault>(_end_ts, 0);
         write_perfetto_counter_track<category::process_user_mode_time>(_end_ts, 0.0);
         write_perfetto_counter_track<category::process_kernel_mode_time>(_end_ts, 0.0);
-    };
-
-    _process_cpu_rusage();
 
-    auto& enabled_cpu_freqs = component::cpu_freq::get_enabled_cpus();
-    for(auto itr = enabled_cpu_freqs.begin(); itr != enabled_cpu_freqs.end(); ++itr)
-    {
-        auto _idx    = *itr;
-        auto _offset = std::distance(enabled_cpu_freqs.begin(), itr);
-        _process_frequencies(_idx, _offset);
+        for(auto _idx : component::cpu_freq::get_enabled_cpus())
+            write_perfetto_counter_track<category::cpu_freq>(index{ _idx }, _end_ts, 0);
     }
-    enabled_cpu_freqs.clear();
+
+    component::cpu_freq::get_enabled_cpus().clear();
+    data.freq.clear();
+    num_samples = 0;
 }
 }  // namespace cpu_freq
 }  // namespace rocprofsys
@@ -0,0 +1,496 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/event_log.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/timestamp.hpp"
+#include "library/ptl.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/components/timing/wall_clock.hpp>
+#include <timemory/components/trip_count/extern.hpp>
+#include <timemory/hash/declaration.hpp>
+#include <timemory/variadic/lightweight_tuple.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+namespace rocprofsys
+{
+namespace event_log
+{
+std::atomic<bool> active = { false };
+
+namespace
+{
+// each segment is one anonymous mapping: the first record-sized slot links the
+// segments of a thread together and the remaining slots hold the records. The pages
+// are only committed when they are first written
+constexpr size_t segment_bytes = (1UL << 20);
+
+struct segment
+{
+    segment* next = nullptr;
+    uint64_t reserved = 0;
+    record   records[(segment_bytes / sizeof(record)) - 1];
+};
+
+static_assert(sizeof(segment) == segment_bytes, "segment must fill the mapping");
+
+// allocated once per thread when the first segment is mapped. The number of records
+// is published with a release store after each record is written (and after a new
+// segment is linked) so that the post-processing only reads complete records even when
+// the thread is still running
+struct thread_log
+{
+    int64_t               tid       = 0;
+    segment*              head      = nullptr;
+    segment*              tail      = nullptr;
+    std::atomic<uint64_t> committed = { 0 };
+};
+
+// constant-initialized so that the thread-local access does not need a guard
+struct thread_cursor
+{
+    record*     cursor = nullptr;
+    record*     end    = nullptr;
+    thread_log* log    = nullptr;
+    uint64_t    count  = 0;
+    bool        failed = false;
+};
+
+thread_local thread_cursor tl_cursor = {};
+
+// the names are copied when they are first seen since a library which is unloaded
+// before the finalization takes the memory of its names with it. The ids are dense and
+// start at one since a zero identifier marks the end of a segment
+struct name_table
+{
+    std::mutex                                     mutex = {};
+    std::deque<std::string>                        names = {};
+    std::unordered_map<std::string_view, uint64_t> ids   = {};
+};
+
+auto&
+get_name_table()
+{
+    static auto* _v = new name_table{};
+    return *_v;
+}
+
+// direct-mapped per-thread cache of the name address to its id so that the name table
+// is only locked the first time a thread sees a name. The address alone is not enough
+// since a library which is unloaded may be replaced by another one whose names occupy
+// the same addresses so a hit is confirmed against the copy in the name table
+constexpr size_t name_cache_size = 256;
+
+struct name_cache_entry
+{
+    const char* name     = nullptr;
+    const char* interned = nullptr;
+    uint64_t    id       = 0;
+};
+
+thread_local name_cache_entry tl_name_cache[name_cache_size] = {};
+
+ROCPROFSYS_NOINLINE uint64_t
+intern(name_cache_entry& _entry, const char* _name)
+{
+    auto& _tbl = get_name_table();
+    auto  _lk  = std::unique_lock<std::mutex>{ _tbl.mutex };
+    auto  itr  = _tbl.ids.find(std::string_view{ _name });
+    if(itr == _tbl.ids.end())
+    {
+        const auto& _v = _tbl.names.emplace_back(_name);
+        itr            = _tbl.ids.emplace(_v, _tbl.names.size()).first;
+    }
+
+    // the keys are views of the strings in the deque which are never relocated
+    _entry = name_cache_entry{ _name, itr->first.data(), itr->second };
+    return _entry.id;
+}
+
+ROCPROFSYS_INLINE uint64_t
+get_id(const char* _name)
+{
+    auto& _entry =
+        tl_name_cache[(reinterpret_cast<uintptr_t>(_name) >> 3) % name_cache_size];
+    if(ROCPROFSYS_LIKELY(_entry.name == _name && strcmp(_name, _entry.interned) == 0))
+        return _entry.id;
+    return intern(_entry, _name);
+}
+
+auto&
+get_thread_logs()
+{
+    static auto _v = std::vector<thread_log*>{};
+    return _v;
+}
+
+auto&
+get_thread_logs_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+ROCPROFSYS_NOINLINE bool
+grow(thread_cursor& _cur)
+{
+    if(_cur.failed) return false;
+
+    void* _addr = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(_addr == MAP_FAILED)
+    {
+        _cur.failed = true;
+        ROCPROFSYS_WARNING_F(0,
+                             "[event_log] mapping a %zu KB segment failed: %s. The "
+                             "remaining events of thread %li are dropped\n",
+                             segment_bytes / 1024, strerror(errno),
+                             (_cur.log) ? _cur.log->tid : threading::get_id());
+        return false;
+    }
+
+    auto* _seg = static_cast<segment*>(_addr);
+    if(!_cur.log)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_thread_logs_mutex() };
+        _cur.log = get_thread_logs().emplace_back(
+            new thread_log{ threading::get_id(), _seg, _seg });
+    }
+    else
+    {
+        // published along with the first record of the segment
+        _cur.log->tail->next = _seg;
+        _cur.log->tail       = _seg;
+    }
+
+    _cur.cursor = std::begin(_seg->records);
+    _cur.end    = std::end(_seg->records);
+    return true;
+}
+
+// the child of a fork only has the forking thread so the copies of the logs of the
+// parent can be released
+void
+reset_child()
+{
+    for(auto* itr : get_thread_logs())
+    {
+        for(auto* _seg = itr->head; _seg != nullptr;)
+        {
+            auto* _next = _seg->next;
+            munmap(_seg, segment_bytes);
+            _seg = _next;
+        }
+        delete itr;
+    }
+    get_thread_logs().clear();
+    tl_cursor = {};
+    for(auto& itr : tl_name_cache)
+        itr = name_cache_entry{};
+}
+
+ROCPROFSYS_INLINE void
+append(uint64_t _id)
+{
+    auto& _cur = tl_cursor;
+    if(ROCPROFSYS_UNLIKELY(_cur.cursor == _cur.end) && !grow(_cur)) return;
+    *_cur.cursor++ = record{ _id, timestamp::now() };
+    _cur.log->committed.store(++_cur.count, std::memory_order_release);
+}
+
+struct slice
+{
+    uint64_t id    = 0;
+    uint64_t beg   = 0;
+    uint64_t end   = 0;
+    size_t   depth = 0;
+};
+
+// the slices are stored in the order of their entry so the nesting is reconstructed
+// from the depth alone
+struct thread_slices
+{
+    int64_t            tid       = 0;
+    size_t             records   = 0;
+    size_t             unmatched = 0;
+    size_t             max_depth = 0;
+    std::vector<slice> slices    = {};
+};
+
+thread_slices
+decode(const thread_log* _log)
+{
+    auto     _data  = thread_slices{};
+    auto     _stack = std::vector<size_t>{};
+    uint64_t _last  = 0;
+
+    // the records after the committed count may still be written by the thread
+    auto _n = _log->committed.load(std::memory_order_acquire);
+
+    // the link to the next segment is only read while committed records remain
+    _data.tid = _log->tid;
+    for(const auto* _seg = _log->head; _data.records < _n;)
+    {
+        for(const auto& itr : _seg->records)
+        {
+            if(_data.records == _n) break;
+
+            ++_data.records;
+            _last = std::max(_last, itr.timestamp);
+
+            if((itr.id & exit_flag) == 0)
+            {
+                _data.max_depth = std::max(_data.max_depth, _stack.size());
+                _data.slices.emplace_back(
+                    slice{ itr.id, itr.timestamp, 0, _stack.size() });
+                _stack.emplace_back(_data.slices.size() - 1);
+                continue;
+            }
+
+            // close the matching entry along with any entries above it whose exit
+            // was not recorded. Exits without an entry are ignored
+            auto _id    = (itr.id & ~exit_flag);
+            auto _match = std::find_if(_stack.rbegin(), _stack.rend(), [&](size_t _idx) {
+                return _data.slices.at(_idx).id == _id;
+            });
+            if(_match == _stack.rend())
+            {
+                ++_data.unmatched;
+                continue;
+            }
+
+            auto _n = std::distance(_stack.rbegin(), _match) + 1;
+            _data.unmatched += (_n - 1);
+            for(decltype(_n) i = 0; i < _n; ++i)
+            {
+                _data.slices.at(_stack.back()).end = itr.timestamp;
+                _stack.pop_back();
+            }
+        }
+
+        if(_data.records < _n) _seg = _seg->next;
+    }
+
+    // entries which are still open (e.g. main) end at the last event of the thread
+    for(auto itr : _stack)
+        _data.slices.at(itr).end = _last;
+
+    return _data;
+}
+
+using name_map_t = std::unordered_map<uint64_t, std::pair<const char*, size_t>>;
+
+void
+post_process_perfetto(const thread_slices& _data, const name_map_t& _names)
+{
+    const auto& _thread_info = thread_info::get(_data.tid, SequentTID);
+    if(!_thread_info) return;
+
+    auto _track = tracing::get_perfetto_track(
+        category::host{},
+        [](auto _seq_id, auto _sys_id) {
+            return TIMEMORY_JOIN(" ", "Thread", _seq_id, "(E)", _sys_id);
+        },
+        _thread_info->index_data->sequent_value, _thread_info->index_data->system_value);
+
+    auto _open = std::vector<const slice*>{};
+    auto _pop  = [&](size_t _depth) {
+        while(_open.size() > _depth)
+        {
+            tracing::pop_perfetto_track(category::host{},
+                                        _names.at(_open.back()->id).first, _track,
+                                        _open.back()->end);
+            _open.pop_back();
+        }
+    };
+
+    for(const auto& itr : _data.slices)
+    {
+        _pop(itr.depth);
+        tracing::push_perfetto_track(category::host{}, _names.at(itr.id).first, _track,
+                                     itr.beg);
+        _open.emplace_back(&itr);
+    }
+    _pop(0);
+}
+
+void
+post_process_timemory(const thread_slices& _data, const name_map_t& _names)
+{
+    using bundle_t = tim::lightweight_tuple<comp::trip_count, comp::wall_clock>;
+
+    // reserved up front so that the open bundles are never relocated
+    auto _open = std::vector<std::pair<bundle_t, const slice*>>{};
+    _open.reserve(_data.max_depth + 1);
+
+    auto _pop = [&](size_t _depth) {
+        while(_open.size() > _depth)
+        {
+            auto& [_bundle, _slice] = _open.back();
+            _bundle.stop();
+            if(auto* _wc = _bundle.get<comp::wall_clock>())
+            {
+                auto _value = static_cast<int64_t>(_slice->end - _slice->beg);
+                _wc->set_value(_value);
+                _wc->set_accum(_value);
+            }
+            _bundle.pop();
+            _open.pop_back();
+        }
+    };
+
+    for(const auto& itr : _data.slices)
+    {
+        _pop(itr.depth);
+        const auto& _name = _names.at(itr.id);
+        _open.emplace_back(bundle_t{ tim::string_view_t{ _name.first, _name.second } },
+                           &itr);
+        _open.back().first.push(_data.tid);
+        _open.back().first.start();
+    }
+    _pop(0);
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_use_event_log()) return;
+
+    ROCPROFSYS_VERBOSE_F(1, "[event_log] Recording instrumented functions in %zu KB "
+                            "segments per thread...\n",
+                         segment_bytes / 1024);
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() { pthread_atfork(nullptr, nullptr, &reset_child); });
+    active.store(true, std::memory_order_relaxed);
+}
+
+void
+enter(const char* _name)
+{
+    if(get_thread_state() == ThreadState::Disabled) return;
+    append(get_id(_name));
+}
+
+void
+exit(const char* _name)
+{
+    if(get_thread_state() == ThreadState::Disabled) return;
+    append(get_id(_name) | exit_flag);
+}
+
+void
+post_process()
+{
+    if(!is_active()) return;
+
+    // threads which are still running fall back to the regular regions, which are
+    // ignored after finalization. The segments stay mapped since such a thread may be
+    // in the middle of appending a record, which is excluded by the committed count
+    active.store(false, std::memory_order_seq_cst);
+
+    auto _beg  = std::chrono::steady_clock::now();
+    auto _logs = std::vector<thread_log*>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_thread_logs_mutex() };
+        _logs    = get_thread_logs();
+    }
+
+    auto _data = std::vector<thread_slices>(_logs.size());
+    if(_logs.size() > 1)
+    {
+        auto& _tg = tasking::general::get_task_group();
+        for(size_t i = 0; i < _logs.size(); ++i)
+            _tg.exec([i, &_data, &_logs]() { _data.at(i) = decode(_logs.at(i)); });
+        _tg.join();
+    }
+    else if(!_logs.empty())
+    {
+        _data.front() = decode(_logs.front());
+    }
+
+    // the names are copied into the timemory hash-table before the emission, which
+    // happens serially and in thread order so that the output is deterministic
+    auto _names = name_map_t{};
+    {
+        auto& _table = get_name_table();
+        auto  _lk    = std::unique_lock<std::mutex>{ _table.mutex };
+        for(const auto& itr : _data)
+        {
+            for(const auto& sitr : itr.slices)
+            {
+                if(_names.count(sitr.id) > 0) continue;
+                auto _hash = tim::add_hash_id(_table.names.at(sitr.id - 1));
+                auto _name = tim::string_view_t{ tim::get_hash_identifier_fast(_hash) };
+                _names.emplace(sitr.id, std::make_pair(_name.data(), _name.length()));
+            }
+        }
+    }
+
+    size_t _nrecords   = 0;
+    size_t _nslices    = 0;
+    size_t _nunmatched = 0;
+    for(const auto& itr : _data)
+    {
+        _nrecords += itr.records;
+        _nslices += itr.slices.size();
+        _nunmatched += itr.unmatched;
+
+        if(itr.slices.empty()) continue;
+
+        if(get_use_perfetto()) post_process_perfetto(itr, _names);
+        if(get_use_timemory()) post_process_timemory(itr, _names);
+    }
+
+    ROCPROFSYS_VERBOSE_F(1,
+                         "[event_log] Converted %zu records from %zu threads into %zu "
+                         "regions (%zu unmatched) in %.3f sec...\n",
+                         _nrecords, _data.size(), _nslices, _nunmatched,
+                         std::chrono::duration<double>{ std::chrono::steady_clock::now() -
+                                                        _beg }
+                             .count());
+}
+}  // namespace event_log
+}  // namespace rocprofsys
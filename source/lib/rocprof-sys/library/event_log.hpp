@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace rocprofsys
+{
+namespace event_log
+{
+// a single entry or exit of an instrumented function. The identifier is the (non-zero)
+// interned id of the name of the function with the most-significant bit set for exits
+struct record
+{
+    uint64_t id        = 0;
+    uint64_t timestamp = 0;
+};
+
+static_assert(sizeof(record) == 16, "event_log::record must be 16 bytes");
+
+inline constexpr uint64_t exit_flag = (1ULL << 63);
+
+extern ROCPROFSYS_HIDDEN_API std::atomic<bool> active;
+
+// starts routing the instrumented function entries and exits to the event logs
+void
+setup();
+
+// stops recording and converts the event logs into perfetto slices and timemory
+// call-graph entries
+void
+post_process();
+
+ROCPROFSYS_INLINE bool
+is_active()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+void
+enter(const char* _name) ROCPROFSYS_HOT;
+
+void
+exit(const char* _name) ROCPROFSYS_HOT;
+}  // namespace event_log
+}  // namespace rocprofsys
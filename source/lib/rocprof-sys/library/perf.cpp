@@ -26,15 +26,19 @@
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
+#include "library/runtime.hpp"
 #include "library/thread_data.hpp"
 
+#include <timemory/backends/threading.hpp>
 #include <timemory/log/logger.hpp>
 #include <timemory/log/macros.hpp>
 #include <timemory/units.hpp>
 
+#include <array>
 #include <asm/unistd.h>
 #include <ctime>
 #include <fcntl.h>
+#include <limits>
 #include <linux/perf_event.h>
 #include <mutex>
 #include <poll.h>
@@ -44,6 +48,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -101,7 +107,8 @@ perf_event::perf_event(perf_event&& rhs) noexcept
         ROCPROFSYS_VERBOSE(1, "Closed perf event fd %li\n", m_fd);
     }
 
-    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, sizes.mmap);
+    if(m_mapping != nullptr && m_mapping != rhs.m_mapping)
+        munmap(m_mapping, m_data_size + sizes.page);
 
     // take rhs perf event's file descriptor and replace it with -1
     m_fd     = rhs.m_fd;
@@ -111,9 +118,12 @@ perf_event::perf_event(perf_event&& rhs) noexcept
     m_mapping     = rhs.m_mapping;
     rhs.m_mapping = nullptr;
 
-    // Copy over the sample type and read format
-    m_sample_type = rhs.m_sample_type;
-    m_read_format = rhs.m_read_format;
+    // Copy over the sample type, read format, and ring buffer configuration
+    m_sample_type      = rhs.m_sample_type;
+    m_read_format      = rhs.m_read_format;
+    m_sample_regs_user = rhs.m_sample_regs_user;
+    m_data_size        = rhs.m_data_size;
+    m_record_buffer    = std::move(rhs.m_record_buffer);
 }
 
 /// Close the perf_event file descriptor and unmap the ring buffer
@@ -129,7 +139,8 @@ perf_event::operator=(perf_event&& rhs) noexcept
     // Release resources if the current perf_event is initialized and not equal to this
     // one
     if(m_fd != -1 && m_fd != rhs.m_fd) ::close(m_fd);
-    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, sizes.mmap);
+    if(m_mapping != nullptr && m_mapping != rhs.m_mapping)
+        munmap(m_mapping, m_data_size + sizes.page);
 
     // take rhs perf event's file descriptor and replace it with -1
     m_fd     = rhs.m_fd;
@@ -139,28 +150,47 @@ perf_event::operator=(perf_event&& rhs) noexcept
     m_mapping     = rhs.m_mapping;
     rhs.m_mapping = nullptr;
 
-    // Copy over the sample type and read format
-    m_sample_type = rhs.m_sample_type;
-    m_read_format = rhs.m_read_format;
+    // Copy over the sample type, read format, and ring buffer configuration
+    m_sample_type      = rhs.m_sample_type;
+    m_read_format      = rhs.m_read_format;
+    m_sample_regs_user = rhs.m_sample_regs_user;
+    m_data_size        = rhs.m_data_size;
+    m_record_buffer    = std::move(rhs.m_record_buffer);
 
     return *this;
 }
 
 // Open a perf_event file and map it (if sampling is enabled)
 std::optional<std::string>
-perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
+perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu, int _group_fd)
 {
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
-    m_sample_type = _pe.sample_type;
-    m_read_format = _pe.read_format;
-    m_batch_size  = _pe.wakeup_events;
+    m_sample_type      = _pe.sample_type;
+    m_read_format      = _pe.read_format;
+    m_batch_size       = _pe.wakeup_events;
+    m_sample_regs_user = _pe.sample_regs_user;
+    m_data_size        = sizes.data;
+
+    // records with a copy of the user stack need a larger ring buffer (power of 2 number
+    // of pages) and record buffer (the size of a record is limited to 64 KB)
+    if(is_sampling(sample::stack) && _pe.sample_stack_user > 0)
+    {
+        const size_t _min_size = 8 * (_pe.sample_stack_user + 1024);
+        while(m_data_size < _min_size)
+            m_data_size *= 2;
+        m_record_buffer.resize(std::numeric_limits<uint16_t>::max() + 1);
+    }
+    else
+    {
+        m_record_buffer.resize(4096);
+    }
 
-    // Set some mandatory fields
+    // Set some mandatory fields. Group members follow the state of the group leader
     _pe.size     = sizeof(struct perf_event_attr);
-    _pe.disabled = 1;
+    _pe.disabled = (_group_fd == -1) ? 1 : 0;
 
     // Open the file
-    m_fd = perf_event_open(&_pe, _pid, _cpu, -1, 0);
+    m_fd = perf_event_open(&_pe, _pid, _cpu, _group_fd, 0);
     if(m_fd == -1)
     {
         std::string path = "/proc/sys/kernel/perf_event_paranoid";
@@ -187,7 +217,8 @@ perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
     if(_pe.sample_type != 0 && _pe.sample_period != 0)
     {
         void* ring_buffer =
-            mmap(nullptr, sizes.mmap, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            mmap(nullptr, m_data_size + sizes.page, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 m_fd, 0);
 
         ROCPROFSYS_RETURN_ERROR_MSG(
             ring_buffer == MAP_FAILED,
@@ -298,7 +329,7 @@ perf_event::close()
 
     if(m_mapping != nullptr)
     {
-        munmap(m_mapping, sizes.mmap);
+        munmap(m_mapping, m_data_size + sizes.page);
         m_mapping = nullptr;
     }
 }
@@ -320,6 +351,164 @@ perf_event::set_ready_signal(int sig) const
         << "failed to set the owner of the perf_event file";
 }
 
+namespace
+{
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t
+rdpmc(uint32_t _idx)
+{
+    uint32_t _lo = 0;
+    uint32_t _hi = 0;
+    asm volatile("rdpmc" : "=a"(_lo), "=d"(_hi) : "c"(_idx));
+    return (static_cast<uint64_t>(_hi) << 32) | _lo;
+}
+#endif
+}  // namespace
+
+counter_group::~counter_group() { close(); }
+
+std::optional<std::string>
+counter_group::open(std::vector<struct perf_event_attr> _attrs, pid_t _pid, int _cpu)
+{
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+    close();
+
+    ROCPROFSYS_RETURN_ERROR_MSG(_attrs.empty(), "No events for the perf counter group");
+    ROCPROFSYS_RETURN_ERROR_MSG(_attrs.size() > max_events,
+                                "Too many events for the perf counter group: "
+                                    << _attrs.size() << " (max: " << max_events << ")");
+
+    bool _hw_only = true;
+    m_events.reserve(_attrs.size());
+    for(auto& itr : _attrs)
+    {
+        itr.sample_type   = 0;
+        itr.sample_period = 0;
+        itr.read_format   = PERF_FORMAT_GROUP;
+        _hw_only = _hw_only && (itr.type == PERF_TYPE_HARDWARE ||
+                                itr.type == PERF_TYPE_HW_CACHE ||
+                                itr.type == PERF_TYPE_RAW);
+
+        int   _group_fd = (m_events.empty()) ? -1 : m_events.front().get_fileno();
+        auto& _event    = m_events.emplace_back();
+        if(auto _err = _event.open(itr, _pid, _cpu, _group_fd); _err)
+        {
+            close();
+            return _err;
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // software events are only counted in the kernel so rdpmc requires every event in
+    // the group to be a hardware event
+    if(_hw_only && _pid == 0)
+    {
+        for(const auto& itr : m_events)
+        {
+            void* _page =
+                mmap(nullptr, sizes.page, PROT_READ, MAP_SHARED, itr.get_fileno(), 0);
+            if(_page == MAP_FAILED) break;
+            m_pages.emplace_back(reinterpret_cast<struct perf_event_mmap_page*>(_page));
+        }
+
+        bool _rdpmc = (m_pages.size() == m_events.size());
+        for(const auto* itr : m_pages)
+            _rdpmc = _rdpmc && itr->cap_user_rdpmc != 0;
+
+        if(!_rdpmc)
+        {
+            for(auto* itr : m_pages)
+                munmap(itr, sizes.page);
+            m_pages.clear();
+        }
+    }
+#else
+    (void) _hw_only;
+#endif
+
+    return std::optional<std::string>{};
+}
+
+bool
+counter_group::start() const
+{
+    return (!m_events.empty()) ? m_events.front().start() : false;
+}
+
+bool
+counter_group::stop() const
+{
+    return (!m_events.empty()) ? m_events.front().stop() : false;
+}
+
+void
+counter_group::close()
+{
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    for(auto* itr : m_pages)
+        munmap(itr, sizes.page);
+    m_pages.clear();
+
+    // close the group members before the group leader
+    while(!m_events.empty())
+        m_events.pop_back();
+}
+
+bool
+counter_group::read(uint64_t* _values) const
+{
+    if(m_events.empty()) return false;
+    if(!m_pages.empty() && read_rdpmc(_values)) return true;
+
+    // PERF_FORMAT_GROUP: { nr, values[nr] }
+    uint64_t   _buffer[max_events + 1];
+    const auto _nr    = m_events.size();
+    const auto _bytes = static_cast<ssize_t>((_nr + 1) * sizeof(uint64_t));
+    if(::read(m_events.front().get_fileno(), _buffer, _bytes) != _bytes ||
+       _buffer[0] != _nr)
+        return false;
+
+    for(size_t i = 0; i < _nr; ++i)
+        _values[i] = _buffer[i + 1];
+    return true;
+}
+
+bool
+counter_group::read_rdpmc(uint64_t* _values) const
+{
+#if defined(__x86_64__) || defined(__i386__)
+    for(size_t i = 0; i < m_pages.size(); ++i)
+    {
+        const auto* _page  = m_pages[i];
+        uint32_t    _seq   = 0;
+        uint64_t    _count = 0;
+        // the kernel updates the page when the event is scheduled in or out. An index of
+        // zero means the event is not currently on a hardware counter
+        do
+        {
+            _seq = _page->lock;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            uint32_t _idx = _page->index;
+            if(_page->cap_user_rdpmc == 0 || _idx == 0) return false;
+
+            // sign-extend the pmc_width bits of the counter
+            uint32_t _shift = 64 - _page->pmc_width;
+            auto     _pmc   = static_cast<int64_t>(rdpmc(_idx - 1) << _shift) >> _shift;
+            _count          = _page->offset + _pmc;
+
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while(_page->lock != _seq);
+        _values[i] = _count;
+    }
+    return true;
+#else
+    (void) _values;
+    return false;
+#endif
+}
+
 void
 perf_event::iterator::next()
 {
@@ -328,7 +517,7 @@ perf_event::iterator::next()
     struct perf_event_header _hdr;
 
     // Copy out the record header
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, &_hdr,
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.m_data_size, m_index, &_hdr,
                                       sizeof(struct perf_event_header));
 
     // Advance to the next record
@@ -378,14 +567,16 @@ perf_event::iterator::get()
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
 
     // Copy out the record header
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, _buf,
+    auto* _buf = m_source.m_record_buffer.data();
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.m_data_size, m_index, _buf,
                                       sizeof(struct perf_event_header));
 
     // Get a pointer to the header
     struct perf_event_header* header = reinterpret_cast<struct perf_event_header*>(_buf);
 
     // Copy out the entire record
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, _buf, header->size);
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.m_data_size, m_index, _buf,
+                                      header->size);
 
     return perf_event::record(&m_source, header);
 }
@@ -406,7 +597,7 @@ perf_event::iterator::has_data() const
     }
 
     struct perf_event_header _hdr;
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, &_hdr,
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.m_data_size, m_index, &_hdr,
                                       sizeof(struct perf_event_header));
 
     // If the first record is larger than the available data, nothing can be read
@@ -419,22 +610,23 @@ perf_event::iterator::has_data() const
 }
 
 void
-perf_event::copy_from_ring_buffer(struct perf_event_mmap_page* _mapping, ptrdiff_t _index,
-                                  void* _dest, size_t _nbytes)
+perf_event::copy_from_ring_buffer(struct perf_event_mmap_page* _mapping,
+                                  size_t _data_size, ptrdiff_t _index, void* _dest,
+                                  size_t _nbytes)
 {
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
 
     uintptr_t _base    = reinterpret_cast<uintptr_t>(_mapping) + sizes.page;
-    size_t    _beg_idx = _index % sizes.data;
+    size_t    _beg_idx = _index % _data_size;
     size_t    _end_idx = _beg_idx + _nbytes;
 
-    if(_end_idx <= sizes.data)
+    if(_end_idx <= _data_size)
     {
         memcpy(_dest, reinterpret_cast<void*>(_base + _beg_idx), _nbytes);
     }
     else
     {
-        size_t _chunk_size2 = _end_idx - sizes.data;
+        size_t _chunk_size2 = _end_idx - _data_size;
         size_t _chunk_size1 = _nbytes - _chunk_size2;
 
         void* _dest2 =
@@ -519,6 +711,49 @@ perf_event::record::get_callchain() const
     return container::wrap_c_array(_base, _size);
 }
 
+uint64_t
+perf_event::record::get_user_regs_abi() const
+{
+    ROCPROFSYS_ASSERT(is_sample() && m_source != nullptr &&
+                      m_source->is_sampling(sample::regs))
+        << "Record does not have a user regs field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::regs, uint64_t*>();
+}
+
+container::c_array<uint64_t>
+perf_event::record::get_user_regs() const
+{
+    // the registers are only present if the abi is not PERF_SAMPLE_REGS_ABI_NONE and
+    // they are ordered by the bit index in perf_event_attr::sample_regs_user
+    uint64_t* _base = locate_field<sample::regs, uint64_t*>();
+    uint64_t  _abi  = *_base;
+    size_t    _size = (_abi == PERF_SAMPLE_REGS_ABI_NONE)
+                          ? 0
+                          : __builtin_popcountll(m_source->get_sample_regs_user());
+    return container::wrap_c_array(++_base, _size);
+}
+
+container::c_array<uint8_t>
+perf_event::record::get_user_stack() const
+{
+    ROCPROFSYS_ASSERT(is_sample() && m_source != nullptr &&
+                      m_source->is_sampling(sample::stack))
+        << "Record does not have a user stack field (" << is_sample() << "|" << m_source
+        << ")";
+
+    // layout: u64 size, char data[size], u64 dyn_size (only if size != 0). The dyn_size
+    // is the number of bytes of data which were actually copied
+    auto*    _base = locate_field<sample::stack, uint8_t*>();
+    uint64_t _size = *reinterpret_cast<uint64_t*>(_base);
+    _base += sizeof(uint64_t);
+    if(_size == 0) return container::wrap_c_array(_base, 0);
+
+    uint64_t _dyn_size = 0;
+    memcpy(&_dyn_size, _base + _size, sizeof(uint64_t));
+    return container::wrap_c_array(_base, std::min<uint64_t>(_size, _dyn_size));
+}
+
 template <sample SampleT, typename Tp>
 Tp
 perf_event::record::locate_field() const
@@ -622,12 +857,21 @@ perf_event::record::locate_field() const
     // regs
     if constexpr(SampleT == sample::regs) return reinterpret_cast<Tp>(p);
     if(m_source != nullptr && m_source->is_sampling(sample::regs))
-        ROCPROFSYS_FATAL << "Register sampling is not supported";
+    {
+        uint64_t abi = *reinterpret_cast<uint64_t*>(p);
+        p += sizeof(uint64_t);
+        uint64_t nregs = __builtin_popcountll(m_source->get_sample_regs_user());
+        if(abi != PERF_SAMPLE_REGS_ABI_NONE) p += nregs * sizeof(uint64_t);
+    }
 
     // stack
     if constexpr(SampleT == sample::stack) return reinterpret_cast<Tp>(p);
     if(m_source != nullptr && m_source->is_sampling(sample::stack))
-        ROCPROFSYS_FATAL << "Stack sampling is not supported";
+    {
+        uint64_t stack_size = *reinterpret_cast<uint64_t*>(p);
+        p += sizeof(uint64_t) + stack_size;
+        if(stack_size != 0) p += sizeof(uint64_t);
+    }
 
     // end
     if constexpr(SampleT == sample::last) return reinterpret_cast<Tp>(p);
@@ -662,5 +906,150 @@ get_instance(int64_t _tid)
     }
     return _data->at(_tid);
 }
+
+collector::~collector()
+{
+    if(m_epoll != -1) ::close(m_epoll);
+    if(m_wakeup != -1) ::close(m_wakeup);
+}
+
+bool
+collector::start(callback_t _callback)
+{
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    if(m_running.load()) return true;
+
+    if(m_epoll == -1) m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if(m_wakeup == -1) m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if(m_epoll == -1 || m_wakeup == -1)
+    {
+        ROCPROFSYS_VERBOSE(0,
+                           "[perf] failed to create the collector epoll instance: %s\n",
+                           strerror(errno));
+        return false;
+    }
+
+    // the eventfd is used to interrupt epoll_wait when the collector is stopped
+    struct epoll_event _ev = {};
+    _ev.events             = EPOLLIN;
+    _ev.data.u64           = std::numeric_limits<uint64_t>::max();
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &_ev);
+
+    m_pid      = process::get_id();
+    m_callback = _callback;
+    m_running.store(true);
+
+    ROCPROFSYS_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+
+    m_thread = std::make_unique<std::thread>([this]() {
+        threading::set_thread_name("omni.samp.perf");
+        constexpr int max_events = 64;
+        auto          _events    = std::array<struct epoll_event, max_events>{};
+        while(m_running.load(std::memory_order_acquire))
+        {
+            auto _n = epoll_wait(m_epoll, _events.data(), max_events, 100);
+            if(_n < 0 && errno != EINTR) break;
+
+            m_wakeups.fetch_add(1, std::memory_order_relaxed);
+            for(int i = 0; i < _n; ++i)
+            {
+                auto _idx = _events.at(i).data.u64;
+                if(_idx == std::numeric_limits<uint64_t>::max()) continue;
+
+                auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+                drain(_idx);
+
+                // the sampled thread exited: the ring buffer will never be written again
+                if((_events.at(i).events & (EPOLLHUP | EPOLLERR)) != 0 &&
+                   _idx < m_entries.size() && m_entries.at(_idx).active)
+                {
+                    auto _fd = m_entries.at(_idx).event->get_fileno();
+                    epoll_ctl(m_epoll, EPOLL_CTL_DEL, _fd, nullptr);
+                    m_entries.at(_idx).active = false;
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
+void
+collector::stop()
+{
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    if(m_running.exchange(false) && m_thread)
+    {
+        uint64_t _v   = 1;
+        auto     _ret = ::write(m_wakeup, &_v, sizeof(_v));
+        (void) _ret;
+
+        // the collector thread does not exist in a forked child process
+        if(m_pid == process::get_id())
+            m_thread->join();
+        else
+            m_thread.release();  // NOLINT
+        m_thread.reset();
+    }
+
+    // samples written since the last wakeup (wakeup_events not yet reached)
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    for(size_t i = 0; i < m_entries.size(); ++i)
+        drain(i);
+}
+
+bool
+collector::add(int64_t _tid, perf_event* _event)
+{
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    if(!_event || !_event->is_open() || m_epoll == -1) return false;
+
+    auto _lk  = std::unique_lock<std::mutex>{ m_mutex };
+    auto _idx = m_entries.size();
+
+    struct epoll_event _ev = {};
+    _ev.events             = EPOLLIN;
+    _ev.data.u64           = _idx;
+    if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, _event->get_fileno(), &_ev) != 0)
+    {
+        ROCPROFSYS_VERBOSE(0, "[perf] failed to add perf event of thread %li to the "
+                              "collector: %s\n",
+                           _tid, strerror(errno));
+        return false;
+    }
+
+    m_entries.emplace_back(entry{ _tid, _event, true });
+    return true;
+}
+
+void
+collector::drain(size_t _idx)
+{
+    if(_idx >= m_entries.size() || !m_callback) return;
+
+    auto& _entry = m_entries.at(_idx);
+    if(!_entry.event || !_entry.event->is_open()) return;
+
+    for(auto itr : *_entry.event)
+    {
+        if(itr.is_sample())
+        {
+            m_callback(_entry.tid, itr);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+collector&
+get_collector()
+{
+    static auto* _v = new collector{};
+    return *_v;
+}
 }  // namespace perf
 }  // namespace rocprofsys
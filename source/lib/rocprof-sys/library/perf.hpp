@@ -29,14 +29,19 @@
 
 #include <timemory/backends/papi.hpp>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <linux/perf_event.h>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <string>
 #include <sys/types.h>
+#include <thread>
+#include <vector>
 
 namespace rocprofsys
 {
@@ -64,9 +69,10 @@ struct perf_event
     perf_event(const perf_event&) = delete;
     perf_event& operator=(const perf_event&) = delete;
 
-    /// Open a perf_event file using the given options structure
+    /// Open a perf_event file using the given options structure. When a group leader is
+    /// given, the event is enabled and disabled with the leader
     std::optional<std::string> open(struct perf_event_attr& pe, pid_t pid = 0,
-                                    int cpu = -1);
+                                    int cpu = -1, int group_fd = -1);
     std::optional<std::string> open(double, uint32_t = 0, pid_t pid = 0, int cpu = -1);
 
     /// Return file descriptor
@@ -103,6 +109,9 @@ struct perf_event
     /// Get the configuration for this perf_event's read format
     inline uint64_t get_read_format() const { return m_read_format; }
 
+    /// Get the mask of the user registers recorded with each sample
+    inline uint64_t get_sample_regs_user() const { return m_sample_regs_user; }
+
     /// A generic record type
     struct record
     {
@@ -141,6 +150,16 @@ struct perf_event
         uint64_t                     get_period() const;
         uint32_t                     get_cpu() const;
         container::c_array<uint64_t> get_callchain() const;
+        uint64_t                     get_user_regs_abi() const;
+        container::c_array<uint64_t> get_user_regs() const;
+        container::c_array<uint8_t>  get_user_stack() const;
+
+        /// Check if the record has the user registers and a copy of the user stack
+        inline bool has_user_stack() const
+        {
+            return is_sample() && m_source != nullptr &&
+                   m_source->is_sampling(sample::stack);
+        }
 
     private:
         record(const perf_event* source, struct perf_event_header* header)
@@ -174,10 +193,6 @@ struct perf_event
         size_t                       m_index   = 0;
         size_t                       m_head    = 0;
         struct perf_event_mmap_page* m_mapping = nullptr;
-
-        // Buffer to hold the current record. Just a hack until records play nice with the
-        // ring buffer
-        uint8_t _buf[4096];
     };
 
     /// Get an iterator to the beginning of the memory mapped ring buffer
@@ -189,7 +204,8 @@ struct perf_event
 private:
     // Copy data out of the mmap ring buffer
     static void copy_from_ring_buffer(struct perf_event_mmap_page* mapping,
-                                      ptrdiff_t index, void* dest, size_t bytes);
+                                      size_t data_size, ptrdiff_t index, void* dest,
+                                      size_t bytes);
 
     uint32_t m_batch_size = 10;
 
@@ -203,10 +219,119 @@ private:
     uint64_t m_sample_type = 0;
     /// The read format from this perf event's configuration
     uint64_t m_read_format = 0;
+    /// The user registers recorded with each sample
+    uint64_t m_sample_regs_user = 0;
+    /// Size of the data area of the ring buffer (power of 2 number of pages)
+    size_t m_data_size = 0;
+    /// Buffer which holds the current record while iterating over the ring buffer
+    std::vector<uint8_t> m_record_buffer = {};
+};
+
+/// A group of counting perf events which are enabled, disabled, and read together. The
+/// counts of every event are read with a single read() of the group leader
+/// (PERF_FORMAT_GROUP) or, when every event is a hardware event and the PMU allows it,
+/// with rdpmc via the mmap'ed page of each event
+class counter_group
+{
+public:
+    static constexpr size_t max_events = 16;
+
+    counter_group() = default;
+    ~counter_group();
+
+    counter_group(const counter_group&)     = delete;
+    counter_group(counter_group&&) noexcept = delete;
+
+    counter_group& operator=(const counter_group&) = delete;
+    counter_group& operator=(counter_group&&) noexcept = delete;
+
+    /// Open the events in the given order, the first event is the group leader
+    std::optional<std::string> open(std::vector<struct perf_event_attr> attrs,
+                                    pid_t pid = 0, int cpu = -1);
+
+    /// Start counting events
+    bool start() const;
+
+    /// Stop counting events
+    bool stop() const;
+
+    /// Close the perf_event files and unmap the user pages
+    void close();
+
+    /// Read the counts, in the order the events were opened, into an array of size()
+    /// values. Only performs async-signal-safe operations
+    bool read(uint64_t* values) const;
+
+    bool   is_open() const { return !m_events.empty(); }
+    size_t size() const { return m_events.size(); }
+    bool   uses_rdpmc() const { return !m_pages.empty(); }
+
+private:
+    bool read_rdpmc(uint64_t* values) const;
+
+    std::vector<perf_event>                   m_events = {};
+    std::vector<struct perf_event_mmap_page*> m_pages  = {};
 };
 
 /// provides thread-local instance of perf_event
 std::unique_ptr<perf_event>&
 get_instance(int64_t _tid);
+
+/// Drains the ring buffers of the registered perf_event instances from a single
+/// background thread which waits on their file descriptors via epoll. The sampled
+/// threads never receive a signal so the samples must provide the callchain
+class collector
+{
+public:
+    using callback_t = void (*)(int64_t, const perf_event::record&);
+
+    collector() = default;
+    ~collector();
+
+    collector(const collector&) = delete;
+    collector(collector&&)      = delete;
+    collector& operator=(const collector&) = delete;
+    collector& operator=(collector&&) = delete;
+
+    /// Start the collector thread. The callback is invoked on the collector thread
+    /// for every sample record with the index of the thread which was sampled
+    bool start(callback_t);
+
+    /// Drain all of the ring buffers one last time and join the collector thread
+    void stop();
+
+    /// Register a perf_event. The perf_event must remain open until stop is called
+    bool add(int64_t _tid, perf_event* _event);
+
+    /// Number of times the collector thread was woken up to drain ring buffers
+    uint64_t get_wakeups() const { return m_wakeups.load(std::memory_order_relaxed); }
+
+    /// Number of sample records passed to the callback
+    uint64_t get_count() const { return m_count.load(std::memory_order_relaxed); }
+
+private:
+    void drain(size_t);
+
+    struct entry
+    {
+        int64_t     tid    = -1;
+        perf_event* event  = nullptr;
+        bool        active = false;
+    };
+
+    pid_t                        m_pid      = 0;
+    int                          m_epoll    = -1;
+    int                          m_wakeup   = -1;
+    callback_t                   m_callback = nullptr;
+    std::atomic<bool>            m_running  = { false };
+    std::atomic<uint64_t>        m_wakeups  = { 0 };
+    std::atomic<uint64_t>        m_count    = { 0 };
+    std::unique_ptr<std::thread> m_thread   = {};
+    std::mutex                   m_mutex    = {};
+    std::vector<entry>           m_entries  = {};
+};
+
+collector&
+get_collector();
 }  // namespace perf
 }  // namespace rocprofsys
@@ -0,0 +1,597 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/perf_unwind.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/dynamic_library.hpp"
+#include "library/ptl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+#include <libunwind.h>
+#include <link.h>
+
+#if defined(__x86_64__)
+#    include <asm/perf_regs.h>
+#endif
+
+namespace rocprofsys
+{
+namespace perf
+{
+namespace
+{
+// registers are stored unpacked, i.e. indexed by the bit in sample_regs_user
+constexpr size_t max_regs = 32;
+
+struct snapshot_header
+{
+    int64_t  tid        = -1;
+    uint64_t time       = 0;
+    uint64_t ncallchain = 0;
+    uint64_t nstack     = 0;
+};
+
+struct snapshot
+{
+    snapshot_header                header    = {};
+    std::array<uint64_t, max_regs> regs      = {};
+    std::vector<uintptr_t>         callchain = {};
+    std::vector<uint8_t>           stack     = {};
+};
+
+bool
+read_snapshot(std::istream& _is, snapshot& _v)
+{
+    _is.read(reinterpret_cast<char*>(&_v.header), sizeof(_v.header));
+    _is.read(reinterpret_cast<char*>(_v.regs.data()), sizeof(_v.regs));
+    if(!_is) return false;
+
+    _v.callchain.resize(_v.header.ncallchain);
+    _v.stack.resize(_v.header.nstack);
+    _is.read(reinterpret_cast<char*>(_v.callchain.data()),
+             _v.callchain.size() * sizeof(uintptr_t));
+    _is.read(reinterpret_cast<char*>(_v.stack.data()), _v.stack.size());
+    return static_cast<bool>(_is);
+}
+
+// an executable segment and the .eh_frame_hdr of a loaded binary. A binary with several
+// executable segments has an entry for each of them. The binaries are still mapped in
+// this process when the samples are unwound so the unwind tables are read in place
+// instead of from the files
+struct module
+{
+    uintptr_t start        = 0;
+    uintptr_t end          = 0;
+    uintptr_t eh_frame_hdr = 0;
+};
+
+struct module_table
+{
+    module_table();
+
+    const module* find(uintptr_t) const;
+    bool          is_readable(uintptr_t, size_t) const;
+
+    std::vector<module>                          modules  = {};
+    std::vector<std::pair<uintptr_t, uintptr_t>> readable = {};
+};
+
+module_table::module_table()
+{
+    dl_iterate_phdr(
+        [](struct dl_phdr_info* _info, size_t, void* _data) {
+            auto* _table        = static_cast<module_table*>(_data);
+            auto  _segments     = std::vector<std::pair<uintptr_t, uintptr_t>>{};
+            auto  _eh_frame_hdr = uintptr_t{ 0 };
+            for(int i = 0; i < _info->dlpi_phnum; ++i)
+            {
+                const auto& _phdr = _info->dlpi_phdr[i];
+                auto        _addr = _info->dlpi_addr + _phdr.p_vaddr;
+                if(_phdr.p_type == PT_LOAD && (_phdr.p_flags & PF_R) != 0)
+                    _table->readable.emplace_back(_addr, _addr + _phdr.p_memsz);
+                if(_phdr.p_type == PT_LOAD && (_phdr.p_flags & PF_X) != 0)
+                    _segments.emplace_back(_addr, _addr + _phdr.p_memsz);
+                else if(_phdr.p_type == PT_GNU_EH_FRAME)
+                    _eh_frame_hdr = _addr;
+            }
+            if(_eh_frame_hdr == 0) return 0;
+            for(const auto& itr : _segments)
+            {
+                if(itr.first < itr.second)
+                    _table->modules.emplace_back(
+                        module{ itr.first, itr.second, _eh_frame_hdr });
+            }
+            return 0;
+        },
+        this);
+
+    std::sort(modules.begin(), modules.end(),
+              [](const module& _lhs, const module& _rhs) {
+                  return _lhs.start < _rhs.start;
+              });
+    std::sort(readable.begin(), readable.end());
+}
+
+const module*
+module_table::find(uintptr_t _addr) const
+{
+    auto itr = std::upper_bound(
+        modules.begin(), modules.end(), _addr,
+        [](uintptr_t _lhs, const module& _rhs) { return _lhs < _rhs.start; });
+    if(itr == modules.begin()) return nullptr;
+    --itr;
+    return (_addr < itr->end) ? &(*itr) : nullptr;
+}
+
+bool
+module_table::is_readable(uintptr_t _addr, size_t _size) const
+{
+    auto itr = std::upper_bound(
+        readable.begin(), readable.end(),
+        std::make_pair(_addr, std::numeric_limits<uintptr_t>::max()));
+    if(itr == readable.begin()) return false;
+    --itr;
+    return (_addr >= itr->first && _addr + _size <= itr->second);
+}
+
+#if defined(__x86_64__)
+// the remote (generic) libunwind API is provided by libunwind-<arch> whereas the library
+// linked by timemory only provides the local API
+struct libunwind_remote
+{
+    using create_addr_space_t  = unw_addr_space_t (*)(unw_accessors_t*, int);
+    using set_caching_policy_t = int (*)(unw_addr_space_t, unw_caching_policy_t);
+    using init_remote_t        = int (*)(unw_cursor_t*, unw_addr_space_t, void*);
+    using step_t               = int (*)(unw_cursor_t*);
+    using get_reg_t            = int (*)(unw_cursor_t*, unw_regnum_t, unw_word_t*);
+    using search_unwind_table_t =
+        int (*)(unw_addr_space_t, unw_word_t, unw_dyn_info_t*, unw_proc_info_t*, int,
+                void*);
+
+    libunwind_remote();
+
+    explicit operator bool() const
+    {
+        return create_addr_space && set_caching_policy && init_remote && step &&
+               get_reg && search_unwind_table;
+    }
+
+    create_addr_space_t   create_addr_space   = nullptr;
+    set_caching_policy_t  set_caching_policy  = nullptr;
+    init_remote_t         init_remote         = nullptr;
+    step_t                step                = nullptr;
+    get_reg_t             get_reg             = nullptr;
+    search_unwind_table_t search_unwind_table = nullptr;
+};
+
+libunwind_remote::libunwind_remote()
+{
+    for(const auto* itr : { "libunwind-x86_64.so", "libunwind-x86_64.so.99",
+                            "libunwind-x86_64.so.8" })
+    {
+        auto _lib = dynamic_library{ "ROCPROFSYS_LIBUNWIND_REMOTE_LIBRARY", itr,
+                                     (RTLD_NOW | RTLD_LOCAL) };
+        if(!_lib.is_open()) continue;
+
+        auto _load = [&_lib](auto& _func, const char* _name) {
+            *reinterpret_cast<void**>(&_func) = dlsym(_lib.handle, _name);
+        };
+
+        _load(create_addr_space, "_Ux86_64_create_addr_space");
+        _load(set_caching_policy, "_Ux86_64_set_caching_policy");
+        _load(init_remote, "_Ux86_64_init_remote");
+        _load(step, "_Ux86_64_step");
+        _load(get_reg, "_Ux86_64_get_reg");
+        _load(search_unwind_table, "_Ux86_64_dwarf_search_unwind_table");
+
+        if(*this)
+        {
+            // keep the library loaded for the rest of the process
+            _lib.handle = nullptr;
+            ROCPROFSYS_VERBOSE(2, "[perf] using the remote libunwind API from %s\n",
+                               _lib.filename.c_str());
+            return;
+        }
+    }
+}
+
+const libunwind_remote&
+get_libunwind_remote()
+{
+    static auto _v = libunwind_remote{};
+    return _v;
+}
+
+struct unwind_context
+{
+    const snapshot*     data    = nullptr;
+    const module_table* modules = nullptr;
+};
+
+// the DW_EH_PE format (lower bits) is udata4 or sdata4 and the value is not indirect
+constexpr bool
+is_eh_frame_ptr_4byte(uint8_t _enc)
+{
+    return (_enc & 0x80) == 0 && ((_enc & 0x0f) == 0x03 || (_enc & 0x0f) == 0x0b);
+}
+
+int
+find_proc_info(unw_addr_space_t _as, unw_word_t _ip, unw_proc_info_t* _pi,
+               int _need_unwind_info, void* _arg)
+{
+    const auto* _ctx = static_cast<unwind_context*>(_arg);
+    const auto* _mod = _ctx->modules->find(_ip);
+    if(!_mod) return -UNW_ENOINFO;
+
+    // only the standard encoding emitted by the linkers is supported: version 1, a
+    // 4-byte eh_frame_ptr (e.g. pcrel sdata4), u32 fde_count and a sorted table of
+    // (datarel sdata4, datarel sdata4) pairs. The fde_count and the table follow the
+    // eh_frame_ptr so they are at the wrong offsets for any other size
+    const auto* _hdr = reinterpret_cast<const uint8_t*>(_mod->eh_frame_hdr);
+    if(!_ctx->modules->is_readable(_mod->eh_frame_hdr, 12) || _hdr[0] != 1 ||
+       !is_eh_frame_ptr_4byte(_hdr[1]) || _hdr[2] != 0x03 || _hdr[3] != 0x3b)
+        return -UNW_ENOINFO;
+
+    uint32_t _fde_count = 0;
+    memcpy(&_fde_count, _hdr + 8, sizeof(_fde_count));
+
+    auto _di             = unw_dyn_info_t{};
+    _di.format           = UNW_INFO_FORMAT_REMOTE_TABLE;
+    _di.start_ip         = _mod->start;
+    _di.end_ip           = _mod->end;
+    _di.u.rti.segbase    = _mod->eh_frame_hdr;
+    _di.u.rti.table_data = _mod->eh_frame_hdr + 12;
+    _di.u.rti.table_len  = (_fde_count * 2 * sizeof(int32_t)) / sizeof(unw_word_t);
+
+    return get_libunwind_remote().search_unwind_table(_as, _ip, &_di, _pi,
+                                                      _need_unwind_info, _arg);
+}
+
+void
+put_unwind_info(unw_addr_space_t, unw_proc_info_t*, void*)
+{}
+
+int
+get_dyn_info_list_addr(unw_addr_space_t, unw_word_t*, void*)
+{
+    return -UNW_ENOINFO;
+}
+
+int
+access_mem(unw_addr_space_t, unw_word_t _addr, unw_word_t* _val, int _write, void* _arg)
+{
+    if(_write) return -UNW_EREADONLYREG;
+
+    const auto* _ctx   = static_cast<unwind_context*>(_arg);
+    const auto& _stack = _ctx->data->stack;
+    const auto  _sp    = _ctx->data->regs.at(PERF_REG_X86_SP);
+
+    // the copy of the stack starts at the stack pointer of the sample
+    if(_addr >= _sp && _addr + sizeof(unw_word_t) <= _sp + _stack.size())
+    {
+        memcpy(_val, _stack.data() + (_addr - _sp), sizeof(unw_word_t));
+        return 0;
+    }
+
+    // unwind tables and code of the loaded binaries
+    if(_ctx->modules->is_readable(_addr, sizeof(unw_word_t)))
+    {
+        memcpy(_val, reinterpret_cast<const void*>(_addr), sizeof(unw_word_t));
+        return 0;
+    }
+
+    return -UNW_EINVAL;
+}
+
+int
+access_reg(unw_addr_space_t, unw_regnum_t _reg, unw_word_t* _val, int _write, void* _arg)
+{
+    if(_write) return -UNW_EREADONLYREG;
+
+    const auto* _ctx = static_cast<unwind_context*>(_arg);
+    int         _idx = -1;
+    switch(_reg)
+    {
+        case UNW_X86_64_RAX: _idx = PERF_REG_X86_AX; break;
+        case UNW_X86_64_RDX: _idx = PERF_REG_X86_DX; break;
+        case UNW_X86_64_RCX: _idx = PERF_REG_X86_CX; break;
+        case UNW_X86_64_RBX: _idx = PERF_REG_X86_BX; break;
+        case UNW_X86_64_RSI: _idx = PERF_REG_X86_SI; break;
+        case UNW_X86_64_RDI: _idx = PERF_REG_X86_DI; break;
+        case UNW_X86_64_RBP: _idx = PERF_REG_X86_BP; break;
+        case UNW_X86_64_RSP: _idx = PERF_REG_X86_SP; break;
+        case UNW_X86_64_R8: _idx = PERF_REG_X86_R8; break;
+        case UNW_X86_64_R9: _idx = PERF_REG_X86_R9; break;
+        case UNW_X86_64_R10: _idx = PERF_REG_X86_R10; break;
+        case UNW_X86_64_R11: _idx = PERF_REG_X86_R11; break;
+        case UNW_X86_64_R12: _idx = PERF_REG_X86_R12; break;
+        case UNW_X86_64_R13: _idx = PERF_REG_X86_R13; break;
+        case UNW_X86_64_R14: _idx = PERF_REG_X86_R14; break;
+        case UNW_X86_64_R15: _idx = PERF_REG_X86_R15; break;
+        case UNW_X86_64_RIP: _idx = PERF_REG_X86_IP; break;
+        default: return -UNW_EBADREG;
+    }
+
+    *_val = _ctx->data->regs.at(_idx);
+    return 0;
+}
+
+int
+access_fpreg(unw_addr_space_t, unw_regnum_t, unw_fpreg_t*, int, void*)
+{
+    return -UNW_EBADREG;
+}
+
+int
+resume(unw_addr_space_t, unw_cursor_t*, void*)
+{
+    return -UNW_EINVAL;
+}
+
+int
+get_proc_name(unw_addr_space_t, unw_word_t, char*, size_t, unw_word_t*, void*)
+{
+    return -UNW_EINVAL;
+}
+
+std::vector<uintptr_t>
+unwind_snapshot(const module_table& _modules, const snapshot& _data, size_t _max_depth)
+{
+    const auto& _libunwind = get_libunwind_remote();
+
+    // one address space (and cache of unwind info) per thread of the pool
+    static thread_local unw_addr_space_t _as = [&_libunwind]() {
+        static auto _accessors            = unw_accessors_t{};
+        _accessors.find_proc_info         = &find_proc_info;
+        _accessors.put_unwind_info        = &put_unwind_info;
+        _accessors.get_dyn_info_list_addr = &get_dyn_info_list_addr;
+        _accessors.access_mem             = &access_mem;
+        _accessors.access_reg             = &access_reg;
+        _accessors.access_fpreg           = &access_fpreg;
+        _accessors.resume                 = &resume;
+        _accessors.get_proc_name          = &get_proc_name;
+
+        auto _v = _libunwind.create_addr_space(&_accessors, 0);
+        if(_v) _libunwind.set_caching_policy(_v, UNW_CACHE_GLOBAL);
+        return _v;
+    }();
+
+    auto _pcs = std::vector<uintptr_t>{};
+    if(!_as || _data.stack.empty()) return _pcs;
+
+    auto         _ctx    = unwind_context{ &_data, &_modules };
+    unw_cursor_t _cursor = {};
+    if(_libunwind.init_remote(&_cursor, _as, &_ctx) != 0) return _pcs;
+
+    _pcs.reserve(_max_depth);
+    do
+    {
+        unw_word_t _ip = 0;
+        if(_libunwind.get_reg(&_cursor, UNW_REG_IP, &_ip) != 0 || _ip == 0) break;
+        _pcs.emplace_back(_ip);
+    } while(_pcs.size() < _max_depth && _libunwind.step(&_cursor) > 0);
+
+    return _pcs;
+}
+#else
+struct libunwind_remote
+{
+    explicit operator bool() const { return false; }
+};
+
+const libunwind_remote&
+get_libunwind_remote()
+{
+    static auto _v = libunwind_remote{};
+    return _v;
+}
+
+std::vector<uintptr_t>
+unwind_snapshot(const module_table&, const snapshot&, size_t)
+{
+    return std::vector<uintptr_t>{};
+}
+#endif
+}  // namespace
+
+uint64_t
+get_unwind_regs_mask()
+{
+#if defined(__x86_64__)
+    uint64_t _mask = 0;
+    for(auto itr : { PERF_REG_X86_AX, PERF_REG_X86_BX, PERF_REG_X86_CX, PERF_REG_X86_DX,
+                     PERF_REG_X86_SI, PERF_REG_X86_DI, PERF_REG_X86_BP, PERF_REG_X86_SP,
+                     PERF_REG_X86_IP, PERF_REG_X86_R8, PERF_REG_X86_R9, PERF_REG_X86_R10,
+                     PERF_REG_X86_R11, PERF_REG_X86_R12, PERF_REG_X86_R13,
+                     PERF_REG_X86_R14, PERF_REG_X86_R15 })
+        _mask |= (1ULL << itr);
+    return _mask;
+#else
+    return 0;
+#endif
+}
+
+std::iostream*
+stack_snapshots::get_stream()
+{
+    if(!m_file && config::get_use_tmp_files())
+    {
+        m_file = config::get_tmp_file("sampling-stacks");
+        if(m_file && !m_file->open(std::ios::binary | std::ios::in | std::ios::out |
+                                   std::ios::trunc))
+            m_file.reset();
+    }
+
+    if(m_file) return &m_file->stream;
+    return &m_buffer;
+}
+
+void
+stack_snapshots::add(int64_t _tid, uint64_t _time, const perf_event::record& _record,
+                     const uintptr_t* _callchain, size_t _ncallchain)
+{
+    auto* _os = get_stream();
+
+    auto _regs = std::array<uint64_t, max_regs>{};
+    auto _mask = _record.get_user_regs_abi() != PERF_SAMPLE_REGS_ABI_NONE
+                     ? get_unwind_regs_mask()
+                     : 0;
+    auto _vals = _record.get_user_regs();
+    for(size_t i = 0, n = 0; i < max_regs && n < _vals.size(); ++i)
+    {
+        if((_mask & (1ULL << i)) != 0) _regs.at(i) = _vals[n++];
+    }
+
+    auto _stack  = _record.get_user_stack();
+    auto _header = snapshot_header{ _tid, _time, _ncallchain, _stack.size() };
+
+    _os->write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _os->write(reinterpret_cast<const char*>(_regs.data()), sizeof(_regs));
+    _os->write(reinterpret_cast<const char*>(_callchain),
+               _ncallchain * sizeof(uintptr_t));
+    if(_stack.size() > 0)
+        _os->write(reinterpret_cast<const char*>(&_stack[0]), _stack.size());
+    ++m_count;
+}
+
+size_t
+stack_snapshots::unwind(size_t _max_depth, const callback_t& _callback)
+{
+    if(m_count == 0) return 0;
+
+    const auto _beg       = std::chrono::steady_clock::now();
+    const bool _available = static_cast<bool>(get_libunwind_remote());
+
+    if(!_available)
+    {
+        ROCPROFSYS_WARNING(0, "[perf] the remote libunwind API (libunwind-<arch>) is not "
+                              "available. The kernel callchains will be used for the "
+                              "%zu overflow samples\n",
+                           m_count);
+    }
+
+    auto* _is = get_stream();
+    _is->flush();
+    _is->clear();
+    _is->seekg(0, std::ios::beg);
+
+    // the snapshots are processed in batches to bound the memory usage
+    constexpr size_t batch_size = 1024;
+    constexpr size_t task_size  = 32;
+
+    auto   _modules  = module_table{};
+    auto   _batch    = std::vector<snapshot>{};
+    auto   _results  = std::vector<std::vector<uintptr_t>>{};
+    size_t _unwound  = 0;
+    size_t _nread    = 0;
+    bool   _complete = false;
+
+    while(!_complete && _nread < m_count)
+    {
+        _batch.clear();
+        while(_nread < m_count && _batch.size() < batch_size)
+        {
+            auto _v = snapshot{};
+            if(!read_snapshot(*_is, _v))
+            {
+                _complete = true;
+                break;
+            }
+            _batch.emplace_back(std::move(_v));
+            ++_nread;
+        }
+
+        _results.assign(_batch.size(), std::vector<uintptr_t>{});
+        if(_available)
+        {
+            auto& _tg = tasking::general::get_task_group();
+            for(size_t i = 0; i < _batch.size(); i += task_size)
+            {
+                _tg.exec([i, _max_depth, &_batch, &_results, &_modules]() {
+                    auto _n = std::min<size_t>(i + task_size, _batch.size());
+                    for(size_t j = i; j < _n; ++j)
+                        _results.at(j) =
+                            unwind_snapshot(_modules, _batch.at(j), _max_depth);
+                });
+            }
+            _tg.join();
+        }
+
+        for(size_t i = 0; i < _batch.size(); ++i)
+        {
+            const auto& _header = _batch.at(i).header;
+            // a single frame means the stack copy could not be unwound
+            if(_results.at(i).size() > 1)
+            {
+                ++_unwound;
+                _callback(_header.tid, _header.time, _results.at(i));
+            }
+            else
+            {
+                _callback(_header.tid, _header.time, _batch.at(i).callchain);
+            }
+        }
+    }
+
+    ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                       "[sampling] Unwound %zu of %zu user stack copies offline in %.3f "
+                       "sec (the kernel callchain was used for the rest)\n",
+                       _unwound, _nread,
+                       std::chrono::duration<double>{ std::chrono::steady_clock::now() -
+                                                      _beg }
+                           .count());
+
+    return _unwound;
+}
+
+void
+stack_snapshots::clear()
+{
+    if(m_file)
+    {
+        m_file->close();
+        m_file->remove();
+        m_file.reset();
+    }
+    m_buffer = std::stringstream{};
+    m_count  = 0;
+}
+
+stack_snapshots&
+get_stack_snapshots()
+{
+    static auto* _v = new stack_snapshots{};
+    return *_v;
+}
+}  // namespace perf
+}  // namespace rocprofsys
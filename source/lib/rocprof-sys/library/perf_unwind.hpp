@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/config.hpp"
+#include "core/defines.hpp"
+#include "library/perf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace perf
+{
+/// Mask of the user registers (perf_event_attr::sample_regs_user) which are needed to
+/// unwind a copy of the user stack (PERF_SAMPLE_STACK_USER). Zero if unwinding the
+/// stack copies is not supported on this architecture
+uint64_t
+get_unwind_regs_mask();
+
+/// Stores the raw register set and copy of the user stack of the overflow samples drained
+/// by the collector thread and unwinds them with the remote libunwind API (DWARF CFI)
+/// after sampling has stopped. Nothing is unwound at sample time
+class stack_snapshots
+{
+public:
+    using callback_t =
+        std::function<void(int64_t, uint64_t, const std::vector<uintptr_t>&)>;
+
+    /// Append a sample record. The kernel callchain is used for the sample if the stack
+    /// copy cannot be unwound
+    void add(int64_t _tid, uint64_t _time, const perf_event::record& _record,
+             const uintptr_t* _callchain, size_t _ncallchain);
+
+    /// Unwind all of the stored records in parallel and invoke the callback serially
+    /// with the thread index, timestamp, and call-stack (innermost first) of each one.
+    /// Returns the number of records which were unwound from the stack copy
+    size_t unwind(size_t _max_depth, const callback_t& _callback);
+
+    size_t size() const { return m_count; }
+    void   clear();
+
+private:
+    std::iostream* get_stream();
+
+    size_t                            m_count  = 0;
+    std::shared_ptr<config::tmp_file> m_file   = {};
+    std::stringstream                 m_buffer = {};
+};
+
+stack_snapshots&
+get_stack_snapshots();
+}  // namespace perf
+}  // namespace rocprofsys
@@ -23,6 +23,7 @@
 #include "library/process_sampler.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "library/components/comm_data.hpp"
 #include "library/cpu_freq.hpp"
 #include "library/rocm_smi.hpp"
 #include "library/runtime.hpp"
@@ -157,6 +158,17 @@ sampler::setup()
     _cpu_freq->config       = []() { cpu_freq::config(); };
     _cpu_freq->sample       = []() { cpu_freq::sample(); };
 
+    if(get_use_mpip() || get_use_rcclp())
+    {
+        auto& _comm_data     = instances.emplace_back(std::make_unique<instance>());
+        _comm_data->setup    = []() { component::comm_data::set_sampled(true); };
+        _comm_data->shutdown = []() {
+            component::comm_data::flush();
+            component::comm_data::set_sampled(false);
+        };
+        _comm_data->sample = []() { component::comm_data::sample(); };
+    }
+
     for(auto& itr : instances)
         itr->setup();
 
@@ -213,9 +213,10 @@ general::get_task_group(int64_t _tid)
 {
     struct local
     {};
-    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
-    static thread_local auto& _v =
-        thread_data_t::instance(construct_on_thread{ _tid }, &tasking::get_thread_pool());
+    using thread_data_t          = thread_data<PTL::TaskGroup<void>, local>;
+    static thread_local auto& _v = (general::get_thread_pool_state() = State::Active,
+                                    thread_data_t::instance(construct_on_thread{ _tid },
+                                                            &tasking::get_thread_pool()));
     return *_v;
 }
 
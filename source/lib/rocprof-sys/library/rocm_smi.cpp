@@ -38,6 +38,7 @@
 #include "core/gpu.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "core/timestamp.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
 
@@ -125,7 +126,7 @@ data::data(uint32_t _dev_id) { sample(_dev_id); }
 void
 data::sample(uint32_t _dev_id)
 {
-    auto _ts = tim::get_clock_real_now<size_t, std::nano>();
+    auto _ts = static_cast<size_t>(timestamp::now());
     assert(_ts < std::numeric_limits<int64_t>::max());
     rsmi_gpu_metrics_t _gpu_metrics;
 
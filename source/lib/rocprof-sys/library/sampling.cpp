@@ -34,8 +34,12 @@
 #include "library/components/backtrace_timestamp.hpp"
 #include "library/components/callchain.hpp"
 #include "library/perf.hpp"
+#include "library/perf_unwind.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
+#include "library/sampling_profile.hpp"
+#include "library/sampling_rate.hpp"
+#include "library/symbolizer.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
 #include "library/tracing.hpp"
@@ -70,12 +74,15 @@
 #include <timemory/variadic.hpp>
 
 #include <array>
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
 #include <csignal>
 #include <cstring>
 #include <ctime>
+#include <fstream>
 #include <initializer_list>
+#include <limits>
 #include <mutex>
 #include <regex>
 #include <sstream>
@@ -84,6 +91,8 @@
 
 #include <pthread.h>
 #include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace tim
 {
@@ -387,65 +396,242 @@ start_duration_thread()
     }
 }
 
-auto&
-get_offload_file()
+using sampler_bundle_t = typename sampler_t::bundle_type;
+using sampler_buffer_t = tim::data_storage::ring_buffer<sampler_bundle_t>;
+using pos_type         = typename std::fstream::pos_type;
+
+// buffers of samples handed off by the sampler allocators. The producers only push onto
+// a lock-free (Treiber) stack and signal an eventfd, and the writer thread takes the
+// entire stack at once so the sampled threads never wait on file I/O
+struct offload_entry
 {
-    static auto _v = []() {
-        auto _tmp_v = config::get_tmp_file("sampling");
-        if(get_use_tmp_files())
+    int64_t          seq    = 0;
+    sampler_buffer_t buffer = {};
+    offload_entry*   next   = nullptr;
+};
+
+// all buffers are appended to a single temporary file which is only written by the
+// writer thread. The positions of the buffers of each thread are recorded so that
+// post-processing can read the buffers of every thread independently
+struct offload_segment
+{
+    std::vector<pos_type> index   = {};
+    size_t                samples = 0;
+};
+
+struct offload_writer
+{
+    void start();
+    void stop();
+    void push(int64_t, sampler_buffer_t&&);
+    void drain();
+
+    const tmp_file*        get_file() const { return m_file.get(); }
+    const offload_segment* get_segment(int64_t) const;
+    void                   remove();
+
+private:
+    void notify();
+    bool write(offload_entry*);
+
+    pid_t                                        m_pid      = 0;
+    int                                          m_event    = -1;
+    std::atomic<bool>                            m_running  = { false };
+    std::atomic<offload_entry*>                  m_head     = { nullptr };
+    std::unique_ptr<std::thread>                 m_thread   = {};
+    locking::atomic_mutex                        m_mutex    = {};
+    std::shared_ptr<tmp_file>                    m_file     = {};
+    std::unordered_map<int64_t, offload_segment> m_segments = {};
+};
+
+offload_writer&
+get_offload_writer()
+{
+    static auto* _v = new offload_writer{};
+    return *_v;
+}
+
+void
+offload_writer::start()
+{
+    if(m_running.exchange(true)) return;
+
+    // the event is never closed because a buffer may be pushed while the writer stops.
+    // A forked child creates its own event
+    if(m_event < 0 || m_pid != process::get_id()) m_event = eventfd(0, EFD_CLOEXEC);
+    m_pid = process::get_id();
+
+    if(m_event < 0)
+    {
+        ROCPROFSYS_WARNING_F(0,
+                             "[sampling] eventfd for the offload writer failed: %s. "
+                             "Offloaded buffers are written by the sampler allocators\n",
+                             strerror(errno));
+        m_running.store(false);
+        return;
+    }
+
+    ROCPROFSYS_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    m_thread = std::make_unique<std::thread>([this]() {
+        threading::set_thread_name("omni.samp.offl");
+        while(m_running.load(std::memory_order_acquire))
         {
-            auto _success = _tmp_v->open();
-            ROCPROFSYS_CI_FAIL(!_success,
-                               "Error opening sampling offload temporary file '%s'\n",
-                               _tmp_v->filename.c_str());
+            // blocks until a buffer is pushed or the writer is stopped
+            uint64_t _n = 0;
+            if(::read(m_event, &_n, sizeof(_n)) < 0 && errno != EINTR) break;
+            drain();
         }
-        return _tmp_v;
-    }();
-    return _v;
+    });
 }
 
-locking::atomic_mutex&
-get_offload_mutex()
+void
+offload_writer::stop()
 {
-    static auto _v = locking::atomic_mutex{};
-    return _v;
-}
+    if(m_running.exchange(false) && m_thread)
+    {
+        // the writer thread does not exist in a forked child process
+        if(m_pid == process::get_id())
+        {
+            notify();
+            m_thread->join();
+        }
+        else
+        {
+            m_thread.release();  // NOLINT
+        }
+        m_thread.reset();
+    }
 
-using sampler_bundle_t = typename sampler_t::bundle_type;
-using sampler_buffer_t = tim::data_storage::ring_buffer<sampler_bundle_t>;
-using pos_type         = typename std::fstream::pos_type;
+    // anything pushed after the writer thread exited
+    drain();
+}
 
-auto offload_seq_data = std::unordered_map<int64_t, std::set<pos_type>>{};
+void
+offload_writer::notify()
+{
+    uint64_t _n   = 1;
+    auto     _ret = ::write(m_event, &_n, sizeof(_n));
+    (void) _ret;
+}
 
 void
-offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
+offload_writer::push(int64_t _seq, sampler_buffer_t&& _buf)
 {
-    ROCPROFSYS_REQUIRE(get_use_tmp_files())
-        << "Error! sampling allocator tries to offload buffer of samples but "
-           "rocprof-sys was configured to not use temporary files\n";
+    auto* _entry = new offload_entry{ _seq, std::move(_buf), nullptr };
+
+    _entry->next = m_head.load(std::memory_order_relaxed);
+    while(!m_head.compare_exchange_weak(_entry->next, _entry, std::memory_order_release,
+                                        std::memory_order_relaxed))
+    {}
+
+    // no writer thread: the caller is responsible for writing its own buffer
+    if(!m_running.load(std::memory_order_acquire) || m_pid != process::get_id())
+        drain();
+    else
+        notify();
+}
 
-    // use homemade atomic_mutex/atomic_lock since contention will be low
+void
+offload_writer::drain()
+{
+    // use homemade atomic_mutex/atomic_lock since this is only contended between the
+    // writer thread and the (rare) offloads which occur after the writer thread exits
     // and using pthread_lock might trigger our wrappers
-    auto  _lk   = locking::atomic_lock{ get_offload_mutex() };
-    auto& _file = get_offload_file();
+    auto _lk = locking::atomic_lock{ m_mutex };
+
+    auto* _head = m_head.exchange(nullptr, std::memory_order_acquire);
+    if(!_head) return;
+
+    // the stack is LIFO so reverse it to preserve the order of the buffers
+    offload_entry* _fifo = nullptr;
+    while(_head)
+    {
+        auto* _next = _head->next;
+        _head->next = _fifo;
+        _fifo       = _head;
+        _head       = _next;
+    }
+
+    bool _written = false;
+    while(_fifo)
+    {
+        auto* _next = _fifo->next;
+        _written |= write(_fifo);
+        delete _fifo;
+        _fifo = _next;
+    }
+
+    // the buffers are read back through separate streams
+    if(_written) m_file->stream.flush();
+}
+
+bool
+offload_writer::write(offload_entry* _entry)
+{
+    auto _seq = _entry->seq;
 
-    ROCPROFSYS_REQUIRE(_file)
-        << "Error! sampling allocator tried to offload buffer of samples for thread "
-        << _seq << " but the offload file does not exist\n";
+    if(!m_file)
+    {
+        m_file        = config::get_tmp_file("sampling");
+        auto _success = m_file && m_file->open();
+        ROCPROFSYS_CI_FAIL(!_success,
+                           "Error opening sampling offload temporary file for thread "
+                           "%li\n",
+                           _seq);
+        if(!_success)
+        {
+            m_file.reset();
+            _entry->buffer.destroy();
+            return false;
+        }
+    }
 
     ROCPROFSYS_VERBOSE_F(2, "Offloading %zu samples for thread %li to %s...\n",
-                         _buf.count(), _seq, _file->filename.c_str());
-    auto& _fs = _file->stream;
+                         _entry->buffer.count(), _seq, m_file->filename.c_str());
+
+    auto& _fs = m_file->stream;
 
     ROCPROFSYS_REQUIRE(_fs.good()) << "Error! temporary file for offloading buffer is in "
                                       "an invalid state during offload for thread "
                                    << _seq << "\n";
 
-    offload_seq_data[_seq].emplace(_fs.tellg());
+    auto& _segment = m_segments[_seq];
+    _segment.index.emplace_back(_fs.tellp());
+    _segment.samples += _entry->buffer.count();
     _fs.write(reinterpret_cast<char*>(&_seq), sizeof(_seq));
-    auto _data = std::move(_buf);
-    _data.save(_fs);
-    _data.destroy();
+    _entry->buffer.save(_fs);
+    _entry->buffer.destroy();
+    return true;
+}
+
+const offload_segment*
+offload_writer::get_segment(int64_t _seq) const
+{
+    auto itr = m_segments.find(_seq);
+    return (itr != m_segments.end() && m_file) ? &itr->second : nullptr;
+}
+
+void
+offload_writer::remove()
+{
+    if(m_file)
+    {
+        m_file->remove();
+        m_file.reset();
+    }
+    m_segments.clear();
+}
+
+void
+offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    ROCPROFSYS_REQUIRE(get_use_tmp_files())
+        << "Error! sampling allocator tries to offload buffer of samples but "
+           "rocprof-sys was configured to not use temporary files\n";
+
+    get_offload_writer().push(_seq, std::move(_buf));
     _buf.destroy();
 }
 
@@ -460,40 +646,33 @@ load_offload_buffer(int64_t _thread_idx)
         return _data;
     }
 
-    // use homemade atomic_mutex/atomic_lock since contention will be low
-    // and using pthread_lock might trigger our wrappers
-    auto  _lk   = locking::atomic_lock{ get_offload_mutex() };
-    auto& _file = get_offload_file();
-    if(!_file)
-    {
-        ROCPROFSYS_WARNING_F(
-            0, "[sampling] returning no data because the offload file no longer exists");
-        return _data;
-    }
-
-    auto& _fs = _file->stream;
-
-    if(_fs.is_open()) _fs.close();
+    // the file is only read after the writer has been stopped so no locking is
+    // necessary and each thread opens its own stream so that the threads can be loaded
+    // concurrently
+    const auto* _segment = get_offload_writer().get_segment(_thread_idx);
+    const auto* _file    = get_offload_writer().get_file();
+    if(!_segment || !_file) return _data;
 
-    if(!_file->open(std::ios::binary | std::ios::in))
+    auto _fs = std::ifstream{ _file->filename, std::ios::binary | std::ios::in };
+    if(!_fs.is_open())
     {
         ROCPROFSYS_WARNING_F(0, "[sampling] %s failed to open", _file->filename.c_str());
         return _data;
     }
 
-    if(offload_seq_data.count(_thread_idx) == 0) return _data;
-
     size_t _count = 0;
-    for(auto itr : offload_seq_data.at(_thread_idx))
+    _data.reserve(_segment->index.size());
+    for(auto itr : _segment->index)
     {
-        _fs.seekg(itr);  // set to the absolute position
-
         int64_t _seq = 0;
+        _fs.seekg(itr);
         _fs.read(reinterpret_cast<char*>(&_seq), sizeof(_seq));
-        if(_fs.eof()) break;
-
-        sampler_buffer_t _buffer{};
-        _buffer.load(_fs);
+        if(!_fs)
+        {
+            ROCPROFSYS_WARNING_F(0, "[sampling] reading %s at file position %zu failed\n",
+                                 _file->filename.c_str(), static_cast<uintptr_t>(itr));
+            break;
+        }
 
         if(_seq != _thread_idx)
         {
@@ -503,15 +682,20 @@ load_offload_buffer(int64_t _thread_idx)
                 static_cast<uintptr_t>(itr), _seq, _thread_idx);
             continue;
         }
+
+        sampler_buffer_t _buffer{};
+        _buffer.load(_fs);
         _count += _buffer.count();
         _data.emplace_back(std::move(_buffer));
     }
 
+    ROCPROFSYS_CI_THROW(_count != _segment->samples,
+                        "Error! offloaded %zu samples for thread %li but loaded %zu\n",
+                        _segment->samples, _thread_idx, _count);
+
     ROCPROFSYS_VERBOSE_F(2, "[sampling] Loaded %zu samples for thread %li...\n", _count,
                          _thread_idx);
 
-    _file->close();
-
     return _data;
 }
 
@@ -570,6 +754,9 @@ configure(bool _setup, int64_t _tid)
         if(trait::runtime_enabled<backtrace_metrics>::get())
             backtrace_metrics::configure(_setup, _tid);
 
+        backtrace::configure(_setup, _tid);
+        rate_controller::configure(_setup, _tid);
+
         // NOTE: signals need to be unblocked by calling function
         sampling::block_signals(*_signal_types);
 
@@ -602,6 +789,12 @@ configure(bool _setup, int64_t _tid)
                        get_sampling_cputime_delay(), _tid, threading::get_sys_tid() });
         }
 
+        // the interrupts skipped by the overhead controller do not reach the sampler
+        for(auto itr : { get_sampling_realtime_signal(), get_sampling_cputime_signal() })
+        {
+            if(_signal_types->count(itr) > 0) rate_controller::install(itr);
+        }
+
         if(_signal_types->count(get_sampling_overflow_signal()) > 0)
         {
             if(_signal_types->size() == 1)
@@ -629,18 +822,72 @@ configure(bool _setup, int64_t _tid)
             _pe.disabled                 = 1;
             _pe.inherit                  = 0;
 
-            if(_pe.type == PERF_TYPE_SOFTWARE)
+            if(get_sampling_overflow_collector())
+            {
+                // CLOCK_REALTIME is not permitted for hardware events (not NMI-safe) so
+                // the collector converts the timestamps
+                _pe.use_clockid = 1;
+                _pe.clockid     = CLOCK_MONOTONIC;
+            }
+            else if(_pe.type == PERF_TYPE_SOFTWARE)
             {
                 _pe.use_clockid = 1;
                 _pe.clockid     = CLOCK_REALTIME;
             }
 
+            if(auto _stack_size = get_sampling_overflow_stack_size(); _stack_size > 0)
+            {
+                // copy the registers and top of the user stack for the offline unwinding.
+                // The callchain is still recorded as a fallback. The kernel requires a
+                // multiple of 8 which does not exceed 65528
+                if(get_sampling_overflow_collector() && perf::get_unwind_regs_mask() != 0)
+                {
+                    _stack_size = std::min<size_t>(_stack_size, 65528);
+                    _stack_size = std::max<size_t>(_stack_size - (_stack_size % 8), 8);
+                    _pe.sample_type |= PERF_SAMPLE_REGS_USER | PERF_SAMPLE_STACK_USER;
+                    _pe.sample_regs_user  = perf::get_unwind_regs_mask();
+                    _pe.sample_stack_user = _stack_size;
+                }
+                else
+                {
+                    static auto _once = std::once_flag{};
+                    std::call_once(_once, []() {
+                        ROCPROFSYS_WARNING(0,
+                                           "ROCPROFSYS_SAMPLING_OVERFLOW_STACK_SIZE is "
+                                           "ignored: copies of the user stack require "
+                                           "ROCPROFSYS_SAMPLING_OVERFLOW_MODE=collector "
+                                           "and are only unwound on x86_64\n");
+                    });
+                }
+            }
+
             auto _perf_open_error =
                 _perf_sampler->open(_pe, _info->index_data->system_value);
 
             ROCPROFSYS_REQUIRE(!_perf_open_error)
                 << "perf backend for overflow failed to activate: " << *_perf_open_error;
+        }
 
+        if(_signal_types->count(get_sampling_overflow_signal()) > 0 &&
+           get_sampling_overflow_collector())
+        {
+            // the ring buffer is drained by the collector thread so this thread never
+            // receives the overflow signal
+            auto& _collector = perf::get_collector();
+            ROCPROFSYS_REQUIRE(_collector.start(&callchain::collect) &&
+                               _collector.add(_tid, _perf_sampler.get()))
+                << "perf collector for overflow sampling failed to activate";
+
+            ROCPROFSYS_VERBOSE(2,
+                               "[perf] Overflow samples of thread %lu will be drained by "
+                               "the collector thread...\n",
+                               _tid);
+
+            _signal_types->erase(get_sampling_overflow_signal());
+            _perf_sampler->start();
+        }
+        else if(_signal_types->count(get_sampling_overflow_signal()) > 0)
+        {
             _perf_sampler->set_ready_signal(get_sampling_overflow_signal());
             _sampler->configure(overflow{
                 get_sampling_overflow_signal(),
@@ -663,8 +910,8 @@ configure(bool _setup, int64_t _tid)
 
         if(get_use_tmp_files())
         {
-            auto _file = get_offload_file();
-            if(_file && *_file) _sampler->set_offload(&offload_buffer);
+            get_offload_writer().start();
+            _sampler->set_offload(&offload_buffer);
         }
 
         static_assert(tim::trait::buffer_size<sampling::sampler_t>::value > 0,
@@ -778,11 +1025,13 @@ configure(bool _setup, int64_t _tid)
 
 struct timer_sampling_data
 {
-    int64_t                                   m_tid     = -1;
-    uint64_t                                  m_beg     = 0;
-    uint64_t                                  m_end     = 0;
-    std::vector<tim::unwind::processed_entry> m_stack   = {};
-    backtrace_metrics                         m_metrics = {};
+    int64_t                             m_tid     = -1;
+    uint64_t                            m_beg     = 0;
+    uint64_t                            m_end     = 0;
+    uint64_t                            m_period  = 0;   // effective sampling period
+    backtrace::data_t                   m_pcs     = {};  // raw call-stack
+    std::vector<symbolizer::frame_id_t> m_stack   = {};  // symbolized call-stack
+    backtrace_metrics                   m_metrics = {};
 };
 
 struct overflow_sampling_data
@@ -793,6 +1042,18 @@ struct overflow_sampling_data
     std::vector<tim::unwind::processed_entry> m_stack = {};
 };
 
+// the post-processed (but not yet emitted) sampling data for a single thread
+struct thread_sampling_data
+{
+    int64_t                             m_tid           = -1;
+    size_t                              m_count         = 0;
+    std::vector<timer_sampling_data>    m_timer_data    = {};
+    std::vector<overflow_sampling_data> m_overflow_data = {};
+};
+
+thread_sampling_data
+post_process_thread_data(int64_t);
+
 std::vector<timer_sampling_data>
 post_process_timer_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
 
@@ -800,11 +1061,16 @@ std::vector<overflow_sampling_data>
 post_process_overflow_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
 
 void
-post_process_perfetto(int64_t, const std::vector<timer_sampling_data>&,
+symbolize_timer_data(const symbolizer::frame_table&, std::vector<timer_sampling_data>&);
+
+void
+post_process_perfetto(int64_t, const symbolizer::frame_table&,
+                      const std::vector<timer_sampling_data>&,
                       const std::vector<overflow_sampling_data>&);
 
 void
-post_process_timemory(int64_t, const std::vector<timer_sampling_data>&,
+post_process_timemory(int64_t, const symbolizer::frame_table&,
+                      const std::vector<timer_sampling_data>&,
                       const std::vector<overflow_sampling_data>&);
 
 auto static_strings = std::set<std::string>{};
@@ -893,6 +1159,7 @@ post_process()
 
     size_t _total_data       = 0;
     size_t _total_threads    = 0;
+    size_t _total_overflow   = 0;
     auto   _external_samples = std::atomic<size_t>{ 0 };
     auto   _internal_samples = std::atomic<size_t>{ 0 };
 
@@ -901,106 +1168,178 @@ post_process()
     rocprofsys::component::backtrace::stop();
     configure(false, 0);
 
+    // drain whatever the perf ring buffers still hold and stop the collector thread
+    if(get_sampling_overflow_collector())
+    {
+        auto& _collector = perf::get_collector();
+        _collector.stop();
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "[sampling] perf collector: %lu samples in %lu wakeups\n",
+                           static_cast<unsigned long>(_collector.get_count()),
+                           static_cast<unsigned long>(_collector.get_wakeups()));
+
+        // unwind the copies of the user stacks now that no more samples will be added
+        callchain::unwind_collected();
+    }
+
     for(auto& itr : get_sampler_allocators())
         if(itr) itr->flush();
 
-    for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
-    {
-        auto& _sampler = get_sampler(i);
+    // write out any pending offloaded buffers and stop the writer thread
+    if(get_use_tmp_files()) get_offload_writer().stop();
 
-        if(!_sampler)
+    const auto _nthreads = thread_info::get_peak_num_threads();
+    const bool _parallel = config::get_sampling_parallel_post_process() && _nthreads > 1;
+    const auto _beg      = std::chrono::steady_clock::now();
+
+    // the samples of every thread are collected before any of them are symbolized so
+    // that each unique program counter is only resolved once
+    auto _data = std::vector<thread_sampling_data>(_nthreads);
+    auto _exec = [_parallel, _nthreads](auto&& _func) {
+        if(_parallel)
         {
-            // this should be relatively common
-            ROCPROFSYS_CONDITIONAL_PRINT(
-                get_debug() && get_verbose() >= 2,
-                "Post-processing sampling entries for thread %lu skipped (no sampler)\n",
-                i);
-            continue;
+            auto& _tg = tasking::general::get_task_group();
+            for(size_t i = 0; i < _nthreads; ++i)
+                _tg.exec([i, &_func]() { _func(i); });
+            _tg.join();
         }
-
-        auto* _init = get_sampler_init(i).get();
-
-        if(!_init)
+        else
         {
-            // this is not common
-            ROCPROFSYS_PRINT("Post-processing sampling entries for thread %lu skipped "
-                             "(not initialized)\n",
-                             i);
-            continue;
+            for(size_t i = 0; i < _nthreads; ++i)
+                _func(i);
         }
+    };
 
-        const auto& _thread_info = thread_info::get(i, SequentTID);
+    if(_parallel)
+    {
+        ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
+                           "Post-processing sampling data for %zu threads in parallel "
+                           "(thread-pool size: %zu)...\n",
+                           _nthreads, config::get_thread_pool_size());
+    }
 
-        ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
-                           "Getting sampler data for thread %lu...\n", i);
+    _exec([&_data](size_t i) { _data.at(i) = post_process_thread_data(i); });
 
-        auto _raw_data    = _sampler->get_data();
-        auto _loaded_data = load_offload_buffer(i);
-        for(auto litr : _loaded_data)
-        {
-            while(!litr.is_empty())
-            {
-                auto _v = sampler_bundle_t{};
-                litr.read(&_v);
-                _raw_data.emplace_back(std::move(_v));
-            }
-            litr.destroy();
-        }
+    auto _frames = [&_data]() {
+        auto _pcs = std::vector<uintptr_t>{};
+        for(const auto& itr : _data)
+            for(const auto& titr : itr.m_timer_data)
+                _pcs.insert(_pcs.end(), titr.m_pcs.begin(), titr.m_pcs.end());
+        return symbolizer::symbolize(std::move(_pcs));
+    }();
 
-        ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
-                           "Sampler data for thread %lu has %zu initial entries...\n", i,
-                           _raw_data.size());
-
-        ROCPROFSYS_CI_THROW(
-            _sampler->get_sample_count() != _raw_data.size(),
-            "Error! sampler recorded %zu samples but %zu samples were returned\n",
-            _sampler->get_sample_count(), _raw_data.size());
-        // single sample that is useless (backtrace to unblocking signals)
-        if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
-
-        std::vector<sampling::bundle_t*> _data{};
-        for(auto& itr : _raw_data)
+    for(auto& itr : _frames.frames)
+    {
+        if(itr.resolved)
+            itr.label = static_strings.emplace(itr.entry.name).first->c_str();
+    }
+
+    _exec([&_data, &_frames](size_t i) {
+        symbolize_timer_data(_frames, _data.at(i).m_timer_data);
+    });
+
+    const auto _outputs  = config::get_sampling_output();
+    const bool _perfetto = get_use_perfetto() && _outputs.count("perfetto") > 0;
+    const bool _timemory = get_use_timemory() && _outputs.count("timemory") > 0;
+    const bool _folded   = _outputs.count("folded") > 0;
+    const bool _pprof    = _outputs.count("pprof") > 0;
+
+    auto _timer_profile    = stack_profile{ "sampling-timer" };
+    auto _overflow_profile = stack_profile{ "sampling-overflow" };
+
+    // perfetto and timemory emission always happens serially and in thread order so
+    // that the output is deterministic regardless of the post-processing mode
+    for(auto& itr : _data)
+    {
+        _total_data += itr.m_count;
+        _total_threads += (itr.m_count > 0) ? 1 : 0;
+        _total_overflow += itr.m_overflow_data.size();
+
+        if(itr.m_count == 0) continue;
+
+        if(_perfetto)
+            post_process_perfetto(itr.m_tid, _frames, itr.m_timer_data,
+                                  itr.m_overflow_data);
+        if(_timemory)
+            post_process_timemory(itr.m_tid, _frames, itr.m_timer_data,
+                                  itr.m_overflow_data);
+
+        if(_folded || _pprof)
         {
-            auto* _bt = itr.get<backtrace>();
-            auto* _cc = itr.get<callchain>();
-            auto* _ts = itr.get<backtrace_timestamp>();
-            if(_thread_info && ((_bt && !_bt->empty()) || (_cc && !_cc->empty())) &&
-               _ts && _thread_info->is_valid_time(_ts->get_timestamp()))
-            {
-                _data.emplace_back(&itr);
-            }
+            for(const auto& titr : itr.m_timer_data)
+                _timer_profile.add(_frames, titr.m_stack, titr.m_end - titr.m_beg);
+            for(const auto& oitr : itr.m_overflow_data)
+                _overflow_profile.add(oitr.m_stack, oitr.m_end - oitr.m_beg);
         }
 
-        _total_data += _data.size();
-        _total_threads += (!_data.empty()) ? 1 : 0;
+        itr = thread_sampling_data{};
+    }
 
-        if(!_data.empty())
-        {
-            ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
-                               "Sampler data for thread %lu has %zu valid entries...\n",
-                               i, _data.size());
+    _timer_profile.write(_folded, _pprof);
+    _overflow_profile.write(_folded, _pprof);
 
-            auto _timer_data    = post_process_timer_data(i, _init, _data);
-            auto _overflow_data = post_process_overflow_data(i, _init, _data);
+    ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                       "Post-processing sampling data for %zu threads (%s) took %.3f "
+                       "sec...\n",
+                       _nthreads, (_parallel) ? "parallel" : "serial",
+                       std::chrono::duration<double>{ std::chrono::steady_clock::now() -
+                                                      _beg }
+                           .count());
+
+    if(auto _stats = backtrace::get_unwind_stats(); _stats.samples > 0)
+    {
+        // the latency is only measured with ROCPROFSYS_SAMPLING_UNWIND_STATS
+        auto _latency = std::string{};
+        if(get_sampling_unwind_stats())
+            _latency = JOIN("", ", ",
+                            (_stats.nsec / static_cast<double>(_stats.samples)) / 1.0e3,
+                            " usec/sample");
+
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "[sampling] %s unwinder: %lu samples%s, %lu frame-pointer "
+                           "fallbacks (%.1f%%)\n",
+                           (get_sampling_frame_pointer_unwind()) ? "frame-pointer"
+                                                                 : "libunwind",
+                           static_cast<unsigned long>(_stats.samples), _latency.c_str(),
+                           static_cast<unsigned long>(_stats.fallbacks),
+                           (100.0 * _stats.fallbacks) / _stats.samples);
+    }
 
-            if(get_use_perfetto()) post_process_perfetto(i, _timer_data, _overflow_data);
-            if(get_use_timemory()) post_process_timemory(i, _timer_data, _overflow_data);
-        }
-        else
+    if(auto _stats = rate_controller::get_stats();
+       rate_controller::is_enabled() && _stats.interrupts > 0)
+    {
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "[sampling] overhead controller: sampled %lu of %lu timer "
+                           "interrupts (max stride: %u)\n",
+                           static_cast<unsigned long>(_stats.samples),
+                           static_cast<unsigned long>(_stats.interrupts),
+                           _stats.max_stride);
+    }
+
+#if ROCPROFSYS_SAMPLING_COMPACT_STACKS > 0
+    {
+        size_t _nodes   = 0;
+        size_t _memory  = 0;
+        size_t _dropped = 0;
+        for(size_t i = 0; i < _nthreads; ++i)
         {
-            ROCPROFSYS_VERBOSE(
-                2 || get_debug_sampling(),
-                "Sampler data for thread %lu has zero valid entries out of "
-                "%zu... (skipped)\n",
-                i, _raw_data.size());
+            const auto* _trie = backtrace::get_stack_trie(i);
+            if(!_trie) continue;
+            _nodes += _trie->size();
+            _memory += _trie->memory();
+            _dropped += _trie->dropped();
         }
+
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "[sampling] call-stack trees: %zu nodes, %.3f MB, %zu "
+                           "dropped call-stacks\n",
+                           _nodes, _memory / static_cast<double>(1024 * 1024), _dropped);
     }
+#endif
 
     ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
                        "Destroying samplers and allocators...\n");
 
-    get_offload_file().reset();  // remove the temporary file
-
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
         get_sampler(i).reset();
 
@@ -1009,21 +1348,143 @@ post_process()
         if(itr) itr.reset();
     }
 
-    if(get_use_tmp_files() && get_offload_file())
-    {
-        get_offload_file()->remove();
-        get_offload_file().reset();
-    }
+    // remove the temporary files
+    if(get_use_tmp_files()) get_offload_writer().remove();
 
     ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
                        "Collected %zu samples from %zu threads... %zu samples out of %zu "
                        "were taken while within instrumented routines\n",
                        _total_data, _total_threads, _internal_samples.load(),
                        (_internal_samples + _external_samples));
+
+    if(_total_overflow > 0)
+    {
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "[sampling] %zu overflow samples were post-processed...\n",
+                           _total_overflow);
+    }
 }
 
 namespace
 {
+thread_sampling_data
+post_process_thread_data(int64_t i)
+{
+    auto  _v       = thread_sampling_data{};
+    auto& _sampler = get_sampler(i);
+
+    _v.m_tid = i;
+
+    if(!_sampler)
+    {
+        // this should be relatively common
+        ROCPROFSYS_CONDITIONAL_PRINT(
+            get_debug() && get_verbose() >= 2,
+            "Post-processing sampling entries for thread %li skipped (no sampler)\n", i);
+        return _v;
+    }
+
+    auto* _init = get_sampler_init(i).get();
+
+    if(!_init)
+    {
+        // this is not common
+        ROCPROFSYS_PRINT("Post-processing sampling entries for thread %li skipped "
+                         "(not initialized)\n",
+                         i);
+        return _v;
+    }
+
+    const auto& _thread_info = thread_info::get(i, SequentTID);
+
+    ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
+                       "Getting sampler data for thread %li...\n", i);
+
+    auto _raw_data    = _sampler->get_data();
+    auto _loaded_data = load_offload_buffer(i);
+    auto _in_memory   = _raw_data.size();
+
+    // the offloaded samples were recorded before the samples which are still in memory
+    auto _get_timestamp = [](sampler_bundle_t& _bundle) {
+        auto* _ts = _bundle.get<backtrace_timestamp>();
+        return (_ts) ? _ts->get_timestamp() : uint64_t{ 0 };
+    };
+    auto _first_timestamp = std::numeric_limits<uint64_t>::max();
+    if(!_raw_data.empty() && _get_timestamp(_raw_data.front()) > 0)
+        _first_timestamp = _get_timestamp(_raw_data.front());
+    size_t _reordered = 0;
+    for(auto litr : _loaded_data)
+    {
+        while(!litr.is_empty())
+        {
+            auto _bundle = sampler_bundle_t{};
+            litr.read(&_bundle);
+            if(_get_timestamp(_bundle) > _first_timestamp) ++_reordered;
+            _raw_data.emplace_back(std::move(_bundle));
+        }
+        litr.destroy();
+    }
+
+    ROCPROFSYS_CI_THROW(_reordered > 0,
+                        "Error! %zu offloaded samples of thread %li are newer than the "
+                        "samples in memory\n",
+                        _reordered, i);
+
+    if(_raw_data.size() > _in_memory)
+    {
+        ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                           "Sampler data for thread %li has %zu offloaded and %zu "
+                           "in-memory entries...\n",
+                           i, _raw_data.size() - _in_memory, _in_memory);
+    }
+
+    ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
+                       "Sampler data for thread %li has %zu initial entries...\n", i,
+                       _raw_data.size());
+
+    ROCPROFSYS_CI_THROW(
+        _sampler->get_sample_count() != _raw_data.size(),
+        "Error! sampler recorded %zu samples but %zu samples were returned\n",
+        _sampler->get_sample_count(), _raw_data.size());
+    // single sample that is useless (backtrace to unblocking signals)
+    if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
+
+    std::vector<sampling::bundle_t*> _data{};
+    for(auto& itr : _raw_data)
+    {
+        auto* _bt = itr.get<backtrace>();
+        auto* _cc = itr.get<callchain>();
+        auto* _ts = itr.get<backtrace_timestamp>();
+        if(_thread_info && ((_bt && !_bt->empty()) || (_cc && !_cc->empty())) && _ts &&
+           _thread_info->is_valid_time(_ts->get_timestamp()))
+        {
+            _data.emplace_back(&itr);
+        }
+    }
+
+    // samples drained by the perf collector thread are not in the sampler buffers
+    auto _collected = callchain::get_collected_size(i);
+
+    if(_data.empty() && _collected == 0)
+    {
+        ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
+                           "Sampler data for thread %li has zero valid entries out of "
+                           "%zu... (skipped)\n",
+                           i, _raw_data.size());
+        return _v;
+    }
+
+    ROCPROFSYS_VERBOSE(2 || get_debug_sampling(),
+                       "Sampler data for thread %li has %zu valid entries...\n", i,
+                       _data.size());
+
+    _v.m_count         = _data.size() + _collected;
+    _v.m_timer_data    = post_process_timer_data(i, _init, _data);
+    _v.m_overflow_data = post_process_overflow_data(i, _init, _data);
+
+    return _v;
+}
+
 std::vector<timer_sampling_data>
 post_process_timer_data(int64_t _tid, const bundle_t* _init,
                         const std::vector<bundle_t*>& _data)
@@ -1041,11 +1502,12 @@ post_process_timer_data(int64_t _tid, const bundle_t* _init,
         if(!_bt_data || !_bt_time || _bt_data->empty() || _bt_time->get_tid() != _tid)
             continue;
 
-        auto _ret    = timer_sampling_data{};
-        _ret.m_tid   = _bt_time->get_tid();
-        _ret.m_beg   = _last->get<backtrace_timestamp>()->get_timestamp();
-        _ret.m_end   = _bt_time->get_timestamp();
-        _ret.m_stack = backtrace::filter_and_patch(_bt_data->get());
+        auto _ret     = timer_sampling_data{};
+        _ret.m_tid    = _bt_time->get_tid();
+        _ret.m_beg    = _last->get<backtrace_timestamp>()->get_timestamp();
+        _ret.m_end    = _bt_time->get_timestamp();
+        _ret.m_period = _bt_time->get_period();
+        _ret.m_pcs    = _bt_data->get_data(_tid);
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             auto _hw_counters_enabled = [](const auto* _bt_v) {
@@ -1071,6 +1533,17 @@ post_process_timer_data(int64_t _tid, const bundle_t* _init,
     return _results;
 }
 
+void
+symbolize_timer_data(const symbolizer::frame_table&   _frames,
+                     std::vector<timer_sampling_data>& _timer_data)
+{
+    for(auto& itr : _timer_data)
+    {
+        itr.m_stack = _frames.get_stack(itr.m_pcs);
+        itr.m_pcs.clear();
+    }
+}
+
 std::vector<overflow_sampling_data>
 post_process_overflow_data(int64_t                       _tid, const bundle_t*,
                            const std::vector<bundle_t*>& _data)
@@ -1079,6 +1552,30 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
 
     uint64_t _last_call_ts   = 0;
     uint64_t _perf_ts_offset = 0;
+
+    if(get_sampling_overflow_collector())
+    {
+        // the timestamps were already converted to the realtime clock by the collector
+        const auto& _thread_info = thread_info::get(_tid, SequentTID);
+        for(auto& pitr : callchain::filter_and_patch(callchain::get_collected(_tid)))
+        {
+            if(_thread_info && !_thread_info->is_valid_time(pitr.first)) continue;
+
+            if(_last_call_ts > 0)
+            {
+                auto _ret    = overflow_sampling_data{};
+                _ret.m_tid   = _tid;
+                _ret.m_beg   = _last_call_ts;
+                _ret.m_end   = pitr.first;
+                _ret.m_stack = std::move(pitr.second);
+                _results.emplace_back(std::move(_ret));
+            }
+            _last_call_ts = pitr.first;
+        }
+
+        return _results;
+    }
+
     for(const auto& itr : _data)
     {
         auto* _bt_call = itr->get<callchain>();
@@ -1087,7 +1584,7 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
         if(!_bt_call || !_bt_time || _bt_call->empty() || _bt_time->get_tid() != _tid)
             continue;
 
-        for(const auto& pitr : callchain::filter_and_patch(_bt_call->get()))
+        for(const auto& pitr : callchain::filter_and_patch(_bt_call->get(_tid)))
         {
             if(_last_call_ts == 0)
             {
@@ -1113,7 +1610,8 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
 }
 
 void
-post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
+post_process_perfetto(int64_t _tid, const symbolizer::frame_table& _frames,
+                      const std::vector<timer_sampling_data>&    _timer_data,
                       const std::vector<overflow_sampling_data>& _overflow_data)
 {
     auto _valid_metrics = backtrace_metrics::valid_array_t{};
@@ -1258,9 +1756,11 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
             uint64_t _end    = itr.m_end;
             if(!_thread_info->is_valid_lifetime({ _beg, _end })) continue;
 
-            for(const auto& iitr : itr.m_stack)
+            for(auto fitr : itr.m_stack)
             {
-                auto _ncur = _ncount++;
+                const auto& _frame = _frames.at(fitr);
+                const auto& iitr   = _frame.entry;
+                auto        _ncur  = _ncount++;
                 // the begin/end + HW counters will be same for entire call-stack so only
                 // annotate the top and the bottom functons to keep the data consumption
                 // low
@@ -1278,6 +1778,9 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
                     {
                         tracing::add_perfetto_annotation(ctx, "begin_ns", _beg);
                         tracing::add_perfetto_annotation(ctx, "end_ns", _end);
+                        if(itr.m_period > 0)
+                            tracing::add_perfetto_annotation(ctx, "period_ns",
+                                                             itr.m_period);
                     }
 
                     if(_include_hw)
@@ -1321,7 +1824,7 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
                 }
                 else
                 {
-                    const auto* _name = static_strings.emplace(iitr.name).first->c_str();
+                    const auto* _name = _frame.label;
                     tracing::push_perfetto_track(
                         category::timer_sampling{}, _name, _track, _beg,
                         [&](::perfetto::EventContext ctx) {
@@ -1369,7 +1872,8 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
 }
 
 void
-post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
+post_process_timemory(int64_t _tid, const symbolizer::frame_table& _frames,
+                      const std::vector<timer_sampling_data>&    _timer_data,
                       const std::vector<overflow_sampling_data>& _overflow_data)
 {
     ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
@@ -1427,9 +1931,9 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         _data.reserve(itr.m_stack.size());
 
         // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
+        for(auto fitr : itr.m_stack)
         {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
+            _data.emplace_back(tim::string_view_t{ _frames.at(fitr).entry.name });
             _data.back().push(itr.m_tid);
             _data.back().start();
         }
@@ -1518,9 +2022,9 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         _data.reserve(itr.m_stack.size());
 
         // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
+        for(auto fitr : itr.m_stack)
         {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
+            _data.emplace_back(tim::string_view_t{ _frames.at(fitr).entry.name });
             _data.back().push(itr.m_tid);
             _data.back().start();
         }
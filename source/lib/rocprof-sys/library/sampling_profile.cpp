@@ -0,0 +1,372 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/sampling_profile.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string_view>
+#include <utility>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+namespace
+{
+// minimal encoder for the subset of the protobuf wire format used by profile.proto
+struct protobuf_encoder
+{
+    enum wire_type : uint8_t
+    {
+        varint_type = 0,
+        bytes_type  = 2,
+    };
+
+    void add_varint(uint64_t _v)
+    {
+        while(_v >= 0x80)
+        {
+            buffer += static_cast<char>((_v & 0x7f) | 0x80);
+            _v >>= 7;
+        }
+        buffer += static_cast<char>(_v);
+    }
+
+    void add_key(uint32_t _field, wire_type _type) { add_varint((_field << 3) | _type); }
+
+    // default values (zero) are not encoded
+    void add_int(uint32_t _field, uint64_t _v)
+    {
+        if(_v == 0) return;
+        add_key(_field, varint_type);
+        add_varint(_v);
+    }
+
+    void add_bytes(uint32_t _field, std::string_view _v)
+    {
+        add_key(_field, bytes_type);
+        add_varint(_v.size());
+        buffer.append(_v.data(), _v.size());
+    }
+
+    void add_message(uint32_t _field, const protobuf_encoder& _v)
+    {
+        add_bytes(_field, _v.buffer);
+    }
+
+    // the fields of a message are concatenated so they can be written as they are
+    // encoded
+    void flush(std::ostream& _os)
+    {
+        _os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    template <typename ContainerT>
+    void add_packed(uint32_t _field, const ContainerT& _v)
+    {
+        auto _packed = protobuf_encoder{};
+        for(auto itr : _v)
+            _packed.add_varint(itr);
+        add_message(_field, _packed);
+    }
+
+    std::string buffer = {};
+};
+
+// string table of the profile. Index zero must be the empty string
+struct string_table
+{
+    uint64_t operator()(std::string_view _v)
+    {
+        auto itr = indexes.emplace(std::string{ _v }, strings.size());
+        if(itr.second) strings.emplace_back(_v);
+        return itr.first->second;
+    }
+
+    std::vector<std::string>                  strings = { std::string{} };
+    std::unordered_map<std::string, uint64_t> indexes = { { std::string{}, 0 } };
+};
+
+std::string
+get_folded_name(std::string_view _name)
+{
+    auto _v = std::string{ _name };
+    // frames are delimited by semicolons and the value follows the last space
+    std::replace(_v.begin(), _v.end(), ';', ':');
+    std::replace(_v.begin(), _v.end(), '\n', ' ');
+    return _v;
+}
+
+template <typename Tp>
+void
+write_output(const std::string& _fname, const char* _label, Tp&& _func)
+{
+    auto _ofs = std::ofstream{};
+    if(tim::filepath::open(_ofs, _fname))
+    {
+        if(config::get_verbose() >= 0)
+            operation::file_output_message<tim::project::rocprofsys>{}(
+                _fname, std::string{ _label });
+        _func(_ofs);
+    }
+    else
+    {
+        ROCPROFSYS_THROW("Error opening sampling profile output file: %s",
+                         _fname.c_str());
+    }
+}
+}  // namespace
+
+stack_profile::stack_profile(std::string _name)
+: m_name{ std::move(_name) }
+, m_stacks{ std::make_unique<trie_t>() }
+{}
+
+uint32_t
+stack_profile::get_function_id(const std::string& _name, const std::string& _file)
+{
+    auto _key = _name;
+    _key += '\0';
+    _key += _file;
+
+    auto itr = m_function_ids.find(_key);
+    if(itr != m_function_ids.end()) return itr->second;
+    if(m_functions.size() >= max_functions) return invalid_function;
+
+    itr = m_function_ids.emplace(std::move(_key), m_functions.size()).first;
+    m_functions.emplace_back(&itr->first);
+    return itr->second;
+}
+
+std::string_view
+stack_profile::get_function_name(uint32_t _id) const
+{
+    const auto& _key = *m_functions.at(_id);
+    return std::string_view{ _key.data(), _key.find('\0') };
+}
+
+std::string_view
+stack_profile::get_function_file(uint32_t _id) const
+{
+    const auto& _key = *m_functions.at(_id);
+    return std::string_view{ _key }.substr(_key.find('\0') + 1);
+}
+
+template <typename FuncT>
+void
+stack_profile::add(size_t _n, FuncT&& _get, uint64_t _nsec)
+{
+    if(_n == 0) return;
+
+    // the call-stack tree expects the innermost frame first
+    auto _stack = std::vector<uint32_t>{};
+    _stack.reserve(_n);
+    for(size_t i = _n; i > 0; --i)
+    {
+        auto _func = _get(i - 1);
+        if(_func == invalid_function)
+        {
+            m_dropped.samples += 1;
+            m_dropped.nsec += _nsec;
+            return;
+        }
+        _stack.emplace_back(_func);
+    }
+
+    auto  _id    = m_stacks->insert(_stack);
+    auto& _value = (_id == trie_t::npos) ? m_dropped : m_values[_id];
+    _value.samples += 1;
+    _value.nsec += _nsec;
+}
+
+void
+stack_profile::add(const symbolizer::frame_table&  _frames,
+                   const std::vector<frame_id_t>& _stack, uint64_t _nsec)
+{
+    add(
+        _stack.size(),
+        [&](size_t i) {
+            const auto& _entry = _frames.at(_stack.at(i)).entry;
+            return get_function_id(_entry.name, _entry.location);
+        },
+        _nsec);
+}
+
+void
+stack_profile::add(const std::vector<entry_type>& _stack, uint64_t _nsec)
+{
+    add(
+        _stack.size(),
+        [&](size_t i) {
+            const auto& _entry = _stack.at(i);
+            return get_function_id(_entry.name, _entry.location);
+        },
+        _nsec);
+}
+
+std::vector<uint32_t>
+stack_profile::get_stack(trie_t::id_type _id) const
+{
+    auto _stack = std::vector<uint32_t>{};
+    _stack.reserve(m_stacks->depth(_id));
+    m_stacks->expand(_id, _stack);
+    return _stack;
+}
+
+void
+stack_profile::write(bool _folded, bool _pprof) const
+{
+    if(empty()) return;
+
+    if(m_dropped.samples > 0)
+    {
+        ROCPROFSYS_WARNING(0,
+                           "[sampling] %s: %lu samples (%.3f sec) were not included in "
+                           "the profile because it exceeded the maximum number of "
+                           "unique call-stacks or functions\n",
+                           m_name.c_str(), static_cast<unsigned long>(m_dropped.samples),
+                           m_dropped.nsec / 1.0e9);
+    }
+
+    if(_folded)
+        write_folded(tim::settings::compose_output_filename(m_name, ".folded"));
+    if(_pprof) write_pprof(tim::settings::compose_output_filename(m_name, ".pb"));
+}
+
+void
+stack_profile::write_folded(const std::string& _fname) const
+{
+    // sorted so that the output is deterministic
+    auto _lines = std::vector<std::pair<std::string, uint64_t>>{};
+    _lines.reserve(m_values.size());
+    for(const auto& itr : m_values)
+    {
+        // outermost frame first
+        auto _stack = get_stack(itr.first);
+        auto _line  = std::string{};
+        for(auto fitr = _stack.rbegin(); fitr != _stack.rend(); ++fitr)
+        {
+            if(!_line.empty()) _line += ';';
+            _line += get_folded_name(get_function_name(*fitr));
+        }
+        _lines.emplace_back(std::move(_line), itr.second.nsec);
+    }
+
+    std::sort(_lines.begin(), _lines.end());
+
+    write_output(_fname, "sampling_folded", [&_lines](std::ofstream& _ofs) {
+        for(const auto& itr : _lines)
+            _ofs << itr.first << ' ' << itr.second << '\n';
+    });
+}
+
+void
+stack_profile::write_pprof(const std::string& _fname) const
+{
+    // field numbers of perftools.profiles.Profile (profile.proto)
+    enum profile_field : uint32_t
+    {
+        sample_type         = 1,
+        sample              = 2,
+        location            = 4,
+        function_field      = 5,
+        string_table_field  = 6,
+        time_nanos          = 9,
+        default_sample_type = 14,
+    };
+
+    // the fields of the profile are written to the file as they are encoded so only
+    // the string table is kept until the end
+    write_output(_fname, "sampling_pprof", [this](std::ofstream& _ofs) {
+        auto _strings = string_table{};
+        auto _profile = protobuf_encoder{};
+
+        // ValueType { type = 1, unit = 2 }
+        auto _value_type = [&_strings](const char* _type, const char* _unit) {
+            auto _v = protobuf_encoder{};
+            _v.add_int(1, _strings(_type));
+            _v.add_int(2, _strings(_unit));
+            return _v;
+        };
+
+        _profile.add_message(sample_type, _value_type("samples", "count"));
+        _profile.add_message(sample_type, _value_type("time", "nanoseconds"));
+        _profile.flush(_ofs);
+
+        // Sample { location_id = 1 (innermost first), value = 2 }. The location ids are
+        // the function ids + 1 since zero is not a valid id
+        for(const auto& itr : m_values)
+        {
+            auto _stack = get_stack(itr.first);
+            for(auto& fitr : _stack)
+                fitr += 1;
+
+            auto _sample = protobuf_encoder{};
+            _sample.add_packed(1, _stack);
+            _sample.add_packed(2, std::array<uint64_t, 2>{ itr.second.samples,
+                                                           itr.second.nsec });
+            _profile.add_message(sample, _sample);
+            _profile.flush(_ofs);
+        }
+
+        // Location { id = 1, line = 4 } with Line { function_id = 1 } and
+        // Function { id = 1, name = 2, system_name = 3, filename = 4 }
+        for(uint32_t i = 0; i < m_functions.size(); ++i)
+        {
+            auto _name = _strings(get_function_name(i));
+
+            auto _line = protobuf_encoder{};
+            _line.add_int(1, i + 1);
+
+            auto _location = protobuf_encoder{};
+            _location.add_int(1, i + 1);
+            _location.add_message(4, _line);
+            _profile.add_message(location, _location);
+
+            auto _function = protobuf_encoder{};
+            _function.add_int(1, i + 1);
+            _function.add_int(2, _name);
+            _function.add_int(3, _name);
+            _function.add_int(4, _strings(get_function_file(i)));
+            _profile.add_message(function_field, _function);
+            _profile.flush(_ofs);
+        }
+
+        _profile.add_int(time_nanos, tim::get_clock_real_now<uint64_t, std::nano>());
+        _profile.add_int(default_sample_type, _strings("time"));
+
+        for(const auto& itr : _strings.strings)
+            _profile.add_bytes(string_table_field, itr);
+        _profile.flush(_ofs);
+    });
+}
+}  // namespace sampling
+}  // namespace rocprofsys
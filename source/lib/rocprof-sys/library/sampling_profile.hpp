@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/containers/stack_trie.hpp"
+#include "core/defines.hpp"
+#include "library/symbolizer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+/// Aggregates the post-processed call-stacks of the samples per unique call-stack and
+/// writes them directly as folded stacks (flamegraph.pl, speedscope) and/or as a pprof
+/// profile without constructing the timemory call-graph storage. The unique
+/// call-stacks are interned in a call-stack tree with a fixed maximum number of nodes
+/// and the functions in a table with a fixed maximum number of entries so the memory
+/// usage is bounded regardless of the number of threads and samples
+class stack_profile
+{
+public:
+    using frame_id_t = symbolizer::frame_id_t;
+    using entry_type = symbolizer::entry_type;
+
+    explicit stack_profile(std::string _name);
+
+    // the call-stacks are ordered with the bottom of the call-stack first
+    void add(const symbolizer::frame_table&, const std::vector<frame_id_t>&,
+             uint64_t _nsec);
+    void add(const std::vector<entry_type>&, uint64_t _nsec);
+
+    bool empty() const { return m_values.empty(); }
+
+    /// writes <name>.folded and/or <name>.pb
+    void write(bool _folded, bool _pprof) const;
+
+private:
+    // 256 chunks of 4096 nodes, i.e. ~20 MB at most
+    using trie_t = container::stack_trie<uint32_t, 4096, 256>;
+
+    // samples with a function which does not fit in the table are dropped
+    static constexpr uint32_t max_functions    = 65536;
+    static constexpr uint32_t invalid_function = max_functions;
+
+    struct value
+    {
+        uint64_t samples = 0;
+        uint64_t nsec    = 0;
+    };
+
+    template <typename FuncT>
+    void add(size_t _n, FuncT&& _get, uint64_t _nsec);
+
+    uint32_t              get_function_id(const std::string&, const std::string&);
+    std::string_view      get_function_name(uint32_t) const;
+    std::string_view      get_function_file(uint32_t) const;
+    std::vector<uint32_t> get_stack(trie_t::id_type) const;
+
+    void write_folded(const std::string& _fname) const;
+    void write_pprof(const std::string& _fname) const;
+
+    std::string                                m_name         = {};
+    value                                      m_dropped      = {};
+    // the name and the file of a function separated by a null character. The keys of
+    // the map are not relocated so the table of the functions refers to them
+    std::vector<const std::string*>            m_functions    = {};
+    std::unordered_map<std::string, uint32_t>  m_function_ids = {};
+    std::unique_ptr<trie_t>                    m_stacks       = {};
+    std::unordered_map<trie_t::id_type, value> m_values       = {};
+};
+}  // namespace sampling
+}  // namespace rocprofsys
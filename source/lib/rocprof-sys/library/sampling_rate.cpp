@@ -0,0 +1,269 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/sampling_rate.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+namespace
+{
+// the handler time is compared against the budget after this much wall-time
+constexpr uint64_t window_nsec = 100000000;
+constexpr uint32_t max_stride  = 1000;
+
+struct timer_state
+{
+    int      signo  = -1;
+    uint64_t period = 0;
+};
+
+struct thread_state
+{
+    bool        enabled     = false;
+    bool        in_handler  = false;
+    uint32_t    stride      = 1;
+    uint32_t    countdown   = 1;
+    uint64_t    period      = 0;
+    uint64_t    handler_beg = 0;
+    uint64_t    window_beg  = 0;
+    uint64_t    window_cost = 0;
+    timer_state timers[2]   = {};
+};
+
+struct global_counters
+{
+    std::atomic<uint64_t> interrupts = { 0 };
+    std::atomic<uint64_t> samples    = { 0 };
+    std::atomic<uint32_t> max_stride = { 1 };
+};
+
+using sigaction_func_t = void (*)(int, siginfo_t*, void*);
+
+// the handlers of the sampler which are invoked for the interrupts which are sampled
+std::array<std::atomic<sigaction_func_t>, NSIG> chained_handlers = {};
+
+auto&
+get_thread_state()
+{
+    static thread_local auto _v = thread_state{};
+    return _v;
+}
+
+auto&
+get_global_counters()
+{
+    static auto _v = global_counters{};
+    return _v;
+}
+
+double
+get_target()
+{
+    static const double _v = config::get_sampling_overhead_target();
+    return _v;
+}
+
+const timer_state*
+find_timer(const thread_state& _state, int _signo)
+{
+    for(const auto& itr : _state.timers)
+        if(itr.signo == _signo && itr.period > 0) return &itr;
+    return nullptr;
+}
+
+void
+update_stride(thread_state& _state, uint64_t _now)
+{
+    auto _elapsed = _now - _state.window_beg;
+    if(_elapsed < window_nsec) return;
+
+    auto _overhead = static_cast<double>(_state.window_cost) / _elapsed;
+    // the handler time is roughly inversely proportional to the stride
+    auto _ideal =
+        std::min<double>(_state.stride * (_overhead / get_target()), max_stride);
+    auto _stride = _state.stride;
+    if(_ideal > _stride)
+        _stride = std::ceil(_ideal);
+    else if(_ideal < 0.5 * _stride)
+        _stride = std::ceil(1.25 * _ideal);  // leave some headroom when lowering
+
+    _state.stride      = std::clamp<uint32_t>(_stride, 1, max_stride);
+    _state.window_beg  = _now;
+    _state.window_cost = 0;
+
+    auto& _max = get_global_counters().max_stride;
+    auto  _cur = _max.load(std::memory_order_relaxed);
+    while(_state.stride > _cur &&
+          !_max.compare_exchange_weak(_cur, _state.stride, std::memory_order_relaxed))
+    {}
+}
+
+// invoked at the start of the wrapped handler. Returns whether the interrupt is sampled
+bool
+begin(int _signo, uint64_t _now)
+{
+    auto&       _state = get_thread_state();
+    const auto* _timer = find_timer(_state, _signo);
+
+    _state.in_handler = true;
+    _state.period     = (_timer) ? _timer->period : 0;
+    if(!_timer || !_state.enabled) return true;
+
+    _state.handler_beg = _now;
+    bool _sampled      = (--_state.countdown == 0);
+    if(_sampled)
+    {
+        _state.period    = _timer->period * _state.stride;
+        _state.countdown = _state.stride;
+    }
+
+    auto& _counters = get_global_counters();
+    _counters.interrupts.fetch_add(1, std::memory_order_relaxed);
+    if(_sampled) _counters.samples.fetch_add(1, std::memory_order_relaxed);
+
+    return _sampled;
+}
+
+// invoked at the end of the wrapped handler
+void
+end(int _signo)
+{
+    auto& _state      = get_thread_state();
+    _state.in_handler = false;
+    if(!_state.enabled || _state.handler_beg == 0 || !find_timer(_state, _signo)) return;
+
+    auto _now = tim::get_clock_real_now<uint64_t, std::nano>();
+    if(_now > _state.handler_beg) _state.window_cost += (_now - _state.handler_beg);
+    _state.handler_beg = 0;
+
+    update_stride(_state, _now);
+}
+
+// replaces the handler of the sampler for the CPU-time and real-time signals. The
+// skipped interrupts return before the sampler records a sample
+void
+execute(int _signo, siginfo_t* _info, void* _context)
+{
+    auto _chained = (_signo > 0 && _signo < NSIG)
+                        ? chained_handlers[_signo].load(std::memory_order_acquire)
+                        : nullptr;
+
+    if(begin(_signo, tim::get_clock_real_now<uint64_t, std::nano>()) && _chained)
+        (*_chained)(_signo, _info, _context);
+
+    end(_signo);
+}
+}  // namespace
+
+void
+rate_controller::configure(bool _setup, int64_t)
+{
+    auto& _state = get_thread_state();
+    if(!_setup)
+    {
+        _state.enabled = false;
+        return;
+    }
+
+    // the period of the timers is recorded for every sample even if the controller is
+    // disabled
+    _state           = thread_state{};
+    _state.timers[0] = { config::get_sampling_realtime_signal(),
+                         static_cast<uint64_t>(1.0e9 /
+                                               config::get_sampling_realtime_freq()) };
+    _state.timers[1] = { config::get_sampling_cputime_signal(),
+                         static_cast<uint64_t>(1.0e9 /
+                                               config::get_sampling_cputime_freq()) };
+    _state.window_beg = tim::get_clock_real_now<uint64_t, std::nano>();
+    _state.enabled    = (get_target() > 0.0);
+}
+
+bool
+rate_controller::is_enabled()
+{
+    return get_target() > 0.0;
+}
+
+uint64_t
+rate_controller::get_period(int _signo)
+{
+    const auto& _state = get_thread_state();
+    if(_state.in_handler) return _state.period;
+
+    // the handler of the sampler is not wrapped
+    const auto* _timer = find_timer(_state, _signo);
+    return (_timer) ? _timer->period : 0;
+}
+
+bool
+rate_controller::install(int _signo)
+{
+    auto& _state = get_thread_state();
+    if(!_state.enabled || !find_timer(_state, _signo)) return false;
+
+    struct sigaction _action = {};
+    if(_signo <= 0 || _signo >= NSIG || sigaction(_signo, nullptr, &_action) != 0 ||
+       (_action.sa_flags & SA_SIGINFO) == 0 || !_action.sa_sigaction)
+    {
+        ROCPROFSYS_VERBOSE(1,
+                           "[sampling] overhead controller: the handler of signal %i "
+                           "cannot be wrapped. Every interrupt is sampled\n",
+                           _signo);
+        _state.enabled = false;
+        return false;
+    }
+
+    // the sampler of each thread may re-install its handler
+    if(_action.sa_sigaction == &execute) return true;
+
+    chained_handlers[_signo].store(_action.sa_sigaction, std::memory_order_release);
+    _action.sa_sigaction = &execute;
+    if(sigaction(_signo, &_action, nullptr) != 0)
+    {
+        _state.enabled = false;
+        return false;
+    }
+    return true;
+}
+
+rate_controller::stats
+rate_controller::get_stats()
+{
+    const auto& _counters = get_global_counters();
+    return stats{ _counters.interrupts.load(), _counters.samples.load(),
+                  _counters.max_stride.load() };
+}
+}  // namespace sampling
+}  // namespace rocprofsys
@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <cstdint>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+/// Keeps the time spent in the sampling signal handler within
+/// ROCPROFSYS_SAMPLING_OVERHEAD_TARGET by adjusting the fraction of the timer interrupts
+/// of each thread which are sampled. The handler of the sampler is wrapped so that only
+/// every N-th interrupt (the stride) reaches the sampler and the remaining interrupts
+/// return after reading the clock, i.e. they do not record a sample
+struct rate_controller
+{
+    struct stats
+    {
+        uint64_t interrupts = 0;
+        uint64_t samples    = 0;
+        uint32_t max_stride = 1;
+    };
+
+    static void configure(bool _setup, int64_t _tid);
+    static bool is_enabled();
+
+    /// wraps the handler of the sampler for the signal of a timer. Invoked after the
+    /// sampler of the thread is configured. Returns false (and samples every interrupt
+    /// of the thread) if the controller is disabled or the handler cannot be wrapped
+    static bool install(int _signo);
+
+    /// effective sampling period (nsec) of the current interrupt, i.e. the period of the
+    /// timer times the stride. Zero if not a timer interrupt. Invoked within the handler
+    static uint64_t get_period(int _signo);
+
+    static stats get_stats();
+};
+}  // namespace sampling
+}  // namespace rocprofsys
@@ -0,0 +1,261 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/symbolizer.hpp"
+#include "binary/analysis.hpp"
+#include "binary/binary_info.hpp"
+#include "binary/symbol.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "library/components/backtrace.hpp"
+#include "library/ptl.hpp"
+
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/procfs/maps.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace symbolizer
+{
+namespace
+{
+using component::backtrace;
+
+void
+set_frame(frame& _frame, entry_type&& _entry)
+{
+    _frame.entry      = std::move(_entry);
+    _frame.entry.name = tim::demangle(backtrace::patch_label(_frame.entry.name));
+    _frame.use        = backtrace::use_label(_frame.entry.name);
+    _frame.resolved   = true;
+}
+
+// the DWARF line row of a symbol which contains the (file-relative) address. The rows
+// are sorted by address and converted into ranges by symbol::read_dwarf_entries
+const binary::dwarf_entry*
+find_dwarf_entry(const binary::symbol& _sym, uintptr_t _addr)
+{
+    const auto& _rows = _sym.dwarf_info;
+    auto        _itr  = std::upper_bound(
+        _rows.begin(), _rows.end(), _addr,
+        [](uintptr_t _lhs, const binary::dwarf_entry& _rhs) {
+            return _lhs < _rhs.address.low;
+        });
+
+    while(_itr != _rows.begin())
+    {
+        --_itr;
+        if(_itr->address.contains(_addr) && !_itr->file.empty()) return &(*_itr);
+        if(_itr->address.low < _addr) break;
+    }
+    return nullptr;
+}
+
+// resolves the program counters within the mappings of a single binary. The program
+// counters are sorted so each symbol is looked up (and demangled) in address order
+size_t
+resolve_module(const binary::binary_info& _info, frame_table& _table)
+{
+    const auto& _pcs = _table.pcs;
+
+    auto _symbols = std::vector<const binary::symbol*>{};
+    _symbols.reserve(_info.symbols.size());
+    for(const auto& itr : _info.symbols)
+        _symbols.emplace_back(&itr);
+
+    auto _symbol_cmp = [](uintptr_t _lhs, const binary::symbol* _rhs) {
+        return _lhs < _rhs->ipaddr().low;
+    };
+
+    std::sort(_symbols.begin(), _symbols.end(), [](const auto* _lhs, const auto* _rhs) {
+        return _lhs->ipaddr().low < _rhs->ipaddr().low;
+    });
+
+    auto   _names    = std::unordered_map<const binary::symbol*, std::string>{};
+    auto   _location = _info.filename();
+    size_t _count    = 0;
+    for(const auto& mitr : _info.mappings)
+    {
+        auto _beg = std::lower_bound(_pcs.begin(), _pcs.end(), mitr.load_address);
+        auto _end = std::upper_bound(_beg, _pcs.end(), mitr.last_address);
+        for(auto itr = _beg; itr != _end; ++itr)
+        {
+            auto _pc   = *itr;
+            auto _sitr =
+                std::upper_bound(_symbols.begin(), _symbols.end(), _pc, _symbol_cmp);
+
+            if(_sitr == _symbols.begin()) continue;
+
+            const auto* _sym   = *(--_sitr);
+            auto        _range = _sym->ipaddr();
+            if(!_range.contains(_pc)) continue;
+
+            auto _nitr = _names.find(_sym);
+            if(_nitr == _names.end())
+                _nitr =
+                    _names
+                        .emplace(_sym, tim::demangle(backtrace::patch_label(_sym->func)))
+                        .first;
+
+            auto& _frame          = _table.frames.at(std::distance(_pcs.begin(), itr));
+            _frame.entry.address  = _pc;
+            _frame.entry.offset   = _pc - _range.low;
+            _frame.entry.name     = _nitr->second;
+            _frame.entry.location = _location;
+            _frame.use            = backtrace::use_label(_frame.entry.name);
+            _frame.resolved       = true;
+            ++_count;
+
+            // the file and line of the program counter from the DWARF line table
+            if(const auto* _row = find_dwarf_entry(*_sym, _pc - _sym->load_address))
+            {
+                _frame.entry.location     = _row->file;
+                _frame.entry.lineno       = _row->line;
+                _frame.entry.line_address = _row->address.low + _sym->load_address;
+            }
+        }
+    }
+
+    return _count;
+}
+}  // namespace
+
+std::vector<frame_id_t>
+frame_table::get_stack(const pc_stack_t& _data) const
+{
+    auto _ids = std::vector<frame_id_t>{};
+    _ids.reserve(_data.size());
+    for(auto itr : _data)
+    {
+        auto _pos = std::lower_bound(pcs.begin(), pcs.end(), itr);
+        if(_pos == pcs.end() || *_pos != itr) continue;
+        auto _id = static_cast<frame_id_t>(std::distance(pcs.begin(), _pos));
+        if(frames.at(_id).resolved) _ids.emplace_back(_id);
+    }
+
+    // remove some known functions which are by-products of interrupts
+    static const auto _known_excludes =
+        std::set<std::string_view>{ "funlockfile", "killpg", "__restore_rt" };
+
+    size_t _top = 0;
+    while(_top < _ids.size() &&
+          _known_excludes.count(frames.at(_ids.at(_top)).entry.name) > 0)
+        ++_top;
+
+    // put the bottom of the call-stack on top and apply the filter
+    auto _stack = std::vector<frame_id_t>{};
+    _stack.reserve(_ids.size() - _top);
+    for(size_t i = _ids.size(); i > _top; --i)
+    {
+        auto _id  = _ids.at(i - 1);
+        auto _use = frames.at(_id).use;
+        if(_use == -1) break;
+        if(_use == 0) continue;
+        _stack.emplace_back(_id);
+    }
+
+    return _stack;
+}
+
+frame_table
+symbolize(std::vector<uintptr_t> _pcs)
+{
+    auto _beg = std::chrono::steady_clock::now();
+
+    std::sort(_pcs.begin(), _pcs.end());
+    _pcs.erase(std::unique(_pcs.begin(), _pcs.end()), _pcs.end());
+    _pcs.erase(std::remove(_pcs.begin(), _pcs.end(), uintptr_t{ 0 }), _pcs.end());
+
+    auto _table   = frame_table{};
+    _table.pcs    = std::move(_pcs);
+    _table.frames = std::vector<frame>(_table.pcs.size());
+
+    if(_table.pcs.empty()) return _table;
+
+    size_t _nmodules = 0;
+    size_t _nsymtab  = 0;
+
+    // the symbol tables and the DWARF line tables provide the file and line but not the
+    // inlined call-sites so, when requested, every program counter is resolved
+    // individually
+    if(!get_sampling_include_inlines())
+    {
+        // only the binaries which contain at least one program counter
+        auto _files = std::set<std::string>{};
+        for(const auto& itr : tim::procfs::read_maps(process::get_id()))
+        {
+            if(itr.pathname.empty() || itr.pathname.front() != '/') continue;
+            auto _pos = std::lower_bound(_table.pcs.begin(), _table.pcs.end(),
+                                         itr.load_address);
+            if(_pos != _table.pcs.end() && *_pos <= itr.last_address)
+                _files.emplace(itr.pathname);
+        }
+
+        auto _info = binary::get_binary_info(
+            std::vector<std::string>(_files.begin(), _files.end()), {}, true, false,
+            false);
+        _nmodules  = _info.size();
+
+        // each module resolves a disjoint set of program counters
+        auto  _counts = std::vector<size_t>(_info.size(), 0);
+        auto& _tg     = tasking::general::get_task_group();
+        for(size_t i = 0; i < _info.size(); ++i)
+            _tg.exec([i, &_info, &_table, &_counts]() {
+                _counts.at(i) = resolve_module(_info.at(i), _table);
+            });
+        _tg.join();
+
+        for(auto itr : _counts)
+            _nsymtab += itr;
+    }
+
+    // anything not found in the symbol tables (e.g. stripped or unloaded binaries)
+    for(size_t i = 0; i < _table.size(); ++i)
+    {
+        auto& _frame = _table.frames.at(i);
+        if(_frame.resolved) continue;
+        auto _entry = binary::lookup_ipaddr_entry<false>(_table.pcs.at(i));
+        if(_entry) set_frame(_frame, std::move(*_entry));
+    }
+
+    ROCPROFSYS_VERBOSE(1 || get_debug_sampling(),
+                       "[sampling] Symbolized %zu unique program counters (%zu from the "
+                       "symbol tables of %zu binaries) in %.3f sec\n",
+                       _table.size(), _nsymtab, _nmodules,
+                       std::chrono::duration<double>{ std::chrono::steady_clock::now() -
+                                                      _beg }
+                           .count());
+
+    return _table;
+}
+}  // namespace symbolizer
+}  // namespace rocprofsys
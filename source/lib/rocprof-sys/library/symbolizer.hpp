@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+#include "library/components/backtrace.hpp"
+
+#include <timemory/unwind/processed_entry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace symbolizer
+{
+using frame_id_t = uint32_t;
+using entry_type = tim::unwind::processed_entry;
+using pc_stack_t = component::backtrace::data_t;
+
+// a symbolized program counter. The name is patched and demangled once per symbol and
+// the use value is the result of component::backtrace::use_label for that name
+struct frame
+{
+    entry_type  entry    = {};
+    const char* label    = nullptr;  // persistent copy of entry.name (set by consumer)
+    short       use      = 0;        // -1 means truncate, 0 means skip, 1 means keep
+    bool        resolved = false;
+};
+
+// symbolized set of unique program counters: frames.at(i) corresponds to pcs.at(i) so
+// the index of a program counter in the sorted pcs is its frame id
+struct frame_table
+{
+    std::vector<uintptr_t> pcs    = {};
+    std::vector<frame>     frames = {};
+
+    size_t       size() const { return pcs.size(); }
+    const frame& at(frame_id_t _v) const { return frames.at(_v); }
+    frame&       at(frame_id_t _v) { return frames.at(_v); }
+
+    // converts the raw call-stack of a sample (top of the call-stack first) into the
+    // frame ids of the filtered and patched call-stack (bottom of the call-stack first)
+    std::vector<frame_id_t> get_stack(const pc_stack_t&) const;
+};
+
+// resolves all the (unique) program counters of the samples at once, in parallel per
+// module, against the symbol tables of the loaded binaries
+frame_table
+symbolize(std::vector<uintptr_t>);
+}  // namespace symbolizer
+}  // namespace rocprofsys
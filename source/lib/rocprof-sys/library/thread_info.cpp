@@ -26,6 +26,7 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/state.hpp"
+#include "core/timestamp.hpp"
 #include "core/utility.hpp"
 #include "library/causal/delay.hpp"
 #include "library/runtime.hpp"
@@ -191,7 +192,7 @@ thread_info::init(bool _offset)
         _info                 = thread_info{};
         _info->is_offset      = threading::offset_this_id();
         _info->index_data     = init_index_data(_tid, _info->is_offset);
-        _info->lifetime.first = tim::get_clock_real_now<uint64_t, std::nano>();
+        _info->lifetime.first = timestamp::now();
 
         const auto _sequent_tid = _info->index_data->sequent_value;
         _info->causal_count     = (!_info->is_offset && _sequent_tid < peak_num_threads)
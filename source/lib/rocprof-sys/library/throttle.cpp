@@ -0,0 +1,274 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/throttle.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "core/timestamp.hpp"
+
+#include <timemory/manager.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace throttle
+{
+std::atomic<bool> active = { false };
+
+namespace
+{
+uint64_t throttle_count = 0;
+uint64_t throttle_nsec  = 0;
+uint64_t publish_count  = 1;
+
+// a call which was started
+struct frame
+{
+    entry*   function  = nullptr;
+    uint64_t timestamp = 0;
+};
+
+// constant-initialized so that the thread-local access does not need a guard
+struct thread_stack
+{
+    frame*   data     = nullptr;
+    uint32_t size     = 0;
+    uint32_t capacity = 0;
+};
+
+thread_local thread_stack tl_stack = {};
+
+// calls of a function which were measured by this thread but not published to the
+// shared entry yet. The slots are direct-mapped by the address of the entry and a
+// collision publishes the calls of the previous function
+struct pending_calls
+{
+    entry*   function = nullptr;
+    uint64_t count    = 0;
+    uint64_t nsec     = 0;
+};
+
+constexpr size_t pending_size = 256;
+
+thread_local pending_calls tl_pending[pending_size] = {};
+
+auto&
+get_entries()
+{
+    static auto* _v = new std::unordered_map<std::string, std::unique_ptr<entry>>{};
+    return *_v;
+}
+
+auto&
+get_entries_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+ROCPROFSYS_NOINLINE void
+throttle(entry* _v, uint64_t _count, uint64_t _nsec)
+{
+    if(_v->throttled.exchange(true, std::memory_order_relaxed)) return;
+    ROCPROFSYS_VERBOSE_F(2,
+                         "[throttle] '%s' is throttled after %lu calls (%.1f nsec per "
+                         "call)...\n",
+                         _v->name.data(), static_cast<unsigned long>(_count),
+                         static_cast<double>(_nsec) / _count);
+}
+
+ROCPROFSYS_NOINLINE void
+publish(pending_calls& _calls)
+{
+    auto* _v     = _calls.function;
+    auto  _count = _v->count.fetch_add(_calls.count, std::memory_order_relaxed) +
+                  _calls.count;
+    auto _total =
+        _v->nsec.fetch_add(_calls.nsec, std::memory_order_relaxed) + _calls.nsec;
+    _calls.count = 0;
+    _calls.nsec  = 0;
+    if(_count >= throttle_count && _total < _count * throttle_nsec)
+        throttle(_v, _count, _total);
+}
+
+ROCPROFSYS_INLINE void
+record(entry* _v, uint64_t _nsec)
+{
+    auto& _calls = tl_pending[(reinterpret_cast<uintptr_t>(_v) >> 4) % pending_size];
+    if(ROCPROFSYS_UNLIKELY(_calls.function != _v))
+    {
+        if(_calls.count > 0) publish(_calls);
+        _calls.function = _v;
+    }
+
+    _calls.nsec += _nsec;
+    if(++_calls.count >= publish_count) publish(_calls);
+}
+
+ROCPROFSYS_NOINLINE bool
+grow(thread_stack& _stack)
+{
+    // every thread which records a call grows its stack first so the frames are freed
+    // and the pending calls are published here when the thread exits
+    static thread_local auto _thread_dtor = scope::destructor{ []() {
+        for(auto& itr : tl_pending)
+            if(itr.count > 0) publish(itr);
+        free(tl_stack.data);
+        tl_stack = thread_stack{};
+    } };
+    (void) _thread_dtor;
+
+    auto  _capacity = std::max<uint32_t>(64, 2 * _stack.capacity);
+    auto* _data = static_cast<frame*>(realloc(_stack.data, _capacity * sizeof(frame)));
+    if(!_data) return false;
+    _stack.data     = _data;
+    _stack.capacity = _capacity;
+    return true;
+}
+
+struct throttled_function
+{
+    std::string name  = {};
+    uint64_t    calls = 0;
+    double      nsec  = 0.0;  // average duration per call
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        ar(tim::cereal::make_nvp("name", name), tim::cereal::make_nvp("calls", calls),
+           tim::cereal::make_nvp("mean_nsec", nsec));
+    }
+};
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_use_throttle()) return;
+
+    throttle_count = std::max<uint64_t>(config::get_throttle_count(), 1);
+    throttle_nsec  = config::get_throttle_value();
+    publish_count  = std::min<uint64_t>(throttle_count, 64);
+
+    ROCPROFSYS_VERBOSE_F(1,
+                         "[throttle] Throttling instrumented functions after %lu calls "
+                         "with an average duration below %lu nsec...\n",
+                         static_cast<unsigned long>(throttle_count),
+                         static_cast<unsigned long>(throttle_nsec));
+    active.store(true, std::memory_order_relaxed);
+}
+
+entry*
+get_entry(std::string_view _name)
+{
+    auto  _lk  = std::unique_lock<std::mutex>{ get_entries_mutex() };
+    auto& _reg = get_entries();
+    auto  itr  = _reg.find(std::string{ _name });
+    if(itr == _reg.end())
+    {
+        itr               = _reg.emplace(std::string{ _name }, new entry{}).first;
+        itr->second->name = itr->first;
+    }
+    return itr->second.get();
+}
+
+bool
+enter(entry* _v)
+{
+    if(_v->throttled.load(std::memory_order_relaxed)) return false;
+
+    // without a frame the exit is only decided by whether the function is throttled
+    auto& _stack = tl_stack;
+    if(ROCPROFSYS_UNLIKELY(_stack.size == _stack.capacity) && !grow(_stack)) return true;
+    _stack.data[_stack.size++] = frame{ _v, timestamp::now() };
+    return true;
+}
+
+// a frame of a throttled function was started before the function was throttled. When
+// recursive calls were skipped in the meantime, the first skipped exit closes the frame
+// and the region early, which keeps the regions of the thread balanced
+bool
+exit(entry* _v)
+{
+    auto& _stack = tl_stack;
+    if(ROCPROFSYS_LIKELY(_stack.size > 0) && _stack.data[_stack.size - 1].function == _v)
+    {
+        auto _beg = _stack.data[--_stack.size].timestamp;
+        if(!_v->throttled.load(std::memory_order_relaxed))
+            record(_v, timestamp::now() - _beg);
+        return true;
+    }
+    return !_v->throttled.load(std::memory_order_relaxed);
+}
+
+void
+post_process()
+{
+    if(!is_active()) return;
+
+    auto _data = std::vector<throttled_function>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_entries_mutex() };
+        for(const auto& itr : get_entries())
+        {
+            const auto& _v = *itr.second;
+            if(!_v.throttled.load()) continue;
+            auto _count = _v.count.load();
+            _data.emplace_back(throttled_function{
+                itr.first, _count, static_cast<double>(_v.nsec.load()) / _count });
+        }
+    }
+
+    if(_data.empty()) return;
+
+    std::sort(_data.begin(), _data.end(),
+              [](const throttled_function& _lhs, const throttled_function& _rhs) {
+                  // most calls first
+                  return std::tie(_rhs.calls, _lhs.name) <
+                         std::tie(_lhs.calls, _rhs.name);
+              });
+
+    ROCPROFSYS_VERBOSE_F(0, "[throttle] %zu instrumented functions were throttled...\n",
+                         _data.size());
+    for(const auto& itr : _data)
+    {
+        ROCPROFSYS_VERBOSE_F(1, "[throttle]    %-12lu calls  %10.1f nsec  %s\n",
+                             static_cast<unsigned long>(itr.calls), itr.nsec,
+                             itr.name.c_str());
+    }
+
+    tim::manager::instance()->add_metadata([_data](auto& ar) {
+        ar(tim::cereal::make_nvp("throttled_functions", _data));
+    });
+}
+}  // namespace throttle
+}  // namespace rocprofsys
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace rocprofsys
+{
+namespace throttle
+{
+// the state of an instrumented function which is shared by all threads. The entries
+// are never deallocated. The counters are published by the threads in batches and are
+// kept off the cache line of the flag which is read on every call
+struct entry
+{
+    std::atomic<bool> throttled = { false };
+    std::string_view  name      = {};
+
+    // calls measured before throttling and their total duration
+    alignas(64) std::atomic<uint64_t> count = { 0 };
+    std::atomic<uint64_t>             nsec  = { 0 };
+};
+
+extern ROCPROFSYS_HIDDEN_API std::atomic<bool> active;
+
+// starts measuring the calls of the instrumented functions
+void
+setup();
+
+// reports the throttled functions and adds them to the metadata
+void
+post_process();
+
+ROCPROFSYS_INLINE bool
+is_active()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+// the entry of a function name
+entry*
+get_entry(std::string_view _name);
+
+// returns false when the function is throttled, i.e. the region should not be started
+bool
+enter(entry* _v) ROCPROFSYS_HOT;
+
+// returns false when the region of the matching entry was not started
+bool
+exit(entry* _v) ROCPROFSYS_HOT;
+}  // namespace throttle
+}  // namespace rocprofsys
@@ -129,7 +129,7 @@ record_thread_start_time()
 {
     static thread_local std::once_flag _once{};
     std::call_once(_once, []() {
-        thread_info::set_start(comp::wall_clock::record(), get_mode() != Mode::Sampling);
+        thread_info::set_start(tracing::now(), get_mode() != Mode::Sampling);
     });
 }
 
@@ -31,6 +31,7 @@
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
+#include "core/timestamp.hpp"
 #include "core/utility.hpp"
 #include "library/causal/sampling.hpp"
 #include "library/runtime.hpp"
@@ -62,6 +63,11 @@
 
 namespace rocprofsys
 {
+namespace throttle
+{
+struct entry;
+}  // namespace throttle
+
 namespace tracing
 {
 using interval_data_instances           = thread_data<std::vector<bool>>;
@@ -74,6 +80,16 @@ using perfetto_annotate_component_types = tim::mpl::available_t<type_list<
     comp::thread_cpu_clock, comp::thread_cpu_util, comp::user_clock, comp::user_mode_time,
     comp::virtual_memory>>;
 
+// name of a region which was registered ahead of time (see rocprofsys_register_region)
+// so that pushing and popping the region does not require hashing the name. The
+// throttle entry is only used by the instrumented functions
+struct region_handle
+{
+    hash_value_t     hash           = 0;
+    std::string_view name           = {};
+    throttle::entry* throttle_entry = nullptr;
+};
+
 //
 //  declarations
 //
@@ -190,7 +206,7 @@ template <typename Tp = uint64_t>
 ROCPROFSYS_INLINE auto
 now()
 {
-    return ::tim::get_clock_real_now<Tp, std::nano>();
+    return static_cast<Tp>(timestamp::now());
 }
 
 inline auto&
@@ -281,7 +297,7 @@ profile_pop_disabled()
 
 template <typename CategoryT, typename... Args>
 inline void
-push_timemory(CategoryT, std::string_view name, Args&&... args)
+push_timemory(CategoryT, hash_value_t _hash, Args&&... args)
 {
     // skip if category is disabled
     if(category_push_disabled<CategoryT>()) return;
@@ -289,28 +305,36 @@ push_timemory(CategoryT, std::string_view name, Args&&... args)
     auto& _data = tracing::get_instrumentation_bundles();
     if(ROCPROFSYS_LIKELY(_data != nullptr))
     {
-        // this generates a hash for the raw string array
-        auto _hash = tim::add_hash_id(name);
         _data->construct(_hash)->start(std::forward<Args>(args)...);
         // increment the profile stack
         ++get_profile_stack<CategoryT>();
     }
 }
 
+template <typename CategoryT, typename... Args>
+inline void
+push_timemory(CategoryT, std::string_view name, Args&&... args)
+{
+    // skip if category is disabled
+    if(category_push_disabled<CategoryT>()) return;
+
+    // this generates a hash for the raw string array
+    push_timemory(CategoryT{}, tim::add_hash_id(name), std::forward<Args>(args)...);
+}
+
 template <typename CategoryT>
 inline std::pair<instrumentation_bundle_t*, size_t>
-get_timemory(CategoryT, std::string_view name)
+get_timemory(CategoryT, hash_value_t _hash)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto  _hash = tim::hash::get_hash_id(name);
     auto& _data = tracing::get_instrumentation_bundles();
     if(ROCPROFSYS_UNLIKELY(_data == nullptr || _data->empty()))
     {
-        ROCPROFSYS_DEBUG("[%s] skipped %s :: empty bundle stack\n",
-                         "rocprofsys_pop_trace", name.data());
+        ROCPROFSYS_DEBUG("[%s] skipped %zu :: empty bundle stack\n",
+                         "rocprofsys_pop_trace", static_cast<size_t>(_hash));
         return return_type{ nullptr, -1 };
     }
 
@@ -334,16 +358,27 @@ get_timemory(CategoryT, std::string_view name)
     return return_type{ nullptr, -1 };
 }
 
-template <typename CategoryT, typename... Args>
+template <typename CategoryT>
+inline std::pair<instrumentation_bundle_t*, size_t>
+get_timemory(CategoryT, std::string_view name)
+{
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+    // skip if category is disabled and not pushed on this thread
+    if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
+
+    return get_timemory(CategoryT{}, tim::hash::get_hash_id(name));
+}
+
+template <typename CategoryT, typename KeyT, typename... Args>
 inline auto
-stop_timemory(CategoryT, std::string_view name, Args&&... args)
+stop_timemory(CategoryT, KeyT _key, Args&&... args)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
 
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto&& _data = get_timemory(CategoryT{}, name);
+    auto&& _data = get_timemory(CategoryT{}, _key);
     if(_data.first)
     {
         _data.first->stop(std::forward<Args>(args)...);
@@ -362,6 +397,17 @@ destroy_timemory(std::pair<instrumentation_bundle_t*, size_t> _data)
     }
 }
 
+template <typename CategoryT, typename... Args>
+inline void
+pop_timemory(CategoryT, hash_value_t _hash, Args&&... args)
+{
+    // skip if category is disabled and not pushed on this thread
+    if(profile_pop_disabled<CategoryT>()) return;
+
+    auto _data = stop_timemory(CategoryT{}, _hash, std::forward<Args>(args)...);
+    if(_data.first) destroy_timemory(std::move(_data));
+}
+
 template <typename CategoryT, typename... Args>
 inline void
 pop_timemory(CategoryT, std::string_view name, Args&&... args)
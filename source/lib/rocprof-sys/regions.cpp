@@ -23,9 +23,22 @@
 #include "api.hpp"
 #include "core/categories.hpp"
 #include "core/config.hpp"
+#include "dl/trace_id.hpp"
 #include "library/components/category_region.hpp"
+#include "library/event_log.hpp"
+#include "library/throttle.hpp"
 #include "library/tracing.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #if defined(__GNUC__) && (__GNUC__ == 7)
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
@@ -37,6 +50,121 @@ namespace impl
 {
 namespace
 {
+// handles are the addresses of these entries so they are never deallocated
+auto&
+get_region_registry()
+{
+    static auto* _v =
+        new std::unordered_map<tim::hash_value_t, const tracing::region_handle*>{};
+    return *_v;
+}
+
+auto&
+get_region_registry_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+inline const tracing::region_handle*
+get_region_handle(uint64_t _handle)
+{
+    return reinterpret_cast<const tracing::region_handle*>(_handle);
+}
+
+// requires holding the region registry mutex
+const tracing::region_handle*
+add_region_handle(const char* name)
+{
+    auto  _hash = tim::add_hash_id(name);
+    auto& _reg  = get_region_registry();
+    auto  itr   = _reg.find(_hash);
+    if(itr == _reg.end())
+    {
+        auto  _name  = tim::get_hash_identifier_fast(_hash);
+        auto* _entry =
+            new tracing::region_handle{ _hash, _name, throttle::get_entry(_name) };
+        itr = _reg.emplace(_hash, _entry).first;
+    }
+    return itr->second;
+}
+
+// direct-mapped per-thread cache of the address of an instrumented function name to
+// its region handle so that the name path of the throttling does not hash the name.
+// The name of a library which was unloaded and the name of a library loaded later may
+// have the same address so a hit is confirmed against the name of the handle
+struct name_cache_entry
+{
+    const char*                   name   = nullptr;
+    const tracing::region_handle* handle = nullptr;
+};
+
+constexpr size_t name_cache_size = 256;
+
+thread_local name_cache_entry tl_name_cache[name_cache_size] = {};
+
+ROCPROFSYS_NOINLINE const tracing::region_handle*
+cache_region_handle(name_cache_entry& _entry, const char* name)
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_region_registry_mutex() };
+    _entry   = name_cache_entry{ name, add_region_handle(name) };
+    return _entry.handle;
+}
+
+inline const tracing::region_handle*
+find_region_handle(const char* name)
+{
+    auto& _entry =
+        tl_name_cache[(reinterpret_cast<uintptr_t>(name) >> 3) % name_cache_size];
+    if(ROCPROFSYS_LIKELY(_entry.name == name &&
+                         strcmp(name, _entry.handle->name.data()) == 0))
+        return _entry.handle;
+    return cache_region_handle(_entry, name);
+}
+
+// function ids assigned by rocprof-sys-instrument: the upper bits identify the
+// instrumented binary and select a table which is indexed by the lower bits
+using dl::trace_id_index_bits;
+constexpr uint32_t trace_id_index_mask = dl::trace_id_index_max - 1;
+constexpr size_t   trace_id_num_tables = (1UL << (32 - trace_id_index_bits));
+
+struct trace_id_entry
+{
+    std::atomic<const tracing::region_handle*> handle = {};
+};
+
+struct trace_id_table
+{
+    using entry_type = trace_id_entry;
+
+    explicit trace_id_table(uint32_t _n)
+    : size{ _n }
+    , entries{ new entry_type[_n]{} }
+    {}
+
+    uint32_t                      size    = 0;
+    std::unique_ptr<entry_type[]> entries = {};
+};
+
+// tables are never deallocated so the lookup does not need to synchronize with the
+// registration beyond the atomic loads
+auto&
+get_trace_id_tables()
+{
+    static auto* _v = new std::array<std::atomic<trace_id_table*>, trace_id_num_tables>{};
+    return *_v;
+}
+
+inline const trace_id_entry*
+get_trace_id_entry(uint32_t _id)
+{
+    const auto* _table =
+        get_trace_id_tables()[_id >> trace_id_index_bits].load(std::memory_order_acquire);
+    const auto _idx = (_id & trace_id_index_mask);
+    if(ROCPROFSYS_UNLIKELY(!_table || _idx >= _table->size)) return nullptr;
+    return &_table->entries[_idx];
+}
+
 template <size_t Idx, size_t... Tail>
 void
 invoke_category_region_start(rocprofsys_category_t _category, const char* name,
@@ -115,13 +243,142 @@ invoke_category_region_stop(rocprofsys_category_t _category, const char* name,
 extern "C" void
 rocprofsys_push_trace_hidden(const char* name)
 {
-    rocprofsys::component::category_region<rocprofsys::category::host>::start(name);
+    // the handle is only looked up when it is needed for the throttling
+    const rocprofsys::tracing::region_handle* _handle = nullptr;
+    if(rocprofsys::throttle::is_active())
+    {
+        _handle = rocprofsys::impl::find_region_handle(name);
+        if(!rocprofsys::throttle::enter(_handle->throttle_entry)) return;
+    }
+
+    if(rocprofsys::event_log::is_active())
+    {
+        rocprofsys::event_log::enter(name);
+        return;
+    }
+
+    if(_handle)
+        rocprofsys::component::category_region<rocprofsys::category::host>::start(
+            *_handle);
+    else
+        rocprofsys::component::category_region<rocprofsys::category::host>::start(name);
 }
 
 extern "C" void
 rocprofsys_pop_trace_hidden(const char* name)
 {
-    rocprofsys::component::category_region<rocprofsys::category::host>::stop(name);
+    // the handle is only looked up when it is needed for the throttling
+    const rocprofsys::tracing::region_handle* _handle = nullptr;
+    if(rocprofsys::throttle::is_active())
+    {
+        _handle = rocprofsys::impl::find_region_handle(name);
+        if(!rocprofsys::throttle::exit(_handle->throttle_entry)) return;
+    }
+
+    if(rocprofsys::event_log::is_active())
+    {
+        rocprofsys::event_log::exit(name);
+        return;
+    }
+
+    if(_handle)
+        rocprofsys::component::category_region<rocprofsys::category::host>::stop(
+            *_handle);
+    else
+        rocprofsys::component::category_region<rocprofsys::category::host>::stop(name);
+}
+
+extern "C" void
+rocprofsys_register_trace_ids_hidden(uint32_t* _base, uint32_t _count, const char* names)
+{
+    using namespace rocprofsys::impl;
+
+    if(!_base || !names || _count == 0) return;
+
+    auto& _mtx = get_region_registry_mutex();
+    auto  _lk  = std::unique_lock<std::mutex>{ _mtx };
+
+    // the tags are assigned in the order of the registration and a binary which is
+    // registered again, e.g. when it is reopened, is assigned the same tag
+    static auto* _tags = new std::unordered_map<std::string, uint32_t>{};
+    auto         itr   = _tags->find(names);
+    if(itr != _tags->end())
+    {
+        *_base = (itr->second << trace_id_index_bits);
+        return;
+    }
+
+    auto _tag = static_cast<uint32_t>(_tags->size() + 1);
+    if(_tag >= trace_id_num_tables || _count > rocprofsys::dl::trace_id_index_max)
+    {
+        ROCPROFSYS_WARNING_F(0,
+                             "the function ids of %u instrumented functions could not be "
+                             "registered and these functions are not traced\n",
+                             _count);
+        return;
+    }
+
+    auto* _v = new trace_id_table{ _count };
+    auto  _n = uint32_t{ 0 };
+    for(const char* _beg = names; *_beg != '\0' && _n < _count; ++_n)
+    {
+        const char* _end   = strchr(_beg, '\n');
+        auto        _name  = (_end) ? std::string{ _beg, _end } : std::string{ _beg };
+        const auto* _entry = add_region_handle(_name.c_str());
+        _v->entries[_n].handle.store(_entry, std::memory_order_relaxed);
+        if(!_end) break;
+        _beg = _end + 1;
+    }
+
+    _tags->emplace(names, _tag);
+    get_trace_id_tables()[_tag].store(_v, std::memory_order_release);
+    *_base = (_tag << trace_id_index_bits);
+
+    ROCPROFSYS_VERBOSE_F(2, "Registered %u function ids with the id base %u\n", _count,
+                         *_base);
+}
+
+// ids of binaries which are not registered yet have a zero tag and are ignored
+extern "C" void
+rocprofsys_push_trace_id_hidden(uint32_t _id)
+{
+    const auto* _entry = rocprofsys::impl::get_trace_id_entry(_id);
+    if(!_entry) return;
+
+    const auto* _handle = _entry->handle.load(std::memory_order_acquire);
+    if(!_handle) return;
+
+    if(rocprofsys::throttle::is_active() &&
+       !rocprofsys::throttle::enter(_handle->throttle_entry))
+        return;
+
+    if(rocprofsys::event_log::is_active())
+    {
+        rocprofsys::event_log::enter(_handle->name.data());
+        return;
+    }
+    rocprofsys::component::category_region<rocprofsys::category::host>::start(*_handle);
+}
+
+extern "C" void
+rocprofsys_pop_trace_id_hidden(uint32_t _id)
+{
+    const auto* _entry = rocprofsys::impl::get_trace_id_entry(_id);
+    if(!_entry) return;
+
+    const auto* _handle = _entry->handle.load(std::memory_order_acquire);
+    if(!_handle) return;
+
+    if(rocprofsys::throttle::is_active() &&
+       !rocprofsys::throttle::exit(_handle->throttle_entry))
+        return;
+
+    if(rocprofsys::event_log::is_active())
+    {
+        rocprofsys::event_log::exit(_handle->name.data());
+        return;
+    }
+    rocprofsys::component::category_region<rocprofsys::category::host>::stop(*_handle);
 }
 
 //======================================================================================//
@@ -148,6 +405,39 @@ rocprofsys_pop_region_hidden(const char* name)
 ///
 //======================================================================================//
 
+extern "C" uint64_t
+rocprofsys_register_region_hidden(const char* name)
+{
+    if(!name) return 0;
+
+    auto& _mtx = rocprofsys::impl::get_region_registry_mutex();
+    auto  _lk  = std::unique_lock<std::mutex>{ _mtx };
+
+    return reinterpret_cast<uint64_t>(rocprofsys::impl::add_region_handle(name));
+}
+
+extern "C" void
+rocprofsys_push_region_h_hidden(uint64_t _handle)
+{
+    if(_handle == 0) return;
+    rocprofsys::component::category_region<rocprofsys::category::user>::start(
+        *rocprofsys::impl::get_region_handle(_handle));
+}
+
+extern "C" void
+rocprofsys_pop_region_h_hidden(uint64_t _handle)
+{
+    if(_handle == 0) return;
+    rocprofsys::component::category_region<rocprofsys::category::user>::stop(
+        *rocprofsys::impl::get_region_handle(_handle));
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
 extern "C" void
 rocprofsys_push_category_region_hidden(rocprofsys_category_t _category, const char* name,
                                        rocprofsys_annotation_t* _annotations,
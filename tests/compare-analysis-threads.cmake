@@ -0,0 +1,63 @@
+# -------------------------------------------------------------------------------------- #
+#
+# rewrites a binary with serial (-j 1) and concurrent (-j N) function analysis and
+# verifies that the lists of instrumented and excluded functions are identical
+#
+# usage: cmake -DINSTRUMENT_EXE=<exe> -DTARGET_EXE=<exe> -DOUTPUT_DIR=<dir>
+# -DNUM_THREADS=<N> -P compare-analysis-threads.cmake
+#
+# -------------------------------------------------------------------------------------- #
+
+cmake_minimum_required(VERSION 3.16 FATAL_ERROR)
+
+foreach(_VAR INSTRUMENT_EXE TARGET_EXE OUTPUT_DIR NUM_THREADS)
+    if(NOT DEFINED ${_VAR})
+        message(FATAL_ERROR "${_VAR} must be defined")
+    endif()
+endforeach()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+foreach(_NTHREADS 1 ${NUM_THREADS})
+    execute_process(
+        COMMAND
+            ${INSTRUMENT_EXE} -o ${OUTPUT_DIR}/analysis-threads-${_NTHREADS}.inst
+            -e -v 1 --min-instructions=8 -j ${_NTHREADS} --print-instrumented functions
+            --print-excluded functions -- ${TARGET_EXE}
+        RESULT_VARIABLE _RET
+        OUTPUT_VARIABLE _OUT
+        ERROR_VARIABLE _ERR)
+
+    if(NOT _RET EQUAL 0)
+        message(FATAL_ERROR "rewrite with -j ${_NTHREADS} failed (${_RET}):\n${_ERR}")
+    endif()
+
+    # keep only the lines of the --print-instrumented and --print-excluded lists
+    string(REPLACE ";" "\\;" _OUT "${_OUT}")
+    string(REPLACE "\n" ";" _LINES "${_OUT}")
+    list(FILTER _LINES INCLUDE REGEX "^\\[(instrumented|excluded)\\] ")
+    list(LENGTH _LINES _NLINES)
+
+    if(_NLINES EQUAL 0)
+        message(FATAL_ERROR "rewrite with -j ${_NTHREADS} did not print any functions")
+    endif()
+
+    string(REPLACE ";" "\n" _LIST "${_LINES}")
+    file(WRITE ${OUTPUT_DIR}/analysis-threads-${_NTHREADS}.txt "${_LIST}\n")
+    message(STATUS "-j ${_NTHREADS}: ${_NLINES} lines of instrumented/excluded functions")
+endforeach()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT_DIR}/analysis-threads-1.txt
+            ${OUTPUT_DIR}/analysis-threads-${NUM_THREADS}.txt RESULT_VARIABLE _RET)
+
+if(NOT _RET EQUAL 0)
+    message(
+        FATAL_ERROR
+            "the functions instrumented/excluded with -j 1 and -j ${NUM_THREADS} differ. "
+            "See ${OUTPUT_DIR}/analysis-threads-1.txt and "
+            "${OUTPUT_DIR}/analysis-threads-${NUM_THREADS}.txt")
+endif()
+
+message(
+    STATUS "the functions instrumented/excluded with -j 1 and -j ${NUM_THREADS} match")
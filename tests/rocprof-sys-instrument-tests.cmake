@@ -52,3 +52,112 @@ rocprofiler_systems_add_test(
     ENVIRONMENT
         "${_lock_environment};ROCPROFSYS_FLAT_PROFILE=ON;ROCPROFSYS_PROFILE=OFF;ROCPROFSYS_TRACE=ON;ROCPROFSYS_SAMPLING_KEEP_INTERNAL=OFF"
     )
+
+# fib is small and dominates the self time so it is excluded from the instrumentation
+file(
+    WRITE ${CMAKE_CURRENT_BINARY_DIR}/parallel-overhead.folded
+    "main;run 50000000
+main;run;fib 2000000000
+")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME parallel-overhead-profile
+    TARGET parallel-overhead
+    LABELS "profile"
+    REWRITE_ARGS
+        -e
+        -v
+        2
+        --min-instructions=8
+        --profile
+        ${CMAKE_CURRENT_BINARY_DIR}/parallel-overhead.folded
+        --profile-overhead
+        5
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment}"
+    REWRITE_PASS_REGEX
+        "\\[profile\\] excluding 'fib'.*Projected instrumentation overhead: [0-4]\\.[0-9]+%"
+    REWRITE_RUN_FAIL_REGEX "(${ROCPROFSYS_ABORT_FAIL_REGEX})")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME parallel-overhead-event-log
+    TARGET parallel-overhead
+    LABELS "event-log"
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_EVENT_LOG=ON;ROCPROFSYS_VERBOSE=1;ROCPROFSYS_COUT_OUTPUT=ON"
+    REWRITE_RUN_PASS_REGEX
+        "\\[event_log\\] Converted [1-9][0-9]* records from [1-9][0-9]* threads into [1-9][0-9]* regions(.*)>>> ([ \\|_]*)run(.*)>>> ([ \\|_]*)fib"
+    REWRITE_RUN_FAIL_REGEX "(${ROCPROFSYS_ABORT_FAIL_REGEX})")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME parallel-overhead-throttle
+    TARGET parallel-overhead
+    LABELS "throttle"
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_THROTTLE=ON;ROCPROFSYS_THROTTLE_COUNT=1000;ROCPROFSYS_THROTTLE_VALUE=100000"
+    REWRITE_RUN_PASS_REGEX
+        "\\[throttle\\] [1-9][0-9]* instrumented functions were throttled(.*)\\[throttle\\] +[1-9][0-9][0-9][0-9][0-9]* calls +[0-9.]+ nsec +fib"
+    REWRITE_RUN_FAIL_REGEX
+        "rocprofsys_push_trace was called more times than rocprofsys_pop_trace|ROCPROFSYS_ABORT_FAIL_REGEX"
+    )
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME rewrite-caller-trace-ids
+    TARGET rewrite-caller
+    LABELS "caller-include;trace-ids"
+    REWRITE_ARGS
+        -e
+        -i
+        256
+        --caller-include
+        "^inner"
+        -v
+        2
+        --trace-ids
+    RUN_ARGS 17
+    ENVIRONMENT "${_base_environment};ROCPROFSYS_COUT_OUTPUT=ON"
+    REWRITE_PASS_REGEX "Registering [1-9][0-9]* function ids in the initialization"
+    REWRITE_RUN_PASS_REGEX ">>> ._outer ([ \\|]+) 17"
+    REWRITE_RUN_FAIL_REGEX "(${ROCPROFSYS_ABORT_FAIL_REGEX})")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME parallel-overhead-analysis-threads
+    TARGET parallel-overhead
+    LABELS "analysis-threads"
+    REWRITE_ARGS -e -v 2 --min-instructions=8 -j 4
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment}"
+    REWRITE_PASS_REGEX
+        "\\[analysis\\] filtering [1-9][0-9]* functions required .* using 4 threads"
+    REWRITE_RUN_FAIL_REGEX "(${ROCPROFSYS_ABORT_FAIL_REGEX})")
+
+if(TARGET parallel-overhead)
+    add_test(
+        NAME parallel-overhead-analysis-threads-compare
+        COMMAND
+            ${CMAKE_COMMAND} -DINSTRUMENT_EXE=$<TARGET_FILE:rocprofiler-systems-instrument>
+            -DTARGET_EXE=$<TARGET_FILE:parallel-overhead>
+            -DOUTPUT_DIR=${PROJECT_BINARY_DIR}/rocprof-sys-tests-output/parallel-overhead-analysis-threads-compare
+            -DNUM_THREADS=4 -P ${CMAKE_CURRENT_LIST_DIR}/compare-analysis-threads.cmake
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set_tests_properties(
+        parallel-overhead-analysis-threads-compare
+        PROPERTIES ENVIRONMENT
+                   "${_base_environment};ROCPROFSYS_CI=ON;ROCPROFSYS_CI_TIMEOUT=300"
+                   TIMEOUT
+                   300
+                   LABELS
+                   "analysis-threads"
+                   PASS_REGULAR_EXPRESSION
+                   "instrumented/excluded with -j 1 and -j 4 match")
+endif()
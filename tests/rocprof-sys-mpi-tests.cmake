@@ -77,6 +77,35 @@ rocprofiler_systems_add_test(
         ">>> mpi-flat.inst(.*\n.*)>>> MPI_Init_thread(.*\n.*)>>> pthread_create(.*\n.*)>>> MPI_Comm_size(.*\n.*)>>> MPI_Comm_rank(.*\n.*)>>> MPI_Barrier(.*\n.*)>>> MPI_Alltoall"
     )
 
+# combine the traces of both ranks with a chunk size which is much smaller than the trace
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME "mpi-perfetto-combine-chunked"
+    TARGET mpi-example
+    MPI ON
+    NUM_PROCS 2
+    LABELS "perfetto"
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_PERFETTO_COMBINE_TRACES=ON;ROCPROFSYS_PERFETTO_OUTPUT_CHUNK_SIZE_KB=4"
+    SAMPLING_PASS_REGEX "Outputting.*(perfetto-trace.*\\.proto).*Done"
+    SAMPLING_FAIL_REGEX "Error (writing|opening) '.*perfetto-trace|ROCPROFSYS_ABORT_FAIL_REGEX")
+
+# same as above but the in-process buffer of each rank is spilled to a file next to the
+# output instead of a temporary file
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME "mpi-perfetto-combine-chunked-no-tmp-files"
+    TARGET mpi-example
+    MPI ON
+    NUM_PROCS 2
+    LABELS "perfetto"
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_PERFETTO_COMBINE_TRACES=ON;ROCPROFSYS_PERFETTO_OUTPUT_CHUNK_SIZE_KB=4;ROCPROFSYS_USE_TEMPORARY_FILES=OFF"
+    SAMPLING_PASS_REGEX "Outputting.*(perfetto-trace.*\\.proto).*Done"
+    SAMPLING_FAIL_REGEX
+        "Error (writing|opening) '.*perfetto-trace|failed to write perfetto trace|ROCPROFSYS_ABORT_FAIL_REGEX"
+    )
+
 set(_mpip_environment
     "ROCPROFSYS_TRACE=ON"
     "ROCPROFSYS_PROFILE=ON"
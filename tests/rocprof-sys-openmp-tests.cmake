@@ -101,6 +101,27 @@ rocprofiler_systems_add_test(
     ENVIRONMENT "${_ompt_sampling_environ}"
     SAMPLING_PASS_REGEX "${_ompt_sampling_samp_regex}(.*)${_ompt_sampling_file_regex}")
 
+set(_process_sampling_buffer_environ
+    "${_ompt_environment}"
+    "ROCPROFSYS_VERBOSE=2"
+    "ROCPROFSYS_USE_OMPT=OFF"
+    "ROCPROFSYS_USE_SAMPLING=OFF"
+    "ROCPROFSYS_USE_PROCESS_SAMPLING=ON"
+    "ROCPROFSYS_PROCESS_SAMPLING_FREQ=200"
+    "ROCPROFSYS_PROCESS_SAMPLING_BUFFER_SIZE=8"
+    "ROCPROFSYS_MONOCHROME=ON")
+
+# the process samples are flushed to perfetto every 8 samples while running
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-process-sampling-buffer
+    TARGET openmp-cg
+    LABELS "openmp;process-sampling"
+    ENVIRONMENT "${_process_sampling_buffer_environ}"
+    SAMPLING_PASS_REGEX
+        "Post-processing [1-9][0-9]+ cpu frequency and memory usage entries(.*)perfetto-trace"
+    )
+
 rocprofiler_systems_add_test(
     SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
     NAME openmp-cg-sampling-no-tmp-files
@@ -29,4 +29,43 @@ if(rocprofiler_systems_perf_event_paranoid LESS_EQUAL 3
         SAMPLING_PASS_REGEX "sampling_wall_clock.txt"
         RUNTIME_PASS_REGEX "sampling_wall_clock.txt"
         REWRITE_RUN_PASS_REGEX "sampling_wall_clock.txt")
+
+    # the ring buffers are drained by the collector thread instead of a signal
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME overflow-collector
+        TARGET parallel-overhead
+        RUN_ARGS 30 2 200
+        ENVIRONMENT
+            "${_overflow_environment};ROCPROFSYS_SAMPLING_OVERFLOW_MODE=collector"
+        LABELS "perf;overflow"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] [1-9][0-9]* overflow samples were post-processed"
+        SAMPLING_FAIL_REGEX
+            "\\\[sampling\\\] perf collector: 0 samples|ROCPROFSYS_ABORT_FAIL_REGEX")
+
+    # copies of the user stack are unwound offline after sampling stops
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME overflow-stack-unwind
+        TARGET parallel-overhead
+        RUN_ARGS 30 2 200
+        ENVIRONMENT
+            "${_overflow_environment};ROCPROFSYS_SAMPLING_OVERFLOW_MODE=collector;ROCPROFSYS_SAMPLING_OVERFLOW_STACK_SIZE=8192"
+        LABELS "perf;overflow"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] Unwound [0-9]+ of [1-9][0-9]* user stack copies offline")
+
+    # thread metrics of the timer-based samples read from a perf_event group
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME perf-sampling-metrics
+        TARGET parallel-overhead
+        RUN_ARGS 30 2 200
+        ENVIRONMENT
+            "${_base_environment};ROCPROFSYS_VERBOSE=2;ROCPROFSYS_SAMPLING_METRICS_BACKEND=perf"
+        LABELS "perf;sampling"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] perf metrics for thread [0-9]+: [1-9][0-9]* events"
+        SAMPLING_FAIL_REGEX "Falling back to getrusage|ROCPROFSYS_ABORT_FAIL_REGEX")
 endif()
@@ -32,3 +32,137 @@ rocprofiler_systems_add_test(
     REWRITE_RUN_PASS_REGEX
         "start_thread (.*) 4 (.*) pthread_mutex_lock (.*) 4000 (.*) pthread_mutex_unlock (.*) 4000"
     )
+
+# -------------------------------------------------------------------------------------- #
+#
+# sampling post-processing benchmark: reports the finalization wall-time of the serial
+# and parallel post-processing of the call-stack samples for an increasing thread count
+#
+# -------------------------------------------------------------------------------------- #
+
+foreach(_NTHREAD 4 16 64)
+    foreach(_MODE serial parallel)
+        if(_MODE STREQUAL "parallel")
+            set(_PARALLEL_POST_PROCESS ON)
+        else()
+            set(_PARALLEL_POST_PROCESS OFF)
+        endif()
+
+        rocprofiler_systems_add_test(
+            SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+            NAME parallel-overhead-post-process-${_MODE}-${_NTHREAD}
+            TARGET parallel-overhead
+            LABELS "sampling;post-process;benchmark"
+            RUN_ARGS 25 ${_NTHREAD} 1000
+            ENVIRONMENT
+                "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=500;ROCPROFSYS_SAMPLING_PARALLEL_POST_PROCESS=${_PARALLEL_POST_PROCESS}"
+            SAMPLING_PASS_REGEX
+                "Post-processing sampling data for [0-9]+ threads \\\(${_MODE}\\\) took [0-9.]+ sec"
+            )
+    endforeach()
+endforeach()
+
+# -------------------------------------------------------------------------------------- #
+#
+# sampling offload: the full sampler buffers are written to a temporary file and reloaded
+# during post-processing. The reloaded samples must precede the samples in memory and add
+# up to the number of samples recorded by the sampler
+#
+# -------------------------------------------------------------------------------------- #
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-sampling-offload
+    TARGET parallel-overhead
+    LABELS "sampling;offload"
+    RUN_ARGS 30 2 200
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_CI=ON;ROCPROFSYS_VERBOSE=1;ROCPROFSYS_USE_TEMPORARY_FILES=ON;ROCPROFSYS_SAMPLING_FREQ=2500"
+    SAMPLING_PASS_REGEX
+        "Sampler data for thread [0-9]+ has [1-9][0-9]* offloaded and [0-9]+ in-memory entries"
+    SAMPLING_FAIL_REGEX
+        "offloaded [0-9]+ samples for thread [0-9]+ but loaded|sampler recorded [0-9]+ samples but|offloaded samples of thread [0-9]+ are newer|ROCPROFSYS_ABORT_FAIL_REGEX"
+    )
+
+# -------------------------------------------------------------------------------------- #
+#
+# sampling unwinder benchmark: reports the per-sample latency of the libunwind and
+# frame-pointer unwinders in the signal handler
+#
+# -------------------------------------------------------------------------------------- #
+
+# libunwind never falls back and the frame-pointer unwinder must succeed for some samples
+foreach(_UNWINDER libunwind frame-pointer)
+    if("${_UNWINDER}" STREQUAL "libunwind")
+        set(_FALLBACKS_REGEX "0")
+    else()
+        set(_FALLBACKS_REGEX "[0-9]+")
+    endif()
+
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME parallel-overhead-unwind-${_UNWINDER}
+        TARGET parallel-overhead
+        LABELS "sampling;unwind;benchmark"
+        RUN_ARGS 25 8 1000
+        ENVIRONMENT
+            "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=500;ROCPROFSYS_SAMPLING_UNWINDER=${_UNWINDER};ROCPROFSYS_SAMPLING_UNWIND_STATS=ON"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] ${_UNWINDER} unwinder: [0-9]+ samples, [0-9.]+ usec/sample, ${_FALLBACKS_REGEX} frame-pointer fallbacks"
+        SAMPLING_FAIL_REGEX
+            "frame-pointer fallbacks \\\(100\\.0%\\\)|ROCPROFSYS_ABORT_FAIL_REGEX")
+endforeach()
+
+# the unique program counters of all the threads are symbolized once at finalization
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-symbolize
+    TARGET parallel-overhead
+    LABELS "sampling;post-process"
+    RUN_ARGS 25 16 1000
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=500;ROCPROFSYS_SAMPLING_PARALLEL_POST_PROCESS=ON"
+    SAMPLING_PASS_REGEX
+        "\\\[sampling\\\] Symbolized [0-9]+ unique program counters \\\([0-9]+ from the symbol tables of [0-9]+ binaries\\\)"
+    )
+
+# a high sampling frequency with a small overhead budget so that the controller has to
+# skip interrupts
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-overhead-target
+    TARGET parallel-overhead
+    LABELS "sampling"
+    RUN_ARGS 25 8 1000
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=5000;ROCPROFSYS_SAMPLING_OVERHEAD_TARGET=0.5"
+    SAMPLING_PASS_REGEX
+        "\\\[sampling\\\] overhead controller: sampled [0-9]+ of [1-9][0-9]* timer interrupts"
+    )
+
+# flame graph stacks and pprof profile written directly from the samples
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-sampling-profile
+    TARGET parallel-overhead
+    LABELS "sampling;post-process"
+    RUN_ARGS 25 16 1000
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_SAMPLING_FREQ=500;ROCPROFSYS_SAMPLING_OUTPUT=folded pprof"
+    SAMPLING_PASS_REGEX "sampling-timer.folded"
+    SAMPLING_FAIL_REGEX
+        "sampling_wall_clock.txt|not included in the profile|ROCPROFSYS_ABORT_FAIL_REGEX")
+
+# the samples only store the id of the leaf of the per-thread call-stack tree
+if(ROCPROFSYS_SAMPLING_COMPACT_STACKS)
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME parallel-overhead-compact-stacks
+        TARGET parallel-overhead
+        LABELS "sampling;compact-stacks"
+        RUN_ARGS 25 8 1000
+        ENVIRONMENT
+            "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=500"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] call-stack trees: [1-9][0-9]* nodes, [0-9.]+ MB")
+endif()
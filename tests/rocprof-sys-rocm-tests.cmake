@@ -61,6 +61,31 @@ rocprofiler_systems_add_test(
     ENVIRONMENT "${_base_environment}"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure transpose")
 
+# per-sample latency of the libunwind and frame-pointer unwinders
+# libunwind never falls back and the frame-pointer unwinder must succeed for some samples
+foreach(_UNWINDER libunwind frame-pointer)
+    if("${_UNWINDER}" STREQUAL "libunwind")
+        set(_FALLBACKS_REGEX "0")
+    else()
+        set(_FALLBACKS_REGEX "[0-9]+")
+    endif()
+
+    rocprofiler_systems_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME transpose-unwind-${_UNWINDER}
+        TARGET transpose
+        LABELS "sampling;unwind;benchmark"
+        MPI OFF
+        GPU ON
+        NUM_PROCS 1
+        ENVIRONMENT
+            "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_FREQ=500;ROCPROFSYS_SAMPLING_UNWINDER=${_UNWINDER};ROCPROFSYS_SAMPLING_UNWIND_STATS=ON"
+        SAMPLING_PASS_REGEX
+            "\\\[sampling\\\] ${_UNWINDER} unwinder: [0-9]+ samples, [0-9.]+ usec/sample, ${_FALLBACKS_REGEX} frame-pointer fallbacks"
+        SAMPLING_FAIL_REGEX
+            "frame-pointer fallbacks \\\(100\\.0%\\\)|ROCPROFSYS_ABORT_FAIL_REGEX")
+endforeach()
+
 if(ROCPROFSYS_USE_ROCM)
     set(_ROCP_PASS_REGEX
         "rocprof-device-0-GRBM_COUNT.txt(.*)rocprof-device-0-SQ_INSTS_VALU.txt(.*)rocprof-device-0-SQ_WAVES.txt(.*)rocprof-device-0-TA_TA_BUSY.txt(.*)"
@@ -29,3 +29,13 @@ rocprofiler_systems_add_test(
     SAMPLING_PASS_REGEX "Pushing custom region :: run.10. x 1000"
     BASELINE_FAIL_REGEX "Pushing custom region"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
+
+# compares string-based user regions against pre-registered region handles
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME user-api-overhead
+    TARGET user-api-overhead
+    LABELS "benchmark"
+    RUN_ARGS 200000
+    ENVIRONMENT "${_base_environment}"
+    SAMPLING_PASS_REGEX "\\[user-api-overhead\\] speedup: [0-9.]+x")
@@ -0,0 +1,103 @@
+#include "binary/address_multirange.hpp"
+#include "core/binary/address_range.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// compares the set-based lookup of binary::address_multirange::contains against the
+// sorted flat-array lookup built by address_multirange::freeze(), i.e. the check
+// performed for every frame of every sample in causal mode
+
+using rocprofsys::binary::address_multirange;
+using rocprofsys::binary::address_range;
+using clock_type = std::chrono::steady_clock;
+
+template <typename FuncT>
+double
+run(FuncT&& _func, size_t& _hits)
+{
+    auto _beg = clock_type::now();
+    _hits     = _func();
+    return std::chrono::duration<double, std::nano>{ clock_type::now() - _beg }.count();
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nranges  = 20000;
+    size_t nqueries = 1000000;
+    if(argc > 1) nranges = atol(argv[1]);
+    if(argc > 2) nqueries = atol(argv[2]);
+
+    auto _engine = std::mt19937_64{ 42 };
+    auto _ranges = address_multirange{};
+
+    // mimic the layout of symbols in a binary: mostly ranges of varying sizes with gaps
+    // and the occasional single address (breakpoint)
+    uintptr_t _addr = 0x400000;
+    for(size_t i = 0; i < nranges; ++i)
+    {
+        _addr += 16 + (_engine() % 64);
+        if(i % 8 == 0)
+        {
+            _ranges += _addr;
+        }
+        else
+        {
+            auto _size = 8 + (_engine() % 256);
+            _ranges += address_range{ _addr, _addr + _size };
+            _addr += _size;
+        }
+    }
+
+    auto _lo      = _ranges.get_coarse_range().low;
+    auto _hi      = _ranges.get_coarse_range().high;
+    auto _queries = std::vector<uintptr_t>{};
+    _queries.reserve(nqueries);
+    for(size_t i = 0; i < nqueries; ++i)
+        _queries.emplace_back(_lo + (_engine() % (_hi - _lo)));
+
+    auto _flat = _ranges;
+    _flat.freeze();
+
+    auto _lookup = [&_queries](const address_multirange& _v) {
+        return [&_queries, &_v]() {
+            size_t _n = 0;
+            for(auto itr : _queries)
+                _n += (_v.contains(itr)) ? 1 : 0;
+            return _n;
+        };
+    };
+
+    size_t _set_hits  = 0;
+    size_t _flat_hits = 0;
+    auto   _set_ns    = run(_lookup(_ranges), _set_hits);
+    auto   _flat_ns   = run(_lookup(_flat), _flat_hits);
+
+    printf("[%s] ranges: %zu, queries: %zu, hits: %zu\n", _name.c_str(), _ranges.size(),
+           _queries.size(), _flat_hits);
+    printf("[%s] set-based: %.2f nsec/lookup\n", _name.c_str(),
+           _set_ns / _queries.size());
+    printf("[%s] flat-array: %.2f nsec/lookup\n", _name.c_str(),
+           _flat_ns / _queries.size());
+    printf("[%s] speedup: %.2fx\n", _name.c_str(), _set_ns / _flat_ns);
+
+    if(_set_hits != _flat_hits)
+    {
+        fprintf(stderr, "[%s] mismatch: set-based hits = %zu, flat-array hits = %zu\n",
+                _name.c_str(), _set_hits, _flat_hits);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
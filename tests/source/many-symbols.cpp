@@ -0,0 +1,59 @@
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+// generates a synthetic ELF with NUM_SYMBOLS distinct functions (each with its own
+// symbol, address range and DWARF line rows) for benchmarking the binary analysis
+// performed at startup of causal profiling
+
+#if !defined(NUM_SYMBOLS)
+#    define NUM_SYMBOLS 8192
+#endif
+
+template <size_t N>
+__attribute__((noinline)) size_t
+func(size_t _v)
+{
+    // NOLINTNEXTLINE
+    for(size_t i = 0; i < (N % 7) + 1; ++i)
+        _v = (_v * 31) + N + i;
+    return _v;
+}
+
+using func_t = size_t (*)(size_t);
+
+template <size_t... Idx>
+constexpr auto
+get_funcs(std::index_sequence<Idx...>)
+{
+    return std::array<func_t, sizeof...(Idx)>{ &func<Idx>... };
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nitr = 1000;
+    if(argc > 1) nitr = atol(argv[1]);
+
+    static const auto _funcs = get_funcs(std::make_index_sequence<NUM_SYMBOLS>{});
+
+    printf("[%s] symbols: %zu, iterations: %zu\n", _name.c_str(), _funcs.size(), nitr);
+
+    size_t _v = 0;
+    for(size_t i = 0; i < nitr; ++i)
+    {
+        for(const auto& itr : _funcs)
+            _v = itr(_v);
+    }
+
+    printf("[%s] result: %zu\n", _name.c_str(), _v);
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "core/perfetto_merge.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// measures the throughput of the native merge of per-process perfetto traces against a
+// serial read-everything-then-write merge (what `cat *.proto > merged.proto` does) and
+// validates that both produce the same output
+
+using clock_type = std::chrono::steady_clock;
+
+namespace
+{
+std::vector<char>
+read_file(const std::string& _fname)
+{
+    auto _ifs = std::ifstream{ _fname, std::ios::binary };
+    return std::vector<char>{ std::istreambuf_iterator<char>{ _ifs },
+                              std::istreambuf_iterator<char>{} };
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nfiles   = 64;
+    size_t nkb      = 1024;
+    size_t nthreads = 0;
+    if(argc > 1) nfiles = atol(argv[1]);
+    if(argc > 2) nkb = atol(argv[2]);
+    if(argc > 3) nthreads = atol(argv[3]);
+
+    char _tmpl[] = "/tmp/rocprofsys-merge-bench-XXXXXX";
+    auto _dir    = std::string{ ::mkdtemp(_tmpl) ? _tmpl : "" };
+    if(_dir.empty())
+    {
+        fprintf(stderr, "[%s] failed to create a temporary directory\n", _name.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // per-process traces of slightly varying sizes
+    auto _engine = std::mt19937_64{ 42 };
+    for(size_t i = 0; i < nfiles; ++i)
+    {
+        auto _data = std::vector<uint64_t>((nkb * 1024 + (_engine() % 4096)) / 8);
+        for(auto& itr : _data)
+            itr = _engine();
+        auto _fname = _dir + "/perfetto-trace-" + std::to_string(i) + ".proto";
+        auto _ofs   = std::ofstream{ _fname, std::ios::binary };
+        _ofs.write(reinterpret_cast<const char*>(_data.data()),
+                   _data.size() * sizeof(uint64_t));
+    }
+
+    auto _inputs = rocprofsys::perfetto::get_merge_inputs(_dir);
+
+    auto _serial_beg = clock_type::now();
+    {
+        auto _ofs = std::ofstream{ _dir + "/serial.out", std::ios::binary };
+        for(const auto& itr : _inputs)
+        {
+            auto _data = read_file(itr);
+            _ofs.write(_data.data(), _data.size());
+        }
+    }
+    auto _serial_sec =
+        std::chrono::duration<double>{ clock_type::now() - _serial_beg }.count();
+
+    auto _result = rocprofsys::perfetto::merge_directory(_dir, nthreads);
+    auto _equal  = _result.success &&
+                  read_file(_dir + "/serial.out") == read_file(_result.output);
+
+    auto _mb = static_cast<double>(_result.bytes) / (1024.0 * 1024.0);
+    printf("[%s] files: %zu, size: %.2f MB\n", _name.c_str(), _result.inputs.size(),
+           _mb);
+    printf("[%s] serial: %.3f sec (%.2f MB/s)\n", _name.c_str(), _serial_sec,
+           _mb / _serial_sec);
+    printf("[%s] native: %.3f sec (%.2f MB/s)\n", _name.c_str(), _result.seconds,
+           _mb / _result.seconds);
+
+    for(const auto& itr : _inputs)
+        ::unlink(itr.c_str());
+    ::unlink((_dir + "/serial.out").c_str());
+    if(!_result.output.empty()) ::unlink(_result.output.c_str());
+    ::rmdir(_dir.c_str());
+
+    if(_result.inputs.size() != nfiles || !_equal)
+    {
+        fprintf(stderr, "[%s] merged output does not match the serial merge\n",
+                _name.c_str());
+        return EXIT_FAILURE;
+    }
+
+    printf("[%s] throughput: %.2f MB/s\n", _name.c_str(), _mb / _result.seconds);
+    return EXIT_SUCCESS;
+}
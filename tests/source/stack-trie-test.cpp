@@ -0,0 +1,149 @@
+#include "core/containers/stack_trie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// validates the insertion, the expansion, and the growth of the chunks of the call-stack
+// tree used by the sampler when built with ROCPROFSYS_SAMPLING_COMPACT_STACKS=ON. The
+// chunks are deliberately small so that the test crosses several chunk boundaries and
+// fills the tree
+
+namespace container = rocprofsys::container;
+
+namespace
+{
+constexpr size_t chunk_size = 16;
+constexpr size_t max_chunks = 4;
+
+using trie_type  = container::stack_trie<uintptr_t, chunk_size, max_chunks>;
+using stack_type = std::vector<uintptr_t>;
+
+std::string _name   = {};
+int         _errors = 0;
+
+void
+check(bool _cond, const char* _msg, size_t _line)
+{
+    if(_cond) return;
+    fprintf(stderr, "[%s] line %zu: check failed: %s\n", _name.c_str(), _line, _msg);
+    ++_errors;
+}
+
+#define STACK_TRIE_CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+stack_type
+expand(const trie_type& _trie, trie_type::id_type _id)
+{
+    auto _stack = stack_type{};
+    _stack.reserve(chunk_size * max_chunks);
+    _trie.expand(_id, _stack);
+    return _stack;
+}
+
+size_t
+expected_memory(size_t _size)
+{
+    // node zero is the implicit root so the ids of the nodes are 1 ... size
+    return ((_size / chunk_size) + 1) * chunk_size * sizeof(trie_type::node);
+}
+}  // namespace
+
+int
+main(int, char** argv)
+{
+    _name     = argv[0];
+    auto _pos = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    auto _trie = trie_type{};
+
+    // the empty call-stack is the root
+    STACK_TRIE_CHECK(_trie.insert(stack_type{}) == trie_type::npos);
+    STACK_TRIE_CHECK(_trie.size() == 0 && _trie.memory() == 0);
+    STACK_TRIE_CHECK(expand(_trie, trie_type::npos).empty());
+
+    // the innermost frame is first, i.e. main (1) -> foo (2) -> bar (3)
+    auto _a   = stack_type{ 3, 2, 1 };
+    auto _aid = _trie.insert(_a);
+    STACK_TRIE_CHECK(_aid != trie_type::npos);
+    STACK_TRIE_CHECK(_trie.size() == 3 && _trie.depth(_aid) == 3);
+    STACK_TRIE_CHECK(expand(_trie, _aid) == _a);
+
+    // the same call-stack maps to the same id and does not add nodes
+    STACK_TRIE_CHECK(_trie.insert(_a) == _aid && _trie.size() == 3);
+
+    // a sibling leaf shares the main -> foo prefix
+    auto _b   = stack_type{ 4, 2, 1 };
+    auto _bid = _trie.insert(_b);
+    STACK_TRIE_CHECK(_bid != trie_type::npos && _bid != _aid);
+    STACK_TRIE_CHECK(_trie.size() == 4 && _trie.depth(_bid) == 3);
+    STACK_TRIE_CHECK(expand(_trie, _bid) == _b);
+
+    // a prefix of an existing call-stack is an existing (interior) node
+    auto _cid = _trie.insert(stack_type{ 2, 1 });
+    STACK_TRIE_CHECK(_cid != trie_type::npos && _trie.size() == 4);
+    STACK_TRIE_CHECK(expand(_trie, _cid) == (stack_type{ 2, 1 }));
+
+    // the lookup of the first leaf moves it to the front of the sibling list
+    STACK_TRIE_CHECK(_trie.insert(_a) == _aid && _trie.insert(_b) == _bid);
+    STACK_TRIE_CHECK(expand(_trie, _aid) == _a && expand(_trie, _bid) == _b);
+
+    // grow the tree across the chunk boundaries with unique leaves under main -> foo
+    auto _ids = std::vector<std::pair<trie_type::id_type, stack_type>>{};
+    _ids.emplace_back(_aid, _a);
+    _ids.emplace_back(_bid, _b);
+    for(uintptr_t i = 0; i < 2 * chunk_size; ++i)
+    {
+        auto _stack = stack_type{ 100 + i, 2, 1 };
+        auto _id    = _trie.insert(_stack);
+        STACK_TRIE_CHECK(_id != trie_type::npos);
+        _ids.emplace_back(_id, _stack);
+    }
+
+    STACK_TRIE_CHECK(_trie.size() == 4 + 2 * chunk_size);
+    STACK_TRIE_CHECK(_trie.memory() == expected_memory(_trie.size()));
+    STACK_TRIE_CHECK(_trie.dropped() == 0);
+
+    // the ids in the earlier chunks are not invalidated by the growth
+    for(const auto& itr : _ids)
+    {
+        STACK_TRIE_CHECK(expand(_trie, itr.first) == itr.second);
+        STACK_TRIE_CHECK(_trie.insert(itr.second) == itr.first);
+    }
+
+    // fill the tree: the insertions which do not fit are dropped
+    auto _capacity = chunk_size * max_chunks - 1;
+    for(uintptr_t i = 0; _trie.size() < _capacity; ++i)
+        STACK_TRIE_CHECK(_trie.insert(stack_type{ 1000 + i, 2, 1 }) != trie_type::npos);
+
+    STACK_TRIE_CHECK(_trie.size() == _capacity);
+    STACK_TRIE_CHECK(_trie.memory() == max_chunks * chunk_size * sizeof(trie_type::node));
+    STACK_TRIE_CHECK(_trie.insert(stack_type{ 5, 2, 1 }) == trie_type::npos);
+    STACK_TRIE_CHECK(_trie.dropped() == 1 && _trie.size() == _capacity);
+
+    // existing call-stacks are still found when the tree is full
+    STACK_TRIE_CHECK(_trie.insert(_a) == _aid && _trie.dropped() == 1);
+
+    // the expansion is truncated to the capacity of the container
+    auto _truncated = stack_type{};
+    _truncated.reserve(2);
+    STACK_TRIE_CHECK(_trie.expand(_aid, _truncated) == 2);
+    STACK_TRIE_CHECK(_truncated == (stack_type{ 3, 2 }));
+
+    printf("[%s] nodes: %zu, memory: %zu bytes, dropped: %zu\n", _name.c_str(),
+           _trie.size(), _trie.memory(), _trie.dropped());
+
+    if(_errors > 0)
+    {
+        fprintf(stderr, "[%s] %i checks failed\n", _name.c_str(), _errors);
+        return EXIT_FAILURE;
+    }
+
+    printf("[%s] all checks passed\n", _name.c_str());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "core/timestamp.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// measures the cost of the timestamps of a push/pop pair (the region stack of
+// tracing::push_perfetto/pop_perfetto) with clock_gettime(CLOCK_REALTIME) and with the
+// calibrated TSC clock, and validates that the TSC clock agrees with CLOCK_REALTIME
+
+namespace timestamp = rocprofsys::timestamp;
+using clock_type    = std::chrono::steady_clock;
+
+namespace
+{
+template <typename FuncT>
+double
+push_pop(FuncT&& _now, size_t _nregions, size_t _depth, uint64_t& _total)
+{
+    auto _stack = std::vector<std::pair<size_t, uint64_t>>{};
+    _stack.reserve(_depth);
+
+    auto _beg = clock_type::now();
+    for(size_t i = 0; i < _nregions; i += _depth)
+    {
+        for(size_t j = 0; j < _depth; ++j)
+            _stack.emplace_back(j, _now());
+        while(!_stack.empty())
+        {
+            _total += _now() - _stack.back().second;
+            _stack.pop_back();
+        }
+    }
+    return std::chrono::duration<double, std::nano>{ clock_type::now() - _beg }.count();
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nregions = 10000000;
+    size_t depth    = 8;
+    if(argc > 1) nregions = atol(argv[1]);
+    if(argc > 2) depth = atol(argv[2]);
+    if(depth == 0) depth = 1;
+
+    uint64_t _realtime_total = 0;
+    auto     _realtime_ns =
+        push_pop([]() { return timestamp::realtime_now(); }, nregions, depth,
+                 _realtime_total);
+
+    printf("[%s] regions: %zu, depth: %zu\n", _name.c_str(), nregions, depth);
+    printf("[%s] realtime: %.2f nsec/push-pop\n", _name.c_str(),
+           _realtime_ns / nregions);
+
+    if(timestamp::set_clock_source(timestamp::clock_source::tsc) !=
+       timestamp::clock_source::tsc)
+    {
+        printf("[%s] tsc: unavailable (the cycle counter is not invariant)\n",
+               _name.c_str());
+        return EXIT_SUCCESS;
+    }
+
+    uint64_t _tsc_total = 0;
+    auto     _tsc_ns =
+        push_pop([]() { return timestamp::now(); }, nregions, depth, _tsc_total);
+
+    printf("[%s] tsc: %.2f nsec/push-pop (%.3f MHz)\n", _name.c_str(),
+           _tsc_ns / nregions, timestamp::get_counter_frequency() / 1.0e6);
+    printf("[%s] speedup: %.2fx\n", _name.c_str(), _realtime_ns / _tsc_ns);
+
+    // the drift correction keeps the TSC clock within a few microseconds of
+    // CLOCK_REALTIME, allow for preemption between the two reads
+    constexpr int64_t max_error = 1000000;
+    auto              _error    = static_cast<int64_t>(timestamp::now()) -
+                      static_cast<int64_t>(timestamp::realtime_now());
+    if(std::abs(_error) > max_error)
+    {
+        fprintf(stderr, "[%s] tsc clock differs from CLOCK_REALTIME by %lli nsec\n",
+                _name.c_str(), static_cast<long long>(_error));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}